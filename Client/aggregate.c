@@ -0,0 +1,560 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "functions.h"
+#include "database.h"
+
+// COUNT/SUM/MIN/MAX/AVG over the rows a WHERE clause selects, optionally grouped. Rows are
+// taken a block at a time: the group columns are hashed into a vector, each row is placed in
+// its group through an open-addressing table, and then every aggregate runs one tight loop
+// over its column. Large inputs are split into morsels; each worker fills its own group
+// table and the partial results are merged at the end.
+
+#define MAX_AGGREGATES      16
+#define MAX_GROUP_COLUMNS   8
+#define GROUP_FIRST_SLOTS   64
+#define GROUP_NO_GROUP      SIZE_MAX
+
+typedef enum {
+    AGG_COUNT, AGG_SUM, AGG_MIN, AGG_MAX, AGG_AVG
+} AggregateKind;
+
+typedef struct {
+    AggregateKind Kind;
+    int Column;         // -1 for COUNT(*)
+    char Label[80];
+} Aggregate;
+
+// Running totals of one aggregate in one group. INT and UINT values are summed exactly;
+// every type's min/max fits a double exactly.
+typedef struct {
+    int64_t IntSum;
+    double FloatSum;
+    double Min;
+    double Max;
+} Accumulator;
+
+typedef struct {
+    size_t Row;         // first row of the group, for its key and the output order
+    uint64_t Hash;
+    uint64_t Count;
+} Group;
+
+typedef struct {
+    uint64_t Hash;
+    size_t Group;
+} GroupSlot;
+
+typedef struct {
+    GroupSlot *Slots;
+    size_t SlotCount;
+    Group *Groups;
+    Accumulator *Accs;  // GroupCount x AggregateCount
+    size_t GroupCount;
+    size_t GroupCapacity;
+    bool Failed;
+
+    // Block scratch
+    size_t Ids[SCAN_BLOCK_ROWS];
+    uint64_t Hashes[SCAN_BLOCK_ROWS];
+    size_t GroupIds[SCAN_BLOCK_ROWS];
+} GroupTable;
+
+typedef struct {
+    const Table *Table;
+    Aggregate Aggregates[MAX_AGGREGATES];
+    size_t AggregateCount;
+    size_t GroupColumns[MAX_GROUP_COLUMNS];
+    size_t GroupColumnCount;
+
+    const size_t *Rows;  // rows to aggregate, or NULL for every live row
+    size_t ItemCount;
+    GroupTable **Workers;
+} AggregateJob;
+
+static bool IsNumeric(DataTypes type) {
+    return type == DT_INT || type == DT_UINT || type == DT_FLOAT;
+}
+
+static bool SameWord(const char *a, size_t len, const char *word) {
+    if (strlen(word) != len) return false;
+    for (size_t i = 0; i < len; ++i) {
+        if (toupper((unsigned char)a[i]) != word[i]) return false;
+    }
+    return true;
+}
+
+// aggregates := call (',' call)*    call := COUNT(*) | NAME(column)
+static bool ParseAggregates(AggregateJob *job, const char *text) {
+    static const char *Names[] = {"COUNT", "SUM", "MIN", "MAX", "AVG"};
+    const char *p = text;
+
+    for (;;) {
+        while (isspace((unsigned char)*p)) p++;
+        const char *name = p;
+        while (isalpha((unsigned char)*p)) p++;
+        size_t nameLen = (size_t)(p - name);
+        while (isspace((unsigned char)*p)) p++;
+        if (nameLen == 0 || *p != '(') {
+            printf("Invalid aggregate near '%s': expected e.g. COUNT(*) or SUM(column).\n", name);
+            return false;
+        }
+
+        const char *arg = ++p;
+        while (*p && *p != ')') p++;
+        if (*p != ')') {
+            printf("Invalid aggregate: missing ')' after '%.*s'.\n", (int)nameLen, name);
+            return false;
+        }
+        const char *argEnd = p++;
+        while (arg < argEnd && isspace((unsigned char)*arg)) arg++;
+        while (argEnd > arg && isspace((unsigned char)argEnd[-1])) argEnd--;
+
+        if (job->AggregateCount == MAX_AGGREGATES) {
+            printf("At most %d aggregates per query.\n", MAX_AGGREGATES);
+            return false;
+        }
+        Aggregate *agg = &job->Aggregates[job->AggregateCount];
+        size_t kind = 0;
+        while (kind < sizeof(Names) / sizeof(Names[0]) && !SameWord(name, nameLen, Names[kind])) kind++;
+        if (kind == sizeof(Names) / sizeof(Names[0])) {
+            printf("Unknown aggregate '%.*s'; use COUNT, SUM, MIN, MAX or AVG.\n", (int)nameLen, name);
+            return false;
+        }
+        agg->Kind = (AggregateKind)kind;
+
+        char column[64];
+        snprintf(column, sizeof(column), "%.*s", (int)(argEnd - arg), arg);
+        if (agg->Kind == AGG_COUNT && strcmp(column, "*") == 0) {
+            agg->Column = -1;
+        } else {
+            agg->Column = FindColumn(job->Table, column);
+            if (agg->Column == -1) {
+                printf("Column '%s' not found in table '%s'.\n", column, job->Table->TableName);
+                return false;
+            }
+            if (agg->Kind != AGG_COUNT && !IsNumeric(job->Table->Attributes[agg->Column].AttributeType)) {
+                printf("%s needs an INT, UINT or FLOAT column; '%s' is a STRING.\n", Names[kind], column);
+                return false;
+            }
+        }
+        snprintf(agg->Label, sizeof(agg->Label), "%s(%s)", Names[kind], column);
+        job->AggregateCount++;
+
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0') return true;
+        if (*p != ',') {
+            printf("Invalid aggregate list: expected ',' near '%s'.\n", p);
+            return false;
+        }
+        p++;
+    }
+}
+
+// Column names separated by commas and/or spaces.
+static bool ParseGroupColumns(AggregateJob *job, const char *text) {
+    const char *p = text;
+    for (;;) {
+        while (isspace((unsigned char)*p) || *p == ',') p++;
+        if (*p == '\0') return true;
+
+        const char *name = p;
+        while (*p && !isspace((unsigned char)*p) && *p != ',') p++;
+        char column[64];
+        snprintf(column, sizeof(column), "%.*s", (int)(p - name), name);
+
+        int col = FindColumn(job->Table, column);
+        if (col == -1) {
+            printf("Column '%s' not found in table '%s'.\n", column, job->Table->TableName);
+            return false;
+        }
+        if (job->GroupColumnCount == MAX_GROUP_COLUMNS) {
+            printf("At most %d GROUP BY columns per query.\n", MAX_GROUP_COLUMNS);
+            return false;
+        }
+        job->GroupColumns[job->GroupColumnCount++] = (size_t)col;
+    }
+}
+
+static uint64_t MixBits(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static uint64_t HashText(const char *str) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char *)str; *p; ++p) {
+        h ^= *p;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Folds one group column into the block's hash vector. Numeric cells and interned codes are
+// hashed by value, other strings by their text.
+static void HashGroupColumn(const Table *table, size_t col, const size_t *ids, size_t count, uint64_t *hashes) {
+    const Column *column = &table->Columns[col];
+    if (table->Attributes[col].AttributeType == DT_STRING && !column->Dict) {
+        const StringRef *refs = column->Values;
+        for (size_t i = 0; i < count; ++i) {
+            hashes[i] = MixBits(hashes[i] ^ HashText(ArenaString(&table->Strings, refs[ids[i]])));
+        }
+        return;
+    }
+
+    const uint32_t *values = column->Values;
+    for (size_t i = 0; i < count; ++i) hashes[i] = MixBits(hashes[i] ^ values[ids[i]]);
+}
+
+static bool SameGroupKey(const AggregateJob *job, size_t a, size_t b) {
+    const Table *table = job->Table;
+    for (size_t k = 0; k < job->GroupColumnCount; ++k) {
+        size_t col = job->GroupColumns[k];
+        const Column *column = &table->Columns[col];
+        if (table->Attributes[col].AttributeType == DT_STRING && !column->Dict) {
+            const StringRef *refs = column->Values;
+            if (refs[a] != refs[b] &&
+                strcmp(ArenaString(&table->Strings, refs[a]), ArenaString(&table->Strings, refs[b])) != 0) {
+                return false;
+            }
+        } else if (((const uint32_t *)column->Values)[a] != ((const uint32_t *)column->Values)[b]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void ResetAccumulators(Accumulator *accs, size_t count) {
+    for (size_t a = 0; a < count; ++a) {
+        accs[a].IntSum = 0;
+        accs[a].FloatSum = 0;
+        accs[a].Min = INFINITY;
+        accs[a].Max = -INFINITY;
+    }
+}
+
+static bool GrowSlots(GroupTable *groups) {
+    size_t slotCount = groups->SlotCount ? groups->SlotCount * 2 : GROUP_FIRST_SLOTS;
+    GroupSlot *slots = malloc(sizeof(GroupSlot) * slotCount);
+    if (!slots) return false;
+    for (size_t s = 0; s < slotCount; ++s) slots[s].Group = GROUP_NO_GROUP;
+
+    for (size_t g = 0; g < groups->GroupCount; ++g) {
+        size_t s = (size_t)groups->Groups[g].Hash & (slotCount - 1);
+        while (slots[s].Group != GROUP_NO_GROUP) s = (s + 1) & (slotCount - 1);
+        slots[s].Hash = groups->Groups[g].Hash;
+        slots[s].Group = g;
+    }
+    free(groups->Slots);
+    groups->Slots = slots;
+    groups->SlotCount = slotCount;
+    return true;
+}
+
+static size_t AddGroup(GroupTable *groups, size_t aggregates, size_t row, uint64_t hash) {
+    if (groups->GroupCount == groups->GroupCapacity) {
+        size_t capacity = groups->GroupCapacity ? groups->GroupCapacity * 2 : GROUP_FIRST_SLOTS;
+        Group *grown = realloc(groups->Groups, sizeof(Group) * capacity);
+        if (!grown) return GROUP_NO_GROUP;
+        groups->Groups = grown;
+        Accumulator *accs = realloc(groups->Accs, sizeof(Accumulator) * capacity * (aggregates ? aggregates : 1));
+        if (!accs) return GROUP_NO_GROUP;
+        groups->Accs = accs;
+        groups->GroupCapacity = capacity;
+    }
+
+    size_t g = groups->GroupCount++;
+    groups->Groups[g].Row = row;
+    groups->Groups[g].Hash = hash;
+    groups->Groups[g].Count = 0;
+    ResetAccumulators(&groups->Accs[g * aggregates], aggregates);
+    return g;
+}
+
+// Returns the group of the row whose key hashes to hash, creating it if it is new. Slots
+// are kept at most half full.
+static size_t FindGroup(const AggregateJob *job, GroupTable *groups, size_t row, uint64_t hash) {
+    if ((groups->GroupCount + 1) * 2 > groups->SlotCount && !GrowSlots(groups)) return GROUP_NO_GROUP;
+
+    size_t mask = groups->SlotCount - 1;
+    size_t s = (size_t)hash & mask;
+    for (; groups->Slots[s].Group != GROUP_NO_GROUP; s = (s + 1) & mask) {
+        GroupSlot *slot = &groups->Slots[s];
+        if (slot->Hash == hash && SameGroupKey(job, groups->Groups[slot->Group].Row, row)) {
+            Group *group = &groups->Groups[slot->Group];
+            if (row < group->Row) group->Row = row;
+            return slot->Group;
+        }
+    }
+
+    size_t g = AddGroup(groups, job->AggregateCount, row, hash);
+    if (g == GROUP_NO_GROUP) return g;
+    groups->Slots[s].Hash = hash;
+    groups->Slots[s].Group = g;
+    return g;
+}
+
+// Runs one aggregate over a block: a loop per (kind, type) so each is a straight pass over
+// the column.
+#define ACCUMULATE(ctype, update)                                                           \
+    do {                                                                                    \
+        const ctype *values = table->Columns[agg->Column].Values;                          \
+        for (size_t i = 0; i < count; ++i) {                                               \
+            Accumulator *acc = &accs[gids[i] * stride + a];                                \
+            ctype value = values[ids[i]];                                                  \
+            update;                                                                        \
+        }                                                                                  \
+    } while (0)
+
+static void AccumulateBlock(const AggregateJob *job, GroupTable *groups, const size_t *ids, size_t count) {
+    const Table *table = job->Table;
+    const size_t *gids = groups->GroupIds;
+    Accumulator *accs = groups->Accs;
+    size_t stride = job->AggregateCount;
+
+    for (size_t a = 0; a < job->AggregateCount; ++a) {
+        const Aggregate *agg = &job->Aggregates[a];
+        if (agg->Kind == AGG_COUNT) continue;
+
+        switch (table->Attributes[agg->Column].AttributeType) {
+            case DT_INT:
+                if (agg->Kind == AGG_SUM || agg->Kind == AGG_AVG) ACCUMULATE(int, acc->IntSum += value);
+                else if (agg->Kind == AGG_MIN) ACCUMULATE(int, if (value < acc->Min) acc->Min = value);
+                else ACCUMULATE(int, if (value > acc->Max) acc->Max = value);
+                break;
+            case DT_UINT:
+                if (agg->Kind == AGG_SUM || agg->Kind == AGG_AVG) ACCUMULATE(unsigned int, acc->IntSum += value);
+                else if (agg->Kind == AGG_MIN) ACCUMULATE(unsigned int, if (value < acc->Min) acc->Min = value);
+                else ACCUMULATE(unsigned int, if (value > acc->Max) acc->Max = value);
+                break;
+            case DT_FLOAT:
+                if (agg->Kind == AGG_SUM || agg->Kind == AGG_AVG) ACCUMULATE(float, acc->FloatSum += value);
+                else if (agg->Kind == AGG_MIN) ACCUMULATE(float, if (value < acc->Min) acc->Min = value);
+                else ACCUMULATE(float, if (value > acc->Max) acc->Max = value);
+                break;
+            case DT_STRING:
+                break;
+        }
+    }
+}
+
+static void AggregateBlock(const AggregateJob *job, GroupTable *groups, const size_t *ids, size_t count) {
+    if (job->GroupColumnCount == 0) {
+        if (groups->GroupCount == 0 && AddGroup(groups, job->AggregateCount, ids[0], 0) == GROUP_NO_GROUP) {
+            groups->Failed = true;
+            return;
+        }
+        memset(groups->GroupIds, 0, sizeof(size_t) * count);
+    } else {
+        memset(groups->Hashes, 0, sizeof(uint64_t) * count);
+        for (size_t k = 0; k < job->GroupColumnCount; ++k) {
+            HashGroupColumn(job->Table, job->GroupColumns[k], ids, count, groups->Hashes);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            groups->GroupIds[i] = FindGroup(job, groups, ids[i], groups->Hashes[i]);
+            if (groups->GroupIds[i] == GROUP_NO_GROUP) {
+                groups->Failed = true;
+                return;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) groups->Groups[groups->GroupIds[i]].Count++;
+    AccumulateBlock(job, groups, ids, count);
+}
+
+static void AggregateMorsel(void *context, size_t worker, size_t morsel) {
+    AggregateJob *job = context;
+    GroupTable *groups = job->Workers[worker];
+    if (groups->Failed) return;
+
+    size_t begin = morsel * MORSEL_ROWS;
+    size_t end = begin + MORSEL_ROWS < job->ItemCount ? begin + MORSEL_ROWS : job->ItemCount;
+
+    for (size_t block = begin; block < end && !groups->Failed; block += SCAN_BLOCK_ROWS) {
+        size_t blockEnd = block + SCAN_BLOCK_ROWS < end ? block + SCAN_BLOCK_ROWS : end;
+        if (job->Rows) {
+            AggregateBlock(job, groups, job->Rows + block, blockEnd - block);
+            continue;
+        }
+
+        size_t count = 0;
+        for (size_t row = block; row < blockEnd; ++row) {
+            groups->Ids[count] = row;
+            count += !IsRowDeleted(job->Table, row);
+        }
+        if (count > 0) AggregateBlock(job, groups, groups->Ids, count);
+    }
+}
+
+static void MergeAccumulators(Accumulator *into, const Accumulator *from, size_t count) {
+    for (size_t a = 0; a < count; ++a) {
+        into[a].IntSum += from[a].IntSum;
+        into[a].FloatSum += from[a].FloatSum;
+        if (from[a].Min < into[a].Min) into[a].Min = from[a].Min;
+        if (from[a].Max > into[a].Max) into[a].Max = from[a].Max;
+    }
+}
+
+// Folds worker w's partial groups into worker 0's table.
+static bool MergeWorker(AggregateJob *job, GroupTable *from) {
+    GroupTable *into = job->Workers[0];
+    size_t stride = job->AggregateCount;
+
+    for (size_t g = 0; g < from->GroupCount; ++g) {
+        const Group *group = &from->Groups[g];
+        size_t target;
+        if (job->GroupColumnCount == 0) {
+            target = into->GroupCount ? 0 : AddGroup(into, stride, group->Row, 0);
+        } else {
+            target = FindGroup(job, into, group->Row, group->Hash);
+        }
+        if (target == GROUP_NO_GROUP) return false;
+
+        Group *merged = &into->Groups[target];
+        if (group->Row < merged->Row) merged->Row = group->Row;
+        merged->Count += group->Count;
+        MergeAccumulators(&into->Accs[target * stride], &from->Accs[g * stride], stride);
+    }
+    return true;
+}
+
+static void FreeGroupTable(GroupTable *groups) {
+    if (!groups) return;
+    free(groups->Slots);
+    free(groups->Groups);
+    free(groups->Accs);
+    free(groups);
+}
+
+static int CompareGroupRows(const void *a, const void *b) {
+    const Group *x = a, *y = b;
+    return x->Row < y->Row ? -1 : x->Row > y->Row;
+}
+
+static void PrintAggregate(const AggregateJob *job, const Aggregate *agg, const Group *group, const Accumulator *acc) {
+    if (agg->Kind == AGG_COUNT) {
+        printf("| %-12llu ", (unsigned long long)group->Count);
+        return;
+    }
+    if (group->Count == 0) {
+        printf("| %-12s ", "NULL");
+        return;
+    }
+
+    DataTypes type = job->Table->Attributes[agg->Column].AttributeType;
+    switch (agg->Kind) {
+        case AGG_SUM:
+            if (type == DT_FLOAT) printf("| %-12.2f ", acc->FloatSum);
+            else printf("| %-12lld ", (long long)acc->IntSum);
+            break;
+        case AGG_AVG:
+            printf("| %-12.2f ", (type == DT_FLOAT ? acc->FloatSum : (double)acc->IntSum) / (double)group->Count);
+            break;
+        case AGG_MIN:
+        case AGG_MAX: {
+            double value = agg->Kind == AGG_MIN ? acc->Min : acc->Max;
+            if (type == DT_FLOAT) printf("| %-12.2f ", value);
+            else printf("| %-12.0f ", value);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Prints one line per group, in the order the groups first appear in the table.
+static void PrintGroups(const AggregateJob *job, GroupTable *groups) {
+    const Table *table = job->Table;
+    size_t stride = job->AggregateCount;
+
+    // Sorting moves groups away from their accumulators, so each carries its index along
+    for (size_t g = 0; g < groups->GroupCount; ++g) groups->Groups[g].Hash = g;
+    qsort(groups->Groups, groups->GroupCount, sizeof(Group), CompareGroupRows);
+
+    printf("\nAggregates from table '%s':\n", table->TableName);
+    for (size_t k = 0; k < job->GroupColumnCount; ++k) printf("| %-12s ", table->Attributes[job->GroupColumns[k]].AttributeName);
+    for (size_t a = 0; a < stride; ++a) printf("| %-12s ", job->Aggregates[a].Label);
+    printf("|\n");
+    for (size_t c = 0; c < job->GroupColumnCount + stride; ++c) printf("+--------------");
+    printf("+\n");
+
+    for (size_t g = 0; g < groups->GroupCount; ++g) {
+        const Group *group = &groups->Groups[g];
+        for (size_t k = 0; k < job->GroupColumnCount; ++k) PrintCell(table, job->GroupColumns[k], group->Row, 12);
+        for (size_t a = 0; a < stride; ++a) {
+            PrintAggregate(job, &job->Aggregates[a], group, &groups->Accs[group->Hash * stride + a]);
+        }
+        printf("|\n");
+    }
+    printf("%zu group%s.\n", groups->GroupCount, groups->GroupCount == 1 ? "" : "s");
+}
+
+// Evaluates aggregates such as "COUNT(*), SUM(price), AVG(qty)" over the rows matching where
+// (NULL for every row), one output line per distinct value of the groupBy columns (NULL for
+// a single line over all rows).
+bool AggregateQuery(Table *table, const char *aggregates, const char *groupBy, const char *where) {
+    if (!table || !aggregates) return false;
+
+    AggregateJob *job = calloc(1, sizeof(AggregateJob));
+    if (!job) return false;
+    job->Table = table;
+    if (!ParseAggregates(job, aggregates) || (groupBy && !ParseGroupColumns(job, groupBy))) {
+        free(job);
+        return false;
+    }
+
+    size_t *rows = NULL;
+    if (where) {
+        job->ItemCount = FindMatchingRows(table, where, &rows);
+        if (job->ItemCount == (size_t)-1) {
+            free(job);
+            return false;
+        }
+        job->Rows = rows;
+    } else {
+        job->ItemCount = table->RowCount;
+    }
+
+    size_t threads = job->ItemCount < PARALLEL_MIN_ROWS ? 1 : GetScanThreads();
+    job->Workers = calloc(threads, sizeof(GroupTable *));
+    bool ok = job->Workers != NULL;
+    for (size_t w = 0; ok && w < threads; ++w) {
+        job->Workers[w] = calloc(1, sizeof(GroupTable));
+        ok = job->Workers[w] != NULL;
+    }
+
+    if (ok) {
+        size_t morselCount = (job->ItemCount + MORSEL_ROWS - 1) / MORSEL_ROWS;
+        if (threads == 1) {
+            for (size_t m = 0; m < morselCount; ++m) AggregateMorsel(job, 0, m);
+        } else {
+            ParallelFor(morselCount, AggregateMorsel, job);
+        }
+        for (size_t w = 0; ok && w < threads; ++w) ok = !job->Workers[w]->Failed;
+        for (size_t w = 1; ok && w < threads; ++w) ok = MergeWorker(job, job->Workers[w]);
+    }
+
+    // Without GROUP BY there is always one line, even over no rows
+    if (ok && job->GroupColumnCount == 0 && job->Workers[0]->GroupCount == 0) {
+        ok = AddGroup(job->Workers[0], job->AggregateCount, 0, 0) != GROUP_NO_GROUP;
+    }
+
+    if (ok) PrintGroups(job, job->Workers[0]);
+    else printf("Out of memory evaluating aggregates on '%s'.\n", table->TableName);
+
+    for (size_t w = 0; job->Workers && w < threads; ++w) FreeGroupTable(job->Workers[w]);
+    free(job->Workers);
+    free(rows);
+    free(job);
+    return ok;
+}
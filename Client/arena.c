@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "functions.h"
+#include "database.h"
+
+#define ARENA_FIRST_CHUNK   (64 * 1024)
+#define ARENA_MAX_CHUNK     (8 * 1024 * 1024)
+#define ARENA_SLOT_ALIGN    8
+#define ARENA_SMALL_LIMIT   256
+#define ARENA_LARGE_BASE    (ARENA_SMALL_LIMIT / ARENA_SLOT_ALIGN + 1)
+
+// A released slot keeps its free-list link in its first 8 bytes. Small classes hold a single
+// size, so only large slots, which always have room for it, record their size as well.
+typedef struct {
+    StringRef Next;
+    uint64_t Size;
+} FreeSlot;
+
+// Slots are whole 8-byte units; every split leaves a remainder of whole units too, so a string
+// always occupies exactly SlotSize of its length and freeing it gives back the slot it got.
+static size_t SlotSize(size_t len) {
+    return (len + 1 + ARENA_SLOT_ALIGN - 1) & ~(size_t)(ARENA_SLOT_ALIGN - 1);
+}
+
+// Slots up to ARENA_SMALL_LIMIT get an exact-size class, larger ones one class per power of two.
+static int SizeClass(size_t size) {
+    if (size <= ARENA_SMALL_LIMIT) return (int)(size / ARENA_SLOT_ALIGN);
+
+    int log2 = 0;
+    while ((size >> (log2 + 1)) != 0) log2++;
+    int cls = ARENA_LARGE_BASE + (log2 - 8);
+    return cls < ARENA_SIZE_CLASSES ? cls : ARENA_SIZE_CLASSES - 1;
+}
+
+static FreeSlot *SlotAt(const Arena *arena, StringRef ref) {
+    return (FreeSlot *)ArenaString(arena, ref);
+}
+
+static size_t FreeSlotSize(const Arena *arena, int cls, StringRef ref) {
+    return cls <= ARENA_SMALL_LIMIT / ARENA_SLOT_ALIGN ? (size_t)cls * ARENA_SLOT_ALIGN : SlotAt(arena, ref)->Size;
+}
+
+static void PushFree(Arena *arena, StringRef ref, size_t size) {
+    int cls = SizeClass(size);
+    FreeSlot *slot = SlotAt(arena, ref);
+    slot->Next = arena->FreeLists[cls];
+    if (size > ARENA_SMALL_LIMIT) slot->Size = size;
+    arena->FreeLists[cls] = ref;
+    arena->BytesFree += size;
+}
+
+static StringRef PopFree(Arena *arena, int cls, size_t *size) {
+    StringRef ref = arena->FreeLists[cls];
+    *size = FreeSlotSize(arena, cls, ref);
+    arena->FreeLists[cls] = SlotAt(arena, ref)->Next;
+    arena->BytesFree -= *size;
+    return ref;
+}
+
+// Reuses a released slot of at least size bytes, splitting off whatever is left over.
+static bool TakeFreeSlot(Arena *arena, size_t size, StringRef *ref) {
+    int cls = SizeClass(size);
+    size_t slotSize;
+    if (size <= ARENA_SMALL_LIMIT && arena->FreeLists[cls] != ARENA_NULL_REF) {
+        *ref = PopFree(arena, cls, &slotSize);
+        return true;
+    }
+
+    // Otherwise split a bigger slot and keep the rest, which is at least one unit.
+    int first = size <= ARENA_SMALL_LIMIT ? cls + 1 : cls;
+    for (int c = first; c < ARENA_SIZE_CLASSES; ++c) {
+        if (arena->FreeLists[c] == ARENA_NULL_REF) continue;
+        if (FreeSlotSize(arena, c, arena->FreeLists[c]) < size) continue;
+
+        *ref = PopFree(arena, c, &slotSize);
+        if (slotSize > size) PushFree(arena, *ref + size, slotSize - size);
+        return true;
+    }
+    return false;
+}
+
+static bool GrowChunkList(Arena *arena) {
+    if (arena->ChunkCount == arena->ChunkCapacity) {
+        size_t newCapacity = arena->ChunkCapacity ? arena->ChunkCapacity * 2 : 4;
+        ArenaChunk *chunks = realloc(arena->Chunks, sizeof(ArenaChunk) * newCapacity);
+        if (!chunks) return false;
+        arena->Chunks = chunks;
+        arena->ChunkCapacity = newCapacity;
+    }
+    return true;
+}
+
+static bool AddChunk(Arena *arena, size_t minSize) {
+    if (!GrowChunkList(arena)) return false;
+
+    size_t capacity = ARENA_FIRST_CHUNK;
+    if (arena->ChunkCount > 0 && !arena->Chunks[arena->ChunkCount - 1].Borrowed) {
+        capacity = arena->Chunks[arena->ChunkCount - 1].Capacity * 2;
+        if (capacity > ARENA_MAX_CHUNK) capacity = ARENA_MAX_CHUNK;
+    }
+    if (capacity < minSize) capacity = minSize;
+
+    char *base = malloc(capacity);
+    if (!base) return false;
+
+    ArenaChunk *chunk = &arena->Chunks[arena->ChunkCount++];
+    chunk->Base = base;
+    chunk->Size = 0;
+    chunk->Capacity = capacity;
+    chunk->Borrowed = 0;
+    arena->BytesReserved += capacity;
+    return true;
+}
+
+// Adds size bytes of NUL-terminated strings that stay where they are, such as a string section
+// of a mapped table file; a string at offset o is then referenced by (index << ARENA_OFFSET_BITS) | o.
+// The chunk is full and never written, so freed strings in it are simply forgotten.
+bool ArenaBorrowChunk(Arena *arena, char *base, size_t size, size_t *index) {
+    if (!GrowChunkList(arena)) return false;
+
+    ArenaChunk *chunk = &arena->Chunks[arena->ChunkCount];
+    chunk->Base = base;
+    chunk->Size = size;
+    chunk->Capacity = size;
+    chunk->Borrowed = 1;
+    arena->BytesUsed += size;
+    arena->BytesLive += size;
+    *index = arena->ChunkCount++;
+    return true;
+}
+
+static bool BumpSlot(Arena *arena, size_t size, StringRef *ref) {
+    ArenaChunk *chunk = arena->ChunkCount ? &arena->Chunks[arena->ChunkCount - 1] : NULL;
+    if (!chunk || chunk->Capacity - chunk->Size < size) {
+        // Keep the tail of the current chunk usable for later small strings.
+        if (chunk && chunk->Capacity - chunk->Size >= ARENA_SLOT_ALIGN) {
+            size_t tail = (chunk->Capacity - chunk->Size) & ~(size_t)(ARENA_SLOT_ALIGN - 1);
+            StringRef tailRef = ((StringRef)(arena->ChunkCount - 1) << ARENA_OFFSET_BITS) | chunk->Size;
+            chunk->Size += tail;
+            arena->BytesUsed += tail;
+            PushFree(arena, tailRef, tail);
+        }
+        if (!AddChunk(arena, size)) return false;
+        chunk = &arena->Chunks[arena->ChunkCount - 1];
+    }
+
+    *ref = ((StringRef)(arena->ChunkCount - 1) << ARENA_OFFSET_BITS) | chunk->Size;
+    chunk->Size += size;
+    arena->BytesUsed += size;
+    return true;
+}
+
+void InitArena(Arena *arena) {
+    memset(arena, 0, sizeof(Arena));
+    for (int i = 0; i < ARENA_SIZE_CLASSES; ++i) {
+        arena->FreeLists[i] = ARENA_NULL_REF;
+    }
+}
+
+void FreeArena(Arena *arena) {
+    for (size_t i = 0; i < arena->ChunkCount; ++i) {
+        if (!arena->Chunks[i].Borrowed) free(arena->Chunks[i].Base);
+    }
+    free(arena->Chunks);
+    InitArena(arena);
+}
+
+char *ArenaAllocString(Arena *arena, size_t len, StringRef *ref) {
+    size_t size = SlotSize(len);
+    if (!TakeFreeSlot(arena, size, ref) && !BumpSlot(arena, size, ref)) return NULL;
+
+    char *dest = ArenaString(arena, *ref);
+    dest[len] = '\0';
+    arena->BytesLive += len + 1;
+    return dest;
+}
+
+bool ArenaStoreString(Arena *arena, const char *str, size_t len, StringRef *ref) {
+    char *dest = ArenaAllocString(arena, len, ref);
+    if (!dest) return false;
+    memcpy(dest, str, len);
+    return true;
+}
+
+void ArenaFreeString(Arena *arena, StringRef ref) {
+    size_t len = strlen(ArenaString(arena, ref));
+    arena->BytesLive -= len + 1;
+    if (!arena->Chunks[ref >> ARENA_OFFSET_BITS].Borrowed) PushFree(arena, ref, SlotSize(len));
+}
+
+// Released and unusable bytes are only recovered by rewriting the live strings; ask for
+// that once they outweigh the live data.
+bool ArenaNeedsCompaction(const Arena *arena) {
+    size_t dead = arena->BytesUsed - arena->BytesLive;
+    return dead > ARENA_FIRST_CHUNK && dead > arena->BytesLive;
+}
+
+void GetArenaStats(const Arena *arena, ArenaStats *stats) {
+    stats->ChunkCount = arena->ChunkCount;
+    stats->BytesReserved = arena->BytesReserved;
+    stats->BytesLive = arena->BytesLive;
+    stats->BytesFree = arena->BytesFree;
+    stats->BytesWaste = arena->BytesUsed - arena->BytesLive - arena->BytesFree;
+}
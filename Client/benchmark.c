@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "functions.h"
+#include "database.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+// Each measurement repeats the scan until it has run for at least this long.
+#define BENCH_MIN_SECONDS 0.2
+
+static double NowSeconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+// Synthetic table with INT/UINT/FLOAT columns and, for the I/O benchmark, a string column.
+static Table *CreateBenchTable(const char *name, size_t rowCount, bool withStrings) {
+    Attribute attributes[4] = {
+        {"i", DT_INT},
+        {"u", DT_UINT},
+        {"f", DT_FLOAT},
+        {"s", DT_STRING},
+    };
+    Table *table = CreateTable(name, attributes, withStrings ? 4 : 3);
+    if (!table) return NULL;
+
+    srand(42);
+    for (size_t r = 0; r < rowCount; ++r) {
+        int i = rand() % 2001 - 1000;
+        unsigned int u = (unsigned int)rand() % 2001;
+        float f = (float)(rand() % 20001) / 10.0f - 1000.0f;
+        char s[32];
+        snprintf(s, sizeof(s), "customer-%d", rand() % 100000);
+        void *values[4] = {&i, &u, &f, s};
+        if (!InsertRow(table, values)) {
+            FreeTable(table);
+            return NULL;
+        }
+    }
+    return table;
+}
+
+// Runs the kernel over the table block by block into one reused selection vector until
+// BENCH_MIN_SECONDS have passed, so allocation does not dilute the kernel cost; returns
+// rows per second.
+static double TimeScan(const Predicate *pred, const Table *table, size_t *rows, size_t *matches) {
+    size_t iterations = 0;
+    double start = NowSeconds(), elapsed;
+    do {
+        *matches = 0;
+        for (size_t begin = 0; begin < table->RowCount; begin += SCAN_BLOCK_ROWS) {
+            size_t end = begin + SCAN_BLOCK_ROWS < table->RowCount ? begin + SCAN_BLOCK_ROWS : table->RowCount;
+            *matches += RunPredicate(pred, table, begin, end, rows);
+        }
+        iterations++;
+        elapsed = NowSeconds() - start;
+    } while (elapsed < BENCH_MIN_SECONDS);
+
+    return (double)table->RowCount * (double)iterations / elapsed;
+}
+
+static void PrintIoRate(const char *what, uint64_t bytes, size_t iterations, double elapsed) {
+    printf("%-22s %12.1f MB/s\n", what, (double)bytes * (double)iterations / elapsed / 1e6);
+}
+
+// Saves and loads a synthetic table in every save and load mode, reporting file bytes per second.
+// Mapped loads only touch the footer and string offsets, so they are not bounded by file size.
+static void RunTableIoBenchmark(size_t rowCount) {
+    Table *table = CreateBenchTable("bench_io", rowCount, true);
+    if (!table || !SaveTableToFile(table)) {
+        printf("Failed to build I/O benchmark table.\n");
+        FreeTable(table);
+        return;
+    }
+
+    const char *path = "data/bench_io.tbl";
+    uint64_t bytes = 0;
+    printf("Saving and loading %zu rows with a string column\n", rowCount);
+
+    for (int atomic = 0; atomic <= 1; ++atomic) {
+        SetAtomicSaves(atomic);
+        size_t iterations = 0;
+        double start = NowSeconds(), elapsed;
+        do {
+            if (!SaveTableFile(table, path, &bytes)) break;
+            iterations++;
+            elapsed = NowSeconds() - start;
+        } while (elapsed < BENCH_MIN_SECONDS);
+        PrintIoRate(atomic ? "Save (temp + rename)" : "Save (in place)", bytes, iterations, NowSeconds() - start);
+    }
+    SetAtomicSaves(true);
+
+    for (int mapped = 1; mapped >= 0; --mapped) {
+        SetMappedLoads(mapped);
+        size_t iterations = 0;
+        double start = NowSeconds(), elapsed;
+        do {
+            Table *loaded = LoadTableFromFile(path);
+            if (!loaded) break;
+            FreeTable(loaded);
+            iterations++;
+            elapsed = NowSeconds() - start;
+        } while (elapsed < BENCH_MIN_SECONDS);
+        PrintIoRate(mapped ? "Load (mapped)" : "Load (read)", bytes, iterations, NowSeconds() - start);
+    }
+    SetMappedLoads(true);
+
+    remove(path);
+    FreeTable(table);
+}
+
+// Filters a low-cardinality string column stored per row and interned, reporting scan rates
+// and the memory each layout takes for its strings and row slots.
+static void RunStringScanBenchmark(size_t rowCount, size_t *rows) {
+    static const char *statuses[] = {"active", "blocked", "closed", "pending", "suspended", "trial"};
+    static const char *operators[] = {"=", ">"};
+    Attribute attributes[1] = {{"status", DT_STRING}};
+
+    printf("Filtering %zu rows of a 6-value string column\n", rowCount);
+    printf("%-9s %-3s %14s %14s\n", "Layout", "Op", "Rows/sec", "Bytes");
+
+    for (int interned = 0; interned <= 1; ++interned) {
+        Table *table = CreateTable("bench_dict", attributes, 1);
+        if (table && interned && !InternColumn(table, 0)) {
+            FreeTable(table);
+            table = NULL;
+        }
+        for (size_t r = 0; table && r < rowCount; ++r) {
+            void *values[1] = {(void *)statuses[r * 7 % 6]};
+            if (!InsertRow(table, values)) {
+                FreeTable(table);
+                table = NULL;
+            }
+        }
+        if (!table) {
+            printf("Failed to build string benchmark table.\n");
+            return;
+        }
+
+        ArenaStats stats;
+        GetArenaStats(&table->Strings, &stats);
+        size_t bytes = stats.BytesLive + rowCount * (interned ? sizeof(uint32_t) : sizeof(StringRef));
+
+        for (size_t o = 0; o < sizeof(operators) / sizeof(operators[0]); ++o) {
+            Predicate pred;
+            if (!CompilePredicate(table, 0, ParseOperator(operators[o]), "closed", &pred)) continue;
+            size_t matches;
+            double rate = TimeScan(&pred, table, rows, &matches);
+            FreePredicate(&pred);
+            printf("%-9s %-3s %14.0f %14zu\n", interned ? "interned" : "per row", operators[o], rate, bytes);
+        }
+        FreeTable(table);
+    }
+}
+
+// Compares the scalar filter kernels with every vector level this CPU supports on a
+// synthetic table of INT/UINT/FLOAT columns with about half the rows matching.
+void RunScanBenchmark(size_t rowCount) {
+    Table *table = CreateBenchTable("bench", rowCount, false);
+    size_t *rows = malloc(sizeof(size_t) * SCAN_BLOCK_ROWS);
+    if (!table || !rows) {
+        printf("Failed to build benchmark table.\n");
+        FreeTable(table);
+        free(rows);
+        return;
+    }
+
+    SimdLevel saved = GetSimdLevel();
+    SimdLevel detected = DetectSimdLevel();
+    static const char *operators[] = {"=", "!=", ">", "<", ">=", "<="};
+    static const char *literals[] = {"0", "1000", "0"};
+
+    printf("Scanning %zu rows, best vector level: %s\n", rowCount, SimdLevelName(detected));
+    printf("%-6s %-3s %-8s %14s %10s\n", "Column", "Op", "Kernel", "Rows/sec", "Speedup");
+
+    for (size_t col = 0; col < table->AttributeCount; ++col) {
+        for (size_t o = 0; o < sizeof(operators) / sizeof(operators[0]); ++o) {
+            double scalarRate = 0;
+            size_t scalarMatches = 0;
+
+            for (SimdLevel level = SIMD_SCALAR; level <= detected; ++level) {
+                SetSimdLevel(level);
+                Predicate pred;
+                if (!CompilePredicate(table, col, ParseOperator(operators[o]), literals[col], &pred)) continue;
+
+                size_t matches;
+                double rate = TimeScan(&pred, table, rows, &matches);
+                FreePredicate(&pred);
+
+                if (level == SIMD_SCALAR) {
+                    scalarRate = rate;
+                    scalarMatches = matches;
+                } else if (matches != scalarMatches) {
+                    printf("Mismatch: %s kernel found %zu rows, scalar found %zu.\n",
+                           SimdLevelName(level), matches, scalarMatches);
+                }
+
+                printf("%-6s %-3s %-8s %14.0f %9.2fx\n", table->Attributes[col].AttributeName, operators[o],
+                       SimdLevelName(level), rate, scalarRate > 0 ? rate / scalarRate : 1.0);
+            }
+        }
+    }
+
+    SetSimdLevel(saved);
+    FreeTable(table);
+
+    RunStringScanBenchmark(rowCount, rows);
+    free(rows);
+
+    RunTableIoBenchmark(rowCount);
+}
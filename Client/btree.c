@@ -0,0 +1,576 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "functions.h"
+#include "database.h"
+
+#define BTREE_PAGE_SIZE     4096
+#define BTREE_VERSION       1
+#define BTREE_CACHE_PAGES   128
+#define BTREE_NODE_HEADER   16
+#define LEAF_CAPACITY       ((BTREE_PAGE_SIZE - BTREE_NODE_HEADER) / sizeof(BTreeEntry))
+#define INTERNAL_CAPACITY   ((BTREE_PAGE_SIZE - BTREE_NODE_HEADER - sizeof(uint64_t)) / (sizeof(BTreeEntry) + sizeof(uint64_t)))
+#define BULK_LEAF_FILL      (LEAF_CAPACITY * 9 / 10)
+#define BULK_INTERNAL_FILL  (INTERNAL_CAPACITY * 9 / 10)
+
+static const char BTREE_MAGIC[8] = {'S', 'D', 'B', 'I', 'D', 'X', '\0', '\0'};
+
+// Page 0 of every index file.
+typedef struct {
+    char Magic[8];
+    uint32_t Version;
+    uint32_t KeyType;
+    uint64_t Root;
+    uint64_t PageCount;
+    uint64_t EntryCount;
+    uint64_t Synced;
+    uint64_t TableBytes;
+} BTreeHeader;
+
+// Leaf pages hold sorted entries and link to their right sibling. Internal pages hold
+// Count separator entries followed by Count + 1 child page numbers; Keys[i] is the
+// smallest entry reachable through Children[i + 1].
+typedef struct {
+    uint16_t IsLeaf;
+    uint16_t Count;
+    uint32_t Reserved;
+    uint64_t Next;
+} NodeHeader;
+
+// Data comes first so cached pages keep the allocation's alignment.
+typedef struct {
+    unsigned char Data[BTREE_PAGE_SIZE];
+    uint64_t PageNo;
+    uint64_t LastUse;
+    bool Dirty;
+} CachedPage;
+
+struct BTree {
+    FILE *File;
+    char *Path;
+    BTreeHeader Header;
+    CachedPage *Cache;
+    size_t CacheCount;
+    uint64_t Clock;
+};
+
+static NodeHeader *Node(unsigned char *page) { return (NodeHeader *)page; }
+static BTreeEntry *Entries(unsigned char *page) { return (BTreeEntry *)(page + BTREE_NODE_HEADER); }
+static uint64_t *Children(unsigned char *page) {
+    return (uint64_t *)(page + BTREE_NODE_HEADER + INTERNAL_CAPACITY * sizeof(BTreeEntry));
+}
+
+static int CompareEntries(const BTreeEntry *a, const BTreeEntry *b) {
+    if (a->Key != b->Key) return a->Key < b->Key ? -1 : 1;
+    if (a->Row != b->Row) return a->Row < b->Row ? -1 : 1;
+    return 0;
+}
+
+// First position in entries[0..count) that is not less than e.
+static size_t LowerBound(const BTreeEntry *entries, size_t count, const BTreeEntry *e) {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (CompareEntries(&entries[mid], e) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Number of separators in entries[0..count) that are less than or equal to e.
+static size_t UpperBound(const BTreeEntry *entries, size_t count, const BTreeEntry *e) {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (CompareEntries(&entries[mid], e) <= 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static bool WritePage(BTree *tree, uint64_t pageNo, const void *data) {
+    if (FILE_SEEK(tree->File, pageNo * BTREE_PAGE_SIZE, SEEK_SET) != 0) return false;
+    return fwrite(data, BTREE_PAGE_SIZE, 1, tree->File) == 1;
+}
+
+static bool WriteHeader(BTree *tree) {
+    unsigned char page[BTREE_PAGE_SIZE];
+    memset(page, 0, sizeof(page));
+    memcpy(page, &tree->Header, sizeof(BTreeHeader));
+    return WritePage(tree, 0, page);
+}
+
+// The first change after a sync clears the flag on disk, so a file that was not synced
+// together with its table is rebuilt on the next load.
+static void MarkDirty(BTree *tree) {
+    if (!tree->Header.Synced) return;
+    tree->Header.Synced = 0;
+    WriteHeader(tree);
+    fflush(tree->File);
+}
+
+static bool EvictPage(BTree *tree, CachedPage *slot) {
+    if (slot->Dirty && !WritePage(tree, slot->PageNo, slot->Data)) return false;
+    slot->Dirty = false;
+    return true;
+}
+
+// Returns the cached copy of a page. Pointers stay valid until BTREE_CACHE_PAGES other pages
+// have been touched, which callers never exceed while holding one.
+static unsigned char *GetPage(BTree *tree, uint64_t pageNo, bool forWrite) {
+    CachedPage *slot = NULL;
+    for (size_t i = 0; i < tree->CacheCount; ++i) {
+        if (tree->Cache[i].PageNo == pageNo) {
+            slot = &tree->Cache[i];
+            break;
+        }
+    }
+
+    if (!slot) {
+        if (tree->CacheCount < BTREE_CACHE_PAGES) {
+            slot = &tree->Cache[tree->CacheCount++];
+        } else {
+            slot = &tree->Cache[0];
+            for (size_t i = 1; i < tree->CacheCount; ++i) {
+                if (tree->Cache[i].LastUse < slot->LastUse) slot = &tree->Cache[i];
+            }
+            if (!EvictPage(tree, slot)) return NULL;
+        }
+
+        slot->PageNo = pageNo;
+        slot->Dirty = false;
+        if (FILE_SEEK(tree->File, pageNo * BTREE_PAGE_SIZE, SEEK_SET) != 0 ||
+            fread(slot->Data, BTREE_PAGE_SIZE, 1, tree->File) != 1) {
+            slot->PageNo = UINT64_MAX;
+            return NULL;
+        }
+    }
+
+    slot->LastUse = ++tree->Clock;
+    if (forWrite) {
+        slot->Dirty = true;
+        MarkDirty(tree);
+    }
+    return slot->Data;
+}
+
+static unsigned char *NewPage(BTree *tree, uint64_t *pageNo, bool isLeaf) {
+    unsigned char blank[BTREE_PAGE_SIZE];
+    memset(blank, 0, sizeof(blank));
+
+    *pageNo = tree->Header.PageCount++;
+    if (!WritePage(tree, *pageNo, blank)) return NULL;
+
+    unsigned char *page = GetPage(tree, *pageNo, true);
+    if (page) Node(page)->IsLeaf = isLeaf;
+    return page;
+}
+
+static void ResetCache(BTree *tree) {
+    tree->CacheCount = 0;
+}
+
+static BTree *AllocTree(const char *path, FILE *file) {
+    BTree *tree = calloc(1, sizeof(BTree));
+    if (!tree) return NULL;
+
+    tree->Cache = malloc(sizeof(CachedPage) * BTREE_CACHE_PAGES);
+    tree->Path = strdup(path);
+    if (!tree->Cache || !tree->Path) {
+        free(tree->Cache);
+        free(tree->Path);
+        free(tree);
+        return NULL;
+    }
+    tree->File = file;
+    return tree;
+}
+
+BTree *BTreeCreate(const char *path, DataTypes keyType) {
+    FILE *file = fopen(path, "w+b");
+    if (!file) {
+        perror("Failed to create index file");
+        return NULL;
+    }
+
+    BTree *tree = AllocTree(path, file);
+    if (!tree) {
+        fclose(file);
+        return NULL;
+    }
+
+    memcpy(tree->Header.Magic, BTREE_MAGIC, sizeof(BTREE_MAGIC));
+    tree->Header.Version = BTREE_VERSION;
+    tree->Header.KeyType = (uint32_t)keyType;
+    tree->Header.PageCount = 1;
+
+    uint64_t root;
+    if (!WriteHeader(tree) || !NewPage(tree, &root, true)) {
+        BTreeClose(tree);
+        return NULL;
+    }
+    tree->Header.Root = root;
+    return tree;
+}
+
+BTree *BTreeOpen(const char *path) {
+    FILE *file = fopen(path, "r+b");
+    if (!file) return NULL;
+
+    BTreeHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.Magic, BTREE_MAGIC, sizeof(BTREE_MAGIC)) != 0 ||
+        header.Version != BTREE_VERSION) {
+        fclose(file);
+        return NULL;
+    }
+
+    BTree *tree = AllocTree(path, file);
+    if (!tree) {
+        fclose(file);
+        return NULL;
+    }
+    tree->Header = header;
+    return tree;
+}
+
+bool BTreeFlush(BTree *tree) {
+    for (size_t i = 0; i < tree->CacheCount; ++i) {
+        if (!EvictPage(tree, &tree->Cache[i])) return false;
+    }
+    if (!WriteHeader(tree)) return false;
+    return fflush(tree->File) == 0;
+}
+
+void BTreeClose(BTree *tree) {
+    if (!tree) return;
+    // A failed bulk load leaves no file behind.
+    if (tree->File) {
+        BTreeFlush(tree);
+        fclose(tree->File);
+    }
+    free(tree->Cache);
+    free(tree->Path);
+    free(tree);
+}
+
+const char *BTreePath(const BTree *tree) {
+    return tree->Path;
+}
+
+size_t BTreeEntryCount(const BTree *tree) {
+    return (size_t)tree->Header.EntryCount;
+}
+
+bool BTreeIsSynced(const BTree *tree, uint64_t tableBytes) {
+    return tree->Header.Synced && tree->Header.TableBytes == tableBytes;
+}
+
+bool BTreeMarkSynced(BTree *tree, uint64_t tableBytes) {
+    tree->Header.Synced = 1;
+    tree->Header.TableBytes = tableBytes;
+    return BTreeFlush(tree);
+}
+
+// Inserts e under pageNo. When the page splits, the new right sibling and its first entry
+// are handed back so the parent can link it.
+static bool InsertInto(BTree *tree, uint64_t pageNo, const BTreeEntry *e,
+                       bool *split, BTreeEntry *separator, uint64_t *rightPage) {
+    *split = false;
+    unsigned char *page = GetPage(tree, pageNo, false);
+    if (!page) return false;
+
+    if (Node(page)->IsLeaf) {
+        page = GetPage(tree, pageNo, true);
+        NodeHeader *node = Node(page);
+        BTreeEntry *entries = Entries(page);
+        size_t pos = LowerBound(entries, node->Count, e);
+
+        if (node->Count < LEAF_CAPACITY) {
+            memmove(&entries[pos + 1], &entries[pos], (node->Count - pos) * sizeof(BTreeEntry));
+            entries[pos] = *e;
+            node->Count++;
+            return true;
+        }
+
+        BTreeEntry all[LEAF_CAPACITY + 1];
+        memcpy(all, entries, pos * sizeof(BTreeEntry));
+        all[pos] = *e;
+        memcpy(&all[pos + 1], &entries[pos], (node->Count - pos) * sizeof(BTreeEntry));
+        size_t total = node->Count + 1;
+        size_t leftCount = total / 2;
+        uint64_t oldNext = node->Next;
+
+        unsigned char *right = NewPage(tree, rightPage, true);
+        if (!right) return false;
+        Node(right)->Count = (uint16_t)(total - leftCount);
+        Node(right)->Next = oldNext;
+        memcpy(Entries(right), &all[leftCount], (total - leftCount) * sizeof(BTreeEntry));
+
+        page = GetPage(tree, pageNo, true);
+        Node(page)->Count = (uint16_t)leftCount;
+        Node(page)->Next = *rightPage;
+        memcpy(Entries(page), all, leftCount * sizeof(BTreeEntry));
+
+        *separator = all[leftCount];
+        *split = true;
+        return true;
+    }
+
+    size_t childIndex = UpperBound(Entries(page), Node(page)->Count, e);
+    uint64_t child = Children(page)[childIndex];
+
+    bool childSplit;
+    BTreeEntry childSeparator;
+    uint64_t childRight;
+    if (!InsertInto(tree, child, e, &childSplit, &childSeparator, &childRight)) return false;
+    if (!childSplit) return true;
+
+    page = GetPage(tree, pageNo, true);
+    NodeHeader *node = Node(page);
+    BTreeEntry *keys = Entries(page);
+    uint64_t *children = Children(page);
+
+    if (node->Count < INTERNAL_CAPACITY) {
+        memmove(&keys[childIndex + 1], &keys[childIndex], (node->Count - childIndex) * sizeof(BTreeEntry));
+        memmove(&children[childIndex + 2], &children[childIndex + 1], (node->Count - childIndex) * sizeof(uint64_t));
+        keys[childIndex] = childSeparator;
+        children[childIndex + 1] = childRight;
+        node->Count++;
+        return true;
+    }
+
+    BTreeEntry allKeys[INTERNAL_CAPACITY + 1];
+    uint64_t allChildren[INTERNAL_CAPACITY + 2];
+    memcpy(allKeys, keys, childIndex * sizeof(BTreeEntry));
+    allKeys[childIndex] = childSeparator;
+    memcpy(&allKeys[childIndex + 1], &keys[childIndex], (node->Count - childIndex) * sizeof(BTreeEntry));
+    memcpy(allChildren, children, (childIndex + 1) * sizeof(uint64_t));
+    allChildren[childIndex + 1] = childRight;
+    memcpy(&allChildren[childIndex + 2], &children[childIndex + 1], (node->Count - childIndex) * sizeof(uint64_t));
+
+    // The middle separator moves up instead of staying in either half.
+    size_t totalKeys = node->Count + 1;
+    size_t leftKeys = totalKeys / 2;
+    size_t rightKeys = totalKeys - leftKeys - 1;
+
+    unsigned char *right = NewPage(tree, rightPage, false);
+    if (!right) return false;
+    Node(right)->Count = (uint16_t)rightKeys;
+    memcpy(Entries(right), &allKeys[leftKeys + 1], rightKeys * sizeof(BTreeEntry));
+    memcpy(Children(right), &allChildren[leftKeys + 1], (rightKeys + 1) * sizeof(uint64_t));
+
+    page = GetPage(tree, pageNo, true);
+    Node(page)->Count = (uint16_t)leftKeys;
+    memcpy(Entries(page), allKeys, leftKeys * sizeof(BTreeEntry));
+    memcpy(Children(page), allChildren, (leftKeys + 1) * sizeof(uint64_t));
+
+    *separator = allKeys[leftKeys];
+    *split = true;
+    return true;
+}
+
+bool BTreeInsert(BTree *tree, uint64_t key, uint64_t row) {
+    BTreeEntry e = {key, row};
+    bool split;
+    BTreeEntry separator;
+    uint64_t rightPage;
+
+    if (!InsertInto(tree, tree->Header.Root, &e, &split, &separator, &rightPage)) return false;
+
+    if (split) {
+        uint64_t newRoot;
+        unsigned char *root = NewPage(tree, &newRoot, false);
+        if (!root) return false;
+        Node(root)->Count = 1;
+        Entries(root)[0] = separator;
+        Children(root)[0] = tree->Header.Root;
+        Children(root)[1] = rightPage;
+        tree->Header.Root = newRoot;
+    }
+
+    tree->Header.EntryCount++;
+    return true;
+}
+
+static uint64_t FindLeaf(BTree *tree, const BTreeEntry *e) {
+    uint64_t pageNo = tree->Header.Root;
+    for (;;) {
+        unsigned char *page = GetPage(tree, pageNo, false);
+        if (!page) return 0;
+        if (Node(page)->IsLeaf) return pageNo;
+        pageNo = Children(page)[UpperBound(Entries(page), Node(page)->Count, e)];
+    }
+}
+
+// Removes the entry from its leaf. Leaves are not merged; an emptied leaf simply stays in
+// the sibling chain until the index is rebuilt.
+bool BTreeDelete(BTree *tree, uint64_t key, uint64_t row) {
+    BTreeEntry e = {key, row};
+    uint64_t pageNo = FindLeaf(tree, &e);
+    if (!pageNo) return false;
+
+    unsigned char *page = GetPage(tree, pageNo, false);
+    NodeHeader *node = Node(page);
+    BTreeEntry *entries = Entries(page);
+    size_t pos = LowerBound(entries, node->Count, &e);
+    if (pos == node->Count || CompareEntries(&entries[pos], &e) != 0) return false;
+
+    page = GetPage(tree, pageNo, true);
+    node = Node(page);
+    entries = Entries(page);
+    memmove(&entries[pos], &entries[pos + 1], (node->Count - pos - 1) * sizeof(BTreeEntry));
+    node->Count--;
+    tree->Header.EntryCount--;
+    return true;
+}
+
+// Collects the rows of the entries with keys in [low, high], in key order; (size_t)-1 if a
+// page cannot be read or memory runs out, as a partial range would pass for the whole one.
+size_t BTreeSearchRange(BTree *tree, uint64_t low, uint64_t high, size_t **rows) {
+    *rows = NULL;
+    if (low > high) return 0;
+
+    BTreeEntry start = {low, 0};
+    uint64_t pageNo = FindLeaf(tree, &start);
+    unsigned char *page = pageNo ? GetPage(tree, pageNo, false) : NULL;
+    if (!page) return (size_t)-1;
+
+    size_t count = 0, capacity = 0;
+    size_t pos = LowerBound(Entries(page), Node(page)->Count, &start);
+    for (;;) {
+        NodeHeader *node = Node(page);
+        BTreeEntry *entries = Entries(page);
+        for (; pos < node->Count; ++pos) {
+            if (entries[pos].Key > high) return count;
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                size_t *grown = realloc(*rows, sizeof(size_t) * capacity);
+                if (!grown) break;
+                *rows = grown;
+            }
+            (*rows)[count++] = (size_t)entries[pos].Row;
+        }
+        if (pos < node->Count) break;
+        if (!node->Next) return count;
+        page = GetPage(tree, node->Next, false);
+        if (!page) break;
+        pos = 0;
+    }
+
+    free(*rows);
+    *rows = NULL;
+    return (size_t)-1;
+}
+
+static int CompareEntriesQsort(const void *a, const void *b) {
+    return CompareEntries(a, b);
+}
+
+// Rewrites the file from scratch: sorted leaves are packed left to right, then each internal
+// level is built over the one below it. On failure the tree is unusable and must be closed.
+bool BTreeBulkLoad(BTree *tree, BTreeEntry *entries, size_t count) {
+    qsort(entries, count, sizeof(BTreeEntry), CompareEntriesQsort);
+
+    ResetCache(tree);
+    // freopen closes the old stream even when it fails.
+    tree->File = freopen(tree->Path, "w+b", tree->File);
+    if (!tree->File) return false;
+    tree->Header.PageCount = 1;
+    tree->Header.EntryCount = count;
+    tree->Header.Synced = 0;
+    if (!WriteHeader(tree)) return false;
+
+    size_t leafCount = count ? (count + BULK_LEAF_FILL - 1) / BULK_LEAF_FILL : 1;
+    BTreeEntry *firsts = malloc(sizeof(BTreeEntry) * leafCount);
+    uint64_t *pages = malloc(sizeof(uint64_t) * leafCount);
+    if (!firsts || !pages) {
+        free(firsts);
+        free(pages);
+        return false;
+    }
+
+    uint64_t pageWords[BTREE_PAGE_SIZE / sizeof(uint64_t)];
+    unsigned char *page = (unsigned char *)pageWords;
+    for (size_t i = 0; i < leafCount; ++i) {
+        size_t begin = i * BULK_LEAF_FILL;
+        size_t n = count - begin < BULK_LEAF_FILL ? count - begin : BULK_LEAF_FILL;
+        if (count == 0) n = 0;
+
+        memset(page, 0, BTREE_PAGE_SIZE);
+        Node(page)->IsLeaf = 1;
+        Node(page)->Count = (uint16_t)n;
+        pages[i] = tree->Header.PageCount++;
+        Node(page)->Next = i + 1 < leafCount ? pages[i] + 1 : 0;
+        memcpy(Entries(page), &entries[begin], n * sizeof(BTreeEntry));
+        if (n) firsts[i] = entries[begin];
+        if (!WritePage(tree, pages[i], page)) {
+            free(firsts);
+            free(pages);
+            return false;
+        }
+    }
+
+    size_t levelCount = leafCount;
+    while (levelCount > 1) {
+        size_t fanout = BULK_INTERNAL_FILL + 1;
+        size_t parentCount = (levelCount + fanout - 1) / fanout;
+        for (size_t p = 0; p < parentCount; ++p) {
+            size_t begin = p * fanout;
+            size_t n = levelCount - begin < fanout ? levelCount - begin : fanout;
+
+            memset(page, 0, BTREE_PAGE_SIZE);
+            Node(page)->Count = (uint16_t)(n - 1);
+            for (size_t c = 0; c < n; ++c) {
+                Children(page)[c] = pages[begin + c];
+                if (c > 0) Entries(page)[c - 1] = firsts[begin + c];
+            }
+
+            uint64_t pageNo = tree->Header.PageCount++;
+            if (!WritePage(tree, pageNo, page)) {
+                free(firsts);
+                free(pages);
+                return false;
+            }
+            firsts[p] = firsts[begin];
+            pages[p] = pageNo;
+        }
+        levelCount = parentCount;
+    }
+
+    tree->Header.Root = pages[0];
+    free(firsts);
+    free(pages);
+    return BTreeFlush(tree);
+}
+
+// Maps a cell value to a 64-bit key whose unsigned order matches the column order. Strings
+// keep only their first eight bytes, so callers re-check string matches.
+uint64_t EncodeIndexKey(DataTypes type, const void *value) {
+    switch (type) {
+        case DT_INT:
+            return (uint64_t)(int64_t)*(const int *)value ^ ((uint64_t)1 << 63);
+        case DT_UINT:
+            return *(const unsigned int *)value;
+        case DT_FLOAT: {
+            // -0.0 compares equal to 0.0, so both share a key.
+            float f = *(const float *)value;
+            if (f == 0.0f) f = 0.0f;
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+            return bits;
+        }
+        case DT_STRING: {
+            const unsigned char *str = value;
+            uint64_t key = 0;
+            size_t i = 0;
+            for (; i < 8 && str[i]; ++i) key = (key << 8) | str[i];
+            return i ? key << (8 * (8 - i)) : 0;
+        }
+    }
+    return 0;
+}
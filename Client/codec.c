@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "functions.h"
+#include "database.h"
+
+// Column codecs for .tbl sections. Every row group is encoded on its own so groups can be
+// located through the footer and decoded in parallel. Multi-byte fields inside an encoded
+// group are little-endian regardless of the writer, so encoded sections never need swapping.
+//
+//   RLE      runs of varint length + 4-byte value; any 4-byte column
+//   DELTA    first value, then zigzag varint differences; INT and UINT
+//   BITPACK  4-byte minimum, 1-byte bit width, then value - minimum in width bits; INT and UINT
+
+// An encoding must save at least this share of the plain size to be used, since only plain
+// sections can be mapped.
+#define CODEC_MIN_SAVING_PERCENT 25
+
+// Dictionaries larger than this, or than half the rows, are not worth building.
+#define DICT_MAX_ENTRIES (1 << 16)
+
+static void StoreLe32(unsigned char *out, uint32_t value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+    out[2] = (unsigned char)(value >> 16);
+    out[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t LoadLe32(const unsigned char *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static size_t VarintSize(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static size_t PutVarint(unsigned char *out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (unsigned char)value;
+    return n;
+}
+
+static bool GetVarint(const unsigned char **in, const unsigned char *end, uint64_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && *in < end; shift += 7) {
+        unsigned char byte = *(*in)++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t ZigZag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t UnZigZag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// INT values are ordered as signed, UINT as unsigned; FLOAT is never delta or bit-packed.
+static int64_t Widen(DataTypes type, uint32_t bits) {
+    return type == DT_INT ? (int64_t)(int32_t)bits : (int64_t)bits;
+}
+
+static int BitWidth(uint64_t range) {
+    int width = 0;
+    while (width < 64 && (range >> width) != 0) width++;
+    return width;
+}
+
+static void GroupRange(DataTypes type, const uint32_t *values, size_t count, int64_t *min, int64_t *max) {
+    *min = *max = Widen(type, values[0]);
+    for (size_t i = 1; i < count; ++i) {
+        int64_t v = Widen(type, values[i]);
+        if (v < *min) *min = v;
+        if (v > *max) *max = v;
+    }
+}
+
+static size_t BitpackedSize(size_t count, int width) {
+    return 5 + (count * (size_t)width + 7) / 8;
+}
+
+// Encoded size of one group, or SIZE_MAX if the encoding does not apply to the type.
+static size_t MeasureGroup(ColumnEncoding encoding, DataTypes type, const uint32_t *values, size_t count) {
+    size_t size = 0;
+    switch (encoding) {
+        case ENCODING_RLE:
+            for (size_t i = 0; i < count;) {
+                size_t run = 1;
+                while (i + run < count && values[i + run] == values[i]) run++;
+                size += 4 + VarintSize(run);
+                i += run;
+            }
+            return size;
+        case ENCODING_DELTA:
+            if (type == DT_FLOAT) return SIZE_MAX;
+            size = 4;
+            for (size_t i = 1; i < count; ++i) {
+                size += VarintSize(ZigZag(Widen(type, values[i]) - Widen(type, values[i - 1])));
+            }
+            return size;
+        case ENCODING_BITPACK: {
+            if (type == DT_FLOAT) return SIZE_MAX;
+            int64_t min, max;
+            GroupRange(type, values, count, &min, &max);
+            return BitpackedSize(count, BitWidth((uint64_t)(max - min)));
+        }
+        default:
+            return count * sizeof(uint32_t);
+    }
+}
+
+// Picks the smallest encoding for a 4-byte column, or plain if none saves enough.
+ColumnEncoding ChooseNumericEncoding(DataTypes type, const uint32_t *values, size_t rows) {
+    static const ColumnEncoding candidates[] = {ENCODING_RLE, ENCODING_DELTA, ENCODING_BITPACK};
+    uint64_t plain = (uint64_t)rows * sizeof(uint32_t);
+    ColumnEncoding best = ENCODING_PLAIN;
+    if (rows == 0) return best;
+
+    uint64_t bestSize = plain * (100 - CODEC_MIN_SAVING_PERCENT) / 100;
+
+    for (size_t c = 0; c < sizeof(candidates) / sizeof(candidates[0]); ++c) {
+        uint64_t total = 0;
+        for (size_t begin = 0; begin < rows && total <= bestSize; begin += ZONE_ROWS) {
+            size_t count = rows - begin < ZONE_ROWS ? rows - begin : ZONE_ROWS;
+            size_t size = MeasureGroup(candidates[c], type, values + begin, count);
+            total = size == SIZE_MAX ? UINT64_MAX : total + size;
+        }
+        if (total <= bestSize) {
+            best = candidates[c];
+            bestSize = total;
+        }
+    }
+    return best;
+}
+
+// Encodes count values (at most ZONE_ROWS) into out, which holds CODEC_GROUP_BOUND(count)
+// bytes; returns the bytes used.
+size_t EncodeNumericGroup(ColumnEncoding encoding, DataTypes type, const uint32_t *values, size_t count,
+                          unsigned char *out) {
+    size_t n = 0;
+    switch (encoding) {
+        case ENCODING_RLE:
+            for (size_t i = 0; i < count;) {
+                size_t run = 1;
+                while (i + run < count && values[i + run] == values[i]) run++;
+                n += PutVarint(out + n, run);
+                StoreLe32(out + n, values[i]);
+                n += 4;
+                i += run;
+            }
+            return n;
+        case ENCODING_DELTA:
+            StoreLe32(out, values[0]);
+            n = 4;
+            for (size_t i = 1; i < count; ++i) {
+                n += PutVarint(out + n, ZigZag(Widen(type, values[i]) - Widen(type, values[i - 1])));
+            }
+            return n;
+        case ENCODING_BITPACK: {
+            int64_t min, max;
+            GroupRange(type, values, count, &min, &max);
+            int width = BitWidth((uint64_t)(max - min));
+            StoreLe32(out, (uint32_t)min);
+            out[4] = (unsigned char)width;
+            n = 5;
+
+            uint64_t acc = 0;
+            int bits = 0;
+            for (size_t i = 0; i < count; ++i) {
+                acc |= (uint64_t)(uint32_t)(values[i] - (uint32_t)min) << bits;
+                bits += width;
+                while (bits >= 8) {
+                    out[n++] = (unsigned char)acc;
+                    acc >>= 8;
+                    bits -= 8;
+                }
+            }
+            if (bits > 0) out[n++] = (unsigned char)acc;
+            return n;
+        }
+        default:
+            memcpy(out, values, count * sizeof(uint32_t));
+            return count * sizeof(uint32_t);
+    }
+}
+
+// Decodes exactly count values from size bytes; false if the group is malformed.
+bool DecodeNumericGroup(ColumnEncoding encoding, DataTypes type, const unsigned char *in, size_t size,
+                        uint32_t *values, size_t count) {
+    const unsigned char *end = in + size;
+    switch (encoding) {
+        case ENCODING_RLE: {
+            size_t i = 0;
+            while (i < count) {
+                uint64_t run;
+                if (!GetVarint(&in, end, &run) || run == 0 || run > count - i || end - in < 4) return false;
+                uint32_t value = LoadLe32(in);
+                in += 4;
+                for (size_t r = 0; r < run; ++r) values[i++] = value;
+            }
+            return true;
+        }
+        case ENCODING_DELTA: {
+            if (count == 0) return true;
+            if (size < 4) return false;
+            int64_t value = Widen(type, LoadLe32(in));
+            in += 4;
+            values[0] = (uint32_t)value;
+            for (size_t i = 1; i < count; ++i) {
+                uint64_t delta;
+                if (!GetVarint(&in, end, &delta)) return false;
+                value += UnZigZag(delta);
+                values[i] = (uint32_t)value;
+            }
+            return true;
+        }
+        case ENCODING_BITPACK: {
+            if (size < 5) return false;
+            uint32_t min = LoadLe32(in);
+            int width = in[4];
+            if (width > 32 || size < BitpackedSize(count, width)) return false;
+            in += 5;
+
+            uint64_t mask = width == 32 ? 0xFFFFFFFFull : ((uint64_t)1 << width) - 1;
+            uint64_t acc = 0;
+            int bits = 0;
+            for (size_t i = 0; i < count; ++i) {
+                while (bits < width) {
+                    acc |= (uint64_t)*in++ << bits;
+                    bits += 8;
+                }
+                values[i] = min + (uint32_t)(acc & mask);
+                acc >>= width;
+                bits -= width;
+            }
+            return true;
+        }
+        default:
+            if (size < count * sizeof(uint32_t)) return false;
+            memcpy(values, in, count * sizeof(uint32_t));
+            return true;
+    }
+}
+
+static uint32_t HashString(const char *str) {
+    uint32_t hash = 2166136261u;
+    while (*str) hash = (hash ^ (unsigned char)*str++) * 16777619u;
+    return hash;
+}
+
+void FreeStringDictionary(StringDictionary *dict) {
+    free(dict->Entries);
+    free(dict->Codes);
+    memset(dict, 0, sizeof(*dict));
+}
+
+// Assigns every distinct string of the column a code in order of first appearance. Fails
+// (leaving nothing to free) once the column has too many distinct values to be worth it.
+bool BuildStringDictionary(const Table *table, size_t col, StringDictionary *dict) {
+    size_t rows = table->RowCount;
+    size_t limit = rows / 2 < DICT_MAX_ENTRIES ? rows / 2 : DICT_MAX_ENTRIES;
+    size_t slots = 16;
+    while (slots < limit * 2) slots *= 2;
+
+    memset(dict, 0, sizeof(*dict));
+    uint32_t *table32 = malloc(sizeof(uint32_t) * slots);
+    dict->Entries = malloc(sizeof(const char *) * (limit ? limit : 1));
+    dict->Codes = malloc(sizeof(uint32_t) * (rows ? rows : 1));
+    if (!table32 || !dict->Entries || !dict->Codes || limit == 0) {
+        free(table32);
+        FreeStringDictionary(dict);
+        return false;
+    }
+    memset(table32, 0xFF, sizeof(uint32_t) * slots);
+
+    for (size_t i = 0; i < rows; ++i) {
+        const char *str = GetCell(table, col, i);
+        size_t slot = HashString(str) & (slots - 1);
+        while (table32[slot] != UINT32_MAX && strcmp(dict->Entries[table32[slot]], str) != 0) {
+            slot = (slot + 1) & (slots - 1);
+        }
+
+        if (table32[slot] == UINT32_MAX) {
+            if (dict->Count == limit) {
+                free(table32);
+                FreeStringDictionary(dict);
+                return false;
+            }
+            table32[slot] = (uint32_t)dict->Count;
+            dict->Entries[dict->Count++] = str;
+        }
+        dict->Codes[i] = table32[slot];
+    }
+
+    free(table32);
+    return true;
+}
+
+// File bytes of a dictionary section: count, offsets, the entries, padding and one
+// bit-packed group of codes per row group.
+static uint64_t DictionarySectionSize(const StringDictionary *dict, size_t rows) {
+    uint64_t size = sizeof(uint64_t) * (dict->Count + 2);
+    for (size_t e = 0; e < dict->Count; ++e) size += strlen(dict->Entries[e]) + 1;
+    size = (size + 7) & ~(uint64_t)7;
+
+    int width = BitWidth(dict->Count > 0 ? dict->Count - 1 : 0);
+    for (size_t begin = 0; begin < rows; begin += ZONE_ROWS) {
+        size_t count = rows - begin < ZONE_ROWS ? rows - begin : ZONE_ROWS;
+        size += BitpackedSize(count, width);
+    }
+    return size;
+}
+
+// Whether a dictionary section would save enough over plain offsets plus strings.
+bool DictionaryPaysOff(const StringDictionary *dict, const Table *table, size_t col) {
+    uint64_t plain = sizeof(uint64_t) * (table->RowCount + 1);
+    for (size_t i = 0; i < table->RowCount; ++i) plain += strlen(GetCell(table, col, i)) + 1;
+    return DictionarySectionSize(dict, table->RowCount) * 100 <= plain * (100 - CODEC_MIN_SAVING_PERCENT);
+}
@@ -0,0 +1,557 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#include "functions.h"
+#include "database.h"
+
+#define MAX_TOKEN 256
+
+// Relative per-row costs used to order conditions. String compares chase an arena pointer
+// and walk bytes; index-backed comparisons are answered without touching the column.
+#define COST_NUMERIC 1.0
+#define COST_STRING  4.0
+#define COST_INDEXED 0.25
+
+typedef enum {
+    TOK_END, TOK_WORD, TOK_OPERATOR, TOK_LPAREN, TOK_RPAREN
+} TokenType;
+
+typedef struct {
+    const Table *Table;
+    const char *Cursor;
+    TokenType Type;
+    bool Quoted;
+    char Token[MAX_TOKEN];
+    bool Failed;
+    size_t *Parameters;       // ? placeholders numbered so far; NULL if ? is an ordinary value
+} Parser;
+
+static bool IsOperatorChar(char c) {
+    return c == '=' || c == '!' || c == '<' || c == '>';
+}
+
+static void NextToken(Parser *parser) {
+    const char *p = parser->Cursor;
+    while (isspace((unsigned char)*p)) p++;
+
+    size_t len = 0;
+    parser->Quoted = false;
+    if (*p == '\0') {
+        parser->Type = TOK_END;
+    } else if (*p == '(' || *p == ')') {
+        parser->Type = *p == '(' ? TOK_LPAREN : TOK_RPAREN;
+        parser->Token[len++] = *p++;
+    } else if (IsOperatorChar(*p)) {
+        parser->Type = TOK_OPERATOR;
+        while (IsOperatorChar(*p) && len < 2) parser->Token[len++] = *p++;
+    } else if (*p == '\'' || *p == '"') {
+        // Quoted values may hold spaces, parentheses and keywords.
+        char quote = *p++;
+        parser->Type = TOK_WORD;
+        parser->Quoted = true;
+        while (*p && *p != quote && len < MAX_TOKEN - 1) parser->Token[len++] = *p++;
+        if (*p == quote) p++;
+    } else {
+        parser->Type = TOK_WORD;
+        while (*p && !isspace((unsigned char)*p) && *p != '(' && *p != ')' && !IsOperatorChar(*p) &&
+               len < MAX_TOKEN - 1) {
+            parser->Token[len++] = *p++;
+        }
+    }
+
+    parser->Token[len] = '\0';
+    parser->Cursor = p;
+}
+
+static bool IsKeyword(const Parser *parser, const char *keyword) {
+    if (parser->Type != TOK_WORD || parser->Quoted) return false;
+    const char *a = parser->Token;
+    for (; *a && *keyword; ++a, ++keyword) {
+        if (toupper((unsigned char)*a) != *keyword) return false;
+    }
+    return *a == '\0' && *keyword == '\0';
+}
+
+static void SyntaxError(Parser *parser, const char *expected) {
+    if (parser->Failed) return;
+    parser->Failed = true;
+    if (parser->Type == TOK_END) {
+        printf("Invalid condition: expected %s at end of input.\n", expected);
+    } else {
+        printf("Invalid condition: expected %s near '%s'.\n", expected, parser->Token);
+    }
+}
+
+static Condition *NewCondition(ConditionKind kind) {
+    Condition *cond = calloc(1, sizeof(Condition));
+    if (cond) cond->Kind = kind;
+    return cond;
+}
+
+static bool AddChild(Condition *parent, Condition *child) {
+    Condition **children = realloc(parent->Children, sizeof(Condition *) * (parent->ChildCount + 1));
+    if (!children) return false;
+    parent->Children = children;
+    parent->Children[parent->ChildCount++] = child;
+    return true;
+}
+
+static Condition *ParseOr(Parser *parser);
+
+// comparison := column operator value
+static Condition *ParseComparison(Parser *parser) {
+    if (parser->Type != TOK_WORD) {
+        SyntaxError(parser, "a column name");
+        return NULL;
+    }
+
+    int col = FindColumn(parser->Table, parser->Token);
+    if (col == -1) {
+        printf("Column '%s' not found in table '%s'.\n", parser->Token, parser->Table->TableName);
+        parser->Failed = true;
+        return NULL;
+    }
+
+    NextToken(parser);
+    CompareOperator op = parser->Type == TOK_OPERATOR ? ParseOperator(parser->Token) : OP_UNKNOWN;
+    if (op == OP_UNKNOWN) {
+        SyntaxError(parser, "an operator (=, !=, >, <, >=, <=)");
+        return NULL;
+    }
+
+    NextToken(parser);
+    if (parser->Type != TOK_WORD) {
+        SyntaxError(parser, "a value");
+        return NULL;
+    }
+
+    Condition *cond = NewCondition(COND_PREDICATE);
+    if (!cond) return NULL;
+    cond->Parameter = SIZE_MAX;
+
+    // A placeholder is compiled when its value is bound; planning only needs the column.
+    if (parser->Parameters && !parser->Quoted && strcmp(parser->Token, "?") == 0) {
+        cond->Parameter = (*parser->Parameters)++;
+        cond->Pred.Column = (size_t)col;
+        cond->Pred.Type = parser->Table->Attributes[col].AttributeType;
+        cond->Pred.Op = op;
+        NextToken(parser);
+        return cond;
+    }
+
+    cond->Literal = strdup(parser->Token);
+    if (!cond->Literal || !CompilePredicate(parser->Table, col, op, parser->Token, &cond->Pred)) {
+        free(cond->Literal);
+        free(cond);
+        parser->Failed = true;
+        return NULL;
+    }
+
+    NextToken(parser);
+    return cond;
+}
+
+// unary := NOT unary | '(' or ')' | comparison
+static Condition *ParseUnary(Parser *parser) {
+    if (IsKeyword(parser, "NOT")) {
+        NextToken(parser);
+        Condition *child = ParseUnary(parser);
+        if (!child) return NULL;
+
+        Condition *cond = NewCondition(COND_NOT);
+        if (!cond || !AddChild(cond, child)) {
+            FreeCondition(child);
+            FreeCondition(cond);
+            return NULL;
+        }
+        return cond;
+    }
+
+    if (parser->Type == TOK_LPAREN) {
+        NextToken(parser);
+        Condition *cond = ParseOr(parser);
+        if (!cond) return NULL;
+        if (parser->Type != TOK_RPAREN) {
+            SyntaxError(parser, "')'");
+            FreeCondition(cond);
+            return NULL;
+        }
+        NextToken(parser);
+        return cond;
+    }
+
+    return ParseComparison(parser);
+}
+
+// Parses `operand (keyword operand)*` into one flat node, so `a AND b AND c` has three
+// children that can be reordered freely.
+static Condition *ParseChain(Parser *parser, ConditionKind kind, const char *keyword,
+                             Condition *(*parseOperand)(Parser *)) {
+    Condition *first = parseOperand(parser);
+    if (!first || !IsKeyword(parser, keyword)) return first;
+
+    Condition *cond = NewCondition(kind);
+    if (!cond || !AddChild(cond, first)) {
+        FreeCondition(first);
+        FreeCondition(cond);
+        return NULL;
+    }
+
+    while (IsKeyword(parser, keyword)) {
+        NextToken(parser);
+        Condition *next = parseOperand(parser);
+        if (!next || !AddChild(cond, next)) {
+            FreeCondition(next);
+            FreeCondition(cond);
+            return NULL;
+        }
+    }
+    return cond;
+}
+
+static Condition *ParseAnd(Parser *parser) {
+    return ParseChain(parser, COND_AND, "AND", ParseUnary);
+}
+
+static Condition *ParseOr(Parser *parser) {
+    return ParseChain(parser, COND_OR, "OR", ParseAnd);
+}
+
+// Orders AND children by cost per row they rule out and OR children by cost per row they
+// settle, so each child runs on as few rows as possible.
+static double AndRank(const Condition *cond) {
+    return cond->Cost / (1.0 - cond->Selectivity + 1e-9);
+}
+
+static double OrRank(const Condition *cond) {
+    return cond->Cost / (cond->Selectivity + 1e-9);
+}
+
+static int CompareAndRank(const void *a, const void *b) {
+    double x = AndRank(*(Condition *const *)a), y = AndRank(*(Condition *const *)b);
+    return x < y ? -1 : x > y;
+}
+
+static int CompareOrRank(const void *a, const void *b) {
+    double x = OrRank(*(Condition *const *)a), y = OrRank(*(Condition *const *)b);
+    return x < y ? -1 : x > y;
+}
+
+// Fills in selectivity and cost estimates bottom-up and sorts AND/OR children by them.
+static void PlanCondition(const Table *table, Condition *cond) {
+    switch (cond->Kind) {
+        case COND_PREDICATE: {
+            switch (cond->Pred.Op) {
+                case OP_EQ: cond->Selectivity = 0.1; break;
+                case OP_NEQ: cond->Selectivity = 0.9; break;
+                default: cond->Selectivity = 0.33; break;
+            }
+            cond->IndexBacked = IndexCanAnswer(table, cond->Pred.Column, cond->Pred.Op);
+            cond->Cost = cond->IndexBacked ? COST_INDEXED :
+                         cond->Pred.Type == DT_STRING && !table->Columns[cond->Pred.Column].Dict ? COST_STRING :
+                         COST_NUMERIC;
+            break;
+        }
+        case COND_NOT:
+            PlanCondition(table, cond->Children[0]);
+            cond->Selectivity = 1.0 - cond->Children[0]->Selectivity;
+            cond->Cost = cond->Children[0]->Cost;
+            break;
+        case COND_AND:
+        case COND_OR: {
+            double selectivity = 1.0, cost = 0.0;
+            for (size_t i = 0; i < cond->ChildCount; ++i) {
+                Condition *child = cond->Children[i];
+                PlanCondition(table, child);
+                cost += child->Cost;
+                selectivity *= cond->Kind == COND_AND ? child->Selectivity : 1.0 - child->Selectivity;
+            }
+            cond->Selectivity = cond->Kind == COND_AND ? selectivity : 1.0 - selectivity;
+            cond->Cost = cost;
+            qsort(cond->Children, cond->ChildCount, sizeof(Condition *),
+                  cond->Kind == COND_AND ? CompareAndRank : CompareOrRank);
+            break;
+        }
+    }
+}
+
+static Condition *ParseText(const Table *table, const char *text, size_t *parameters) {
+    if (!table || !text) return NULL;
+
+    Parser parser = {0};
+    parser.Table = table;
+    parser.Cursor = text;
+    parser.Parameters = parameters;
+    NextToken(&parser);
+
+    Condition *cond = ParseOr(&parser);
+    if (cond && parser.Type != TOK_END) {
+        SyntaxError(&parser, "AND, OR or end of condition");
+        FreeCondition(cond);
+        return NULL;
+    }
+    if (!cond) {
+        if (!parser.Failed) printf("Invalid condition.\n");
+        return NULL;
+    }
+
+    PlanCondition(table, cond);
+    return cond;
+}
+
+Condition *ParseCondition(const Table *table, const char *text) {
+    return ParseText(table, text, NULL);
+}
+
+// Parses a condition whose values may be ? placeholders, numbered from *parameterCount on,
+// which is advanced past them. The condition is parsed and its columns resolved once; the
+// placeholders are filled in by BindCondition before each evaluation.
+Condition *PrepareCondition(const Table *table, const char *text, size_t *parameterCount) {
+    return ParseText(table, text, parameterCount);
+}
+
+static bool BindPlaceholders(const Table *table, Condition *cond, const char *const *values) {
+    if (cond->Kind != COND_PREDICATE) {
+        for (size_t i = 0; i < cond->ChildCount; ++i) {
+            if (!BindPlaceholders(table, cond->Children[i], values)) return false;
+        }
+        return true;
+    }
+
+    // Literals written into the text are compiled again too: a DICT predicate holds codes
+    // and a match table sized to the dictionary, both of which go stale as values are added
+    // or the dictionary is compacted.
+    size_t col = cond->Pred.Column;
+    CompareOperator op = cond->Pred.Op;
+    FreePredicate(&cond->Pred);
+    if (cond->Parameter != SIZE_MAX) {
+        free(cond->Literal);
+        cond->Literal = strdup(values[cond->Parameter]);
+    }
+    if (!cond->Literal || !CompilePredicate(table, col, op, cond->Literal, &cond->Pred)) {
+        cond->Pred.Column = col;
+        cond->Pred.Type = table->Attributes[col].AttributeType;
+        cond->Pred.Op = op;
+        return false;
+    }
+    return true;
+}
+
+// Compiles every predicate of cond again, placeholders with their value from values, indexed
+// by placeholder number, and plans the condition again in case indexes came or went since it
+// was prepared. Returns false if a value cannot be compiled.
+bool BindCondition(const Table *table, Condition *cond, const char *const *values) {
+    if (!BindPlaceholders(table, cond, values)) return false;
+    PlanCondition(table, cond);
+    return true;
+}
+
+void FreeCondition(Condition *cond) {
+    if (!cond) return;
+
+    if (cond->Kind == COND_PREDICATE) {
+        FreePredicate(&cond->Pred);
+        free(cond->Literal);
+    }
+    for (size_t i = 0; i < cond->ChildCount; ++i) FreeCondition(cond->Children[i]);
+    free(cond->Children);
+    free(cond);
+}
+
+static void NumberNodes(Condition *cond, size_t *next) {
+    cond->Id = (*next)++;
+    for (size_t i = 0; i < cond->ChildCount; ++i) NumberNodes(cond->Children[i], next);
+}
+
+// AND/OR/NOT nodes each need two block-sized selection vectors; every worker evaluating the
+// tree carries its own set, found through the node ids.
+#define NODE_SCRATCH(scratch, cond, k) ((scratch) + ((cond)->Id * 2 + (k)) * SCAN_BLOCK_ROWS)
+
+// Selection vectors are sorted row ids. A NULL input stands for every row in [begin, end).
+#define INPUT_ROW(in, begin, k) ((in) ? (in)[k] : (begin) + (k))
+
+// Writes the rows of the input that are not in minus (a sorted subset of it) to out.
+static size_t Difference(size_t begin, const size_t *in, size_t count, const size_t *minus, size_t minusCount,
+                         size_t *out) {
+    size_t n = 0, m = 0;
+    for (size_t k = 0; k < count; ++k) {
+        size_t row = INPUT_ROW(in, begin, k);
+        if (m < minusCount && minus[m] == row) {
+            m++;
+            continue;
+        }
+        out[n++] = row;
+    }
+    return n;
+}
+
+static size_t EvaluateNode(const Condition *cond, const Table *table, size_t *scratch, size_t begin,
+                           const size_t *in, size_t count, size_t *out);
+
+// Runs the children one after another, each on what the previous ones let through; skip
+// names a child whose rows are already the input.
+static size_t EvaluateAnd(const Condition *cond, const Table *table, size_t *scratch, size_t begin,
+                          const size_t *in, size_t count, size_t skip, size_t *out) {
+    size_t last = cond->ChildCount - 1;
+    if (skip == last) last--;
+
+    const size_t *current = in;
+    size_t flip = 0;
+    for (size_t i = 0; i <= last; ++i) {
+        if (i == skip) continue;
+        size_t *dest = i == last ? out : NODE_SCRATCH(scratch, cond, flip);
+        count = EvaluateNode(cond->Children[i], table, scratch, begin, current, count, dest);
+        if (count == 0) return 0;
+        current = dest;
+        flip ^= 1;
+    }
+    if (current != out) memcpy(out, current, sizeof(size_t) * count);
+    return count;
+}
+
+// Each child only tests rows no earlier child matched; the result is whatever left the
+// pending set.
+static size_t EvaluateOr(const Condition *cond, const Table *table, size_t *scratch, size_t begin,
+                         const size_t *in, size_t count, size_t *out) {
+    size_t *pending = NODE_SCRATCH(scratch, cond, 0), *hits = NODE_SCRATCH(scratch, cond, 1);
+    size_t pendingCount = count;
+    for (size_t k = 0; k < count; ++k) pending[k] = INPUT_ROW(in, begin, k);
+
+    for (size_t i = 0; i < cond->ChildCount && pendingCount > 0; ++i) {
+        size_t hitCount = EvaluateNode(cond->Children[i], table, scratch, begin, pending, pendingCount, hits);
+        if (hitCount > 0) pendingCount = Difference(begin, pending, pendingCount, hits, hitCount, pending);
+    }
+
+    return Difference(begin, in, count, pending, pendingCount, out);
+}
+
+static size_t EvaluateNode(const Condition *cond, const Table *table, size_t *scratch, size_t begin,
+                           const size_t *in, size_t count, size_t *out) {
+    switch (cond->Kind) {
+        case COND_PREDICATE:
+            return in ? RefinePredicate(&cond->Pred, table, in, count, out)
+                      : RunPredicate(&cond->Pred, table, begin, begin + count, out);
+        case COND_AND:
+            return EvaluateAnd(cond, table, scratch, begin, in, count, SIZE_MAX, out);
+        case COND_OR:
+            return EvaluateOr(cond, table, scratch, begin, in, count, out);
+        case COND_NOT: {
+            size_t *hits = NODE_SCRATCH(scratch, cond, 0);
+            size_t hitCount = EvaluateNode(cond->Children[0], table, scratch, begin, in, count, hits);
+            return Difference(begin, in, count, hits, hitCount, out);
+        }
+    }
+    return 0;
+}
+
+// Looks for a comparison an index can answer: the whole condition, or the first such
+// conjunct of a top-level AND. Returns its position (0 for a lone comparison) or SIZE_MAX.
+static size_t FindIndexedConjunct(const Condition *cond, Table *table, size_t **candidates, size_t *count) {
+    if (cond->Kind == COND_PREDICATE) {
+        if (!cond->IndexBacked) return SIZE_MAX;
+        *count = IndexLookup(table, cond->Pred.Column, cond->Pred.Op, cond->Literal, candidates);
+        return *count == (size_t)-1 ? SIZE_MAX : 0;
+    }
+    if (cond->Kind != COND_AND) return SIZE_MAX;
+
+    for (size_t i = 0; i < cond->ChildCount; ++i) {
+        const Condition *child = cond->Children[i];
+        if (child->Kind != COND_PREDICATE || !child->IndexBacked) continue;
+        *count = IndexLookup(table, child->Pred.Column, child->Pred.Op, child->Literal, candidates);
+        if (*count != (size_t)-1) return i;
+    }
+    return SIZE_MAX;
+}
+
+// Whether zone maps leave any chance of a match in [begin, end). NOT is not inverted
+// through min/max and always may match.
+static bool ConditionMayMatch(const Condition *cond, const Table *table, size_t begin, size_t end) {
+    switch (cond->Kind) {
+        case COND_PREDICATE:
+            return ZonesMayMatch(&cond->Pred, table, begin, end);
+        case COND_AND:
+            for (size_t i = 0; i < cond->ChildCount; ++i) {
+                if (!ConditionMayMatch(cond->Children[i], table, begin, end)) return false;
+            }
+            return true;
+        case COND_OR:
+            for (size_t i = 0; i < cond->ChildCount; ++i) {
+                if (ConditionMayMatch(cond->Children[i], table, begin, end)) return true;
+            }
+            return false;
+        case COND_NOT:
+            return true;
+    }
+    return true;
+}
+
+typedef struct {
+    const Condition *Cond;
+    const Table *Table;
+    const size_t *Candidates;   // index results to test instead of every row, or NULL
+    size_t Skip;                // conjunct the candidates already satisfy
+    size_t ScratchSize;
+    size_t **Scratch;           // one set of node vectors per worker, made on first use
+} ConditionScan;
+
+static size_t EvaluateMorsel(void *context, size_t worker, size_t begin, size_t end, size_t *out) {
+    ConditionScan *scan = context;
+    if (!scan->Scratch[worker]) {
+        scan->Scratch[worker] = malloc(sizeof(size_t) * scan->ScratchSize);
+        if (!scan->Scratch[worker]) return (size_t)-1;
+    }
+    size_t *scratch = scan->Scratch[worker];
+
+    size_t count = 0;
+    for (size_t block = begin; block < end; block += SCAN_BLOCK_ROWS) {
+        size_t blockEnd = block + SCAN_BLOCK_ROWS < end ? block + SCAN_BLOCK_ROWS : end;
+
+        if (scan->Candidates) {
+            // Index results never include tombstoned rows.
+            count += EvaluateAnd(scan->Cond, scan->Table, scratch, 0, scan->Candidates + block, blockEnd - block,
+                                 scan->Skip, out + count);
+        } else {
+            if (!ConditionMayMatch(scan->Cond, scan->Table, block, blockEnd)) continue;
+            size_t matched = EvaluateNode(scan->Cond, scan->Table, scratch, block, NULL, blockEnd - block, out + count);
+            if (scan->Table->DeletedCount) matched = DropDeletedRows(scan->Table, out + count, matched);
+            count += matched;
+        }
+    }
+    return count;
+}
+
+// Collects the ascending ids of live rows matching the condition in one pass over the
+// table, split into morsels across the scan threads. When an index answers a top-level
+// comparison, only its rows are tested against the rest of the condition. Returns
+// (size_t)-1 if memory runs out.
+size_t EvaluateCondition(Table *table, Condition *cond, size_t **rows) {
+    *rows = NULL;
+    if (!table || !cond) return 0;
+
+    size_t *candidates = NULL, candidateCount = 0;
+    size_t indexed = FindIndexedConjunct(cond, table, &candidates, &candidateCount);
+    if (indexed != SIZE_MAX && cond->Kind == COND_PREDICATE) {
+        *rows = candidates;
+        return candidateCount;
+    }
+
+    size_t nodes = 0;
+    NumberNodes(cond, &nodes);
+
+    ConditionScan scan = {cond, table, indexed != SIZE_MAX ? candidates : NULL, indexed, nodes * 2 * SCAN_BLOCK_ROWS, NULL};
+    scan.Scratch = calloc(GetScanThreads(), sizeof(size_t *));
+    size_t count = (size_t)-1;
+    if (!scan.Scratch) {
+        printf("Out of memory scanning rows.\n");
+    } else {
+        count = ParallelScan(scan.Candidates ? candidateCount : table->RowCount, EvaluateMorsel, &scan, rows);
+        for (size_t w = 0; w < GetScanThreads(); ++w) free(scan.Scratch[w]);
+        free(scan.Scratch);
+    }
+    free(candidates);
+    return count;
+}
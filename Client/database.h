@@ -1,44 +1,151 @@
-#ifndef DATABASE_H
-#define DATABASE_H
-
-
-typedef enum {
-    DT_INT,
-    DT_UINT,
-    DT_FLOAT,
-    DT_STRING,
-} DataTypes;
-
-typedef struct {
-    char *AttributeName;
-    DataTypes AttributeType;
-} Attribute;
-
-typedef struct {
-    void **values;
-} Row;
-
-typedef struct {
-    char *TableName;
-    Attribute *Attributes;
-    size_t AttributeCount;
-
-    Row *Rows;
-    size_t RowCount;
-    size_t RowCapacity;
-} Table;
-
-typedef struct {
-    char *DatabaseName;
-    Table *Tables;
-    size_t TableCount;
-    size_t TableCapacity;
-} Database;
-
-typedef struct {
-    Database *Databases;
-    size_t DatabaseCount;
-    size_t DatabaseCapacity;
-} Schema;
-
-#endif
+#ifndef DATABASE_H
+#define DATABASE_H
+#include <stddef.h>
+#include <stdint.h>
+
+
+typedef enum {
+    DT_INT,
+    DT_UINT,
+    DT_FLOAT,
+    DT_STRING,
+} DataTypes;
+
+typedef struct {
+    char *AttributeName;
+    DataTypes AttributeType;
+} Attribute;
+
+// Strings live in a per-table arena and are addressed by chunk index and offset,
+// so refs stay valid while the chunk list grows.
+typedef uint64_t StringRef;
+
+#define ARENA_OFFSET_BITS   40
+#define ARENA_OFFSET_MASK   ((((uint64_t)1) << ARENA_OFFSET_BITS) - 1)
+#define ARENA_NULL_REF      UINT64_MAX
+#define ARENA_SIZE_CLASSES  64
+
+typedef struct {
+    char *Base;
+    size_t Size;
+    size_t Capacity;
+    int Borrowed;       // read-only memory owned by someone else, e.g. a mapped table file
+} ArenaChunk;
+
+typedef struct {
+    ArenaChunk *Chunks;
+    size_t ChunkCount;
+    size_t ChunkCapacity;
+
+    StringRef FreeLists[ARENA_SIZE_CLASSES];
+
+    size_t BytesReserved;
+    size_t BytesUsed;
+    size_t BytesLive;
+    size_t BytesFree;
+} Arena;
+
+typedef struct {
+    size_t ChunkCount;
+    size_t BytesReserved;
+    size_t BytesLive;
+    size_t BytesFree;
+    size_t BytesWaste;
+} ArenaStats;
+
+static inline char *ArenaString(const Arena *arena, StringRef ref) {
+    return arena->Chunks[ref >> ARENA_OFFSET_BITS].Base + (ref & ARENA_OFFSET_MASK);
+}
+
+// Secondary index entry: an order-preserving encoding of the column value plus the row it
+// came from. The tree itself lives in data/<table>.<column>.idx and is opaque here.
+typedef struct {
+    uint64_t Key;
+    uint64_t Row;
+} BTreeEntry;
+
+typedef struct BTree BTree;
+typedef struct HashIndex HashIndex;
+typedef struct TableMapping TableMapping;
+typedef struct TableLog TableLog;
+
+// Smallest and largest index key (see EncodeIndexKey) in a group of ZONE_ROWS rows, so
+// scans can skip groups a filter cannot match.
+#define ZONE_ROWS 4096
+
+typedef struct {
+    uint64_t Min;
+    uint64_t Max;
+} ZoneMap;
+
+// Distinct values of an interned STRING column, each stored once in the table arena.
+// Slots is an open-addressing hash from string to code, UINT32_MAX where empty.
+typedef struct {
+    StringRef *Entries;
+    size_t Count;
+    size_t Capacity;
+    uint32_t *Slots;
+    size_t SlotCount;
+} ColumnDictionary;
+
+// One contiguous array per attribute. INT/UINT/FLOAT columns hold the values
+// directly; STRING columns hold a StringRef per row into the table arena, or a uint32
+// code into Dict when the column is interned.
+typedef struct {
+    void *Values;
+    int Mapped;         // Values point into the table file mapping and are copied before writes
+    ColumnDictionary *Dict;
+    ZoneMap *Zones;
+    BTree *Index;
+    HashIndex *Hash;
+} Column;
+
+typedef struct {
+    char *TableName;
+    Attribute *Attributes;
+    size_t AttributeCount;
+
+    // Open-addressing hash from column name to index, UINT32_MAX where empty, rebuilt
+    // whenever columns are added or dropped. SchemaVersion changes with every rebuild so
+    // column handles resolved before it can be told apart.
+    uint32_t *ColumnSlots;
+    size_t ColumnSlotCount;
+    uint64_t SchemaVersion;
+
+    Column *Columns;
+    size_t RowCount;
+    size_t RowCapacity;
+
+    // Deleted rows stay in place with their bit set until the table is compacted.
+    // RowCount includes them; the bitmap is NULL until the first delete.
+    uint64_t *Deleted;
+    size_t DeletedCount;
+
+    Arena Strings;
+
+    // Read-only view of the file the table was loaded from, NULL once nothing refers to it.
+    TableMapping *Mapping;
+
+    // Write-ahead log of changes since the table file was last written; NULL for tables
+    // that have never been saved or loaded.
+    TableLog *Log;
+} Table;
+
+static inline int IsRowDeleted(const Table *table, size_t row) {
+    return table->Deleted && ((table->Deleted[row >> 6] >> (row & 63)) & 1);
+}
+
+typedef struct {
+    char *DatabaseName;
+    Table *Tables;
+    size_t TableCount;
+    size_t TableCapacity;
+} Database;
+
+typedef struct {
+    Database *Databases;
+    size_t DatabaseCount;
+    size_t DatabaseCapacity;
+} Schema;
+
+#endif
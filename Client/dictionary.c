@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "functions.h"
+#include "database.h"
+
+// Interned STRING columns: every distinct value is stored once and rows hold a 4-byte code,
+// so low-cardinality columns take a fraction of the memory and equality filters compare
+// integers instead of strings. Codes are handed out in order of first appearance and stay
+// stable until the strings are compacted, which drops values no row uses any more.
+
+#define DICT_FIRST_SLOTS 64
+#define DICT_NO_CODE     UINT32_MAX
+
+static uint32_t HashString(const char *str) {
+    uint32_t hash = 2166136261u;
+    while (*str) hash = (hash ^ (unsigned char)*str++) * 16777619u;
+    return hash;
+}
+
+// Slot holding str, or the empty slot where it would go.
+static size_t FindSlot(const ColumnDictionary *dict, const Arena *arena, const char *str) {
+    size_t mask = dict->SlotCount - 1;
+    size_t slot = HashString(str) & mask;
+    while (dict->Slots[slot] != DICT_NO_CODE &&
+           strcmp(ArenaString(arena, dict->Entries[dict->Slots[slot]]), str) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Slots for entries values at most half full.
+static size_t SlotCountFor(size_t entries) {
+    size_t slotCount = DICT_FIRST_SLOTS;
+    while (slotCount < entries * 2) slotCount *= 2;
+    return slotCount;
+}
+
+static void FillSlots(ColumnDictionary *dict, const Arena *arena) {
+    memset(dict->Slots, 0xFF, sizeof(uint32_t) * dict->SlotCount);
+    for (size_t code = 0; code < dict->Count; ++code) {
+        dict->Slots[FindSlot(dict, arena, ArenaString(arena, dict->Entries[code]))] = (uint32_t)code;
+    }
+}
+
+// Sizes the hash for at least entries values at most half full and fills it from Entries.
+static bool Rehash(ColumnDictionary *dict, const Arena *arena, size_t entries) {
+    size_t slotCount = SlotCountFor(entries);
+
+    if (slotCount != dict->SlotCount) {
+        uint32_t *slots = realloc(dict->Slots, sizeof(uint32_t) * slotCount);
+        if (!slots) return false;
+        dict->Slots = slots;
+        dict->SlotCount = slotCount;
+    }
+    FillSlots(dict, arena);
+    return true;
+}
+
+static ColumnDictionary *CreateDictionary(const Arena *arena) {
+    ColumnDictionary *dict = calloc(1, sizeof(ColumnDictionary));
+    if (!dict) return NULL;
+    if (!Rehash(dict, arena, 0)) {
+        free(dict);
+        return NULL;
+    }
+    return dict;
+}
+
+void FreeColumnDictionary(ColumnDictionary *dict) {
+    if (!dict) return;
+    free(dict->Entries);
+    free(dict->Slots);
+    free(dict);
+}
+
+// Adds a value already stored in the table arena as the next code. Used when loading, where
+// entries are known to be distinct; everything else goes through InternString.
+bool AddDictionaryEntry(Table *table, size_t col, StringRef ref, uint32_t *code) {
+    ColumnDictionary *dict = table->Columns[col].Dict;
+    if (dict->Count >= DICT_NO_CODE) return false;
+
+    if (dict->Count == dict->Capacity) {
+        size_t capacity = dict->Capacity ? dict->Capacity * 2 : DICT_FIRST_SLOTS / 2;
+        StringRef *entries = realloc(dict->Entries, sizeof(StringRef) * capacity);
+        if (!entries) return false;
+        dict->Entries = entries;
+        dict->Capacity = capacity;
+    }
+    if ((dict->Count + 1) * 2 > dict->SlotCount && !Rehash(dict, &table->Strings, dict->Count + 1)) return false;
+
+    const char *str = ArenaString(&table->Strings, ref);
+    size_t slot = FindSlot(dict, &table->Strings, str);
+    dict->Entries[dict->Count] = ref;
+    if (dict->Slots[slot] == DICT_NO_CODE) dict->Slots[slot] = (uint32_t)dict->Count;
+    *code = (uint32_t)dict->Count++;
+    return true;
+}
+
+// Code of str in an interned column, or UINT32_MAX if no row has ever held it.
+uint32_t FindDictionaryCode(const Table *table, size_t col, const char *str) {
+    const ColumnDictionary *dict = table->Columns[col].Dict;
+    return dict->Slots[FindSlot(dict, &table->Strings, str)];
+}
+
+// Code of str in an interned column, adding it to the dictionary if it is new.
+bool InternString(Table *table, size_t col, const char *str, uint32_t *code) {
+    *code = FindDictionaryCode(table, col, str);
+    if (*code != DICT_NO_CODE) return true;
+
+    StringRef ref;
+    if (!ArenaStoreString(&table->Strings, str, strlen(str), &ref)) return false;
+    if (!AddDictionaryEntry(table, col, ref, code)) {
+        ArenaFreeString(&table->Strings, ref);
+        return false;
+    }
+    return true;
+}
+
+const char *DictionaryString(const Table *table, size_t col, uint32_t code) {
+    return ArenaString(&table->Strings, table->Columns[col].Dict->Entries[code]);
+}
+
+// Turns a STRING column into an interned one, replacing each row's own copy of its value
+// with a code. Columns that are already interned are left alone.
+bool InternColumn(Table *table, size_t col) {
+    Column *column = &table->Columns[col];
+    if (table->Attributes[col].AttributeType != DT_STRING) {
+        printf("Only STRING columns can be interned.\n");
+        return false;
+    }
+    if (column->Dict) return true;
+
+    uint32_t *codes = malloc(sizeof(uint32_t) * (table->RowCapacity ? table->RowCapacity : 1));
+    column->Dict = CreateDictionary(&table->Strings);
+    if (!codes || !column->Dict) {
+        free(codes);
+        FreeColumnDictionary(column->Dict);
+        column->Dict = NULL;
+        return false;
+    }
+
+    StringRef *refs = column->Values;
+    for (size_t i = 0; i < table->RowCount; ++i) {
+        if (!InternString(table, col, ArenaString(&table->Strings, refs[i]), &codes[i])) {
+            // Entries added so far stay in the arena until the next compaction.
+            free(codes);
+            FreeColumnDictionary(column->Dict);
+            column->Dict = NULL;
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < table->RowCount; ++i) ArenaFreeString(&table->Strings, refs[i]);
+    free(column->Values);
+    column->Values = codes;
+    return true;
+}
+
+// Frees the strings of an interned column that is being dropped.
+void ReleaseColumnDictionary(Table *table, size_t col) {
+    ColumnDictionary *dict = table->Columns[col].Dict;
+    for (size_t code = 0; code < dict->Count; ++code) ArenaFreeString(&table->Strings, dict->Entries[code]);
+    FreeColumnDictionary(dict);
+    table->Columns[col].Dict = NULL;
+}
+
+// Copies the values rows still use into another arena, numbered in order of first appearance,
+// without touching the column; values left behind by UPDATE and DELETE are dropped. Everything
+// the switch-over needs is allocated here, so CommitDictionaryCompaction cannot fail and the
+// caller can stage several columns before committing any.
+bool StageDictionaryCompaction(const Table *table, size_t col, Arena *into, DictionaryCompaction *staged) {
+    const ColumnDictionary *dict = table->Columns[col].Dict;
+    const uint32_t *codes = table->Columns[col].Values;
+    size_t entries = dict->Count ? dict->Count : 1;
+
+    memset(staged, 0, sizeof(DictionaryCompaction));
+    staged->Remap = malloc(sizeof(uint32_t) * entries);
+    staged->Entries = malloc(sizeof(StringRef) * entries);
+    if (!staged->Remap || !staged->Entries) {
+        DiscardDictionaryCompaction(staged);
+        return false;
+    }
+    memset(staged->Remap, 0xFF, sizeof(uint32_t) * dict->Count);
+
+    for (size_t i = 0; i < table->RowCount; ++i) {
+        uint32_t code = codes[i];
+        if (staged->Remap[code] != DICT_NO_CODE) continue;
+
+        const char *str = ArenaString(&table->Strings, dict->Entries[code]);
+        if (!ArenaStoreString(into, str, strlen(str), &staged->Entries[staged->Count])) {
+            DiscardDictionaryCompaction(staged);
+            return false;
+        }
+        staged->Remap[code] = (uint32_t)staged->Count++;
+    }
+
+    staged->SlotCount = SlotCountFor(staged->Count);
+    staged->Slots = malloc(sizeof(uint32_t) * staged->SlotCount);
+    if (!staged->Slots) {
+        DiscardDictionaryCompaction(staged);
+        return false;
+    }
+    return true;
+}
+
+// Switches the column over to its staged entries, which live in into.
+void CommitDictionaryCompaction(Table *table, size_t col, const Arena *into, DictionaryCompaction *staged) {
+    ColumnDictionary *dict = table->Columns[col].Dict;
+    uint32_t *codes = table->Columns[col].Values;
+    for (size_t i = 0; i < table->RowCount; ++i) codes[i] = staged->Remap[codes[i]];
+
+    free(dict->Entries);
+    free(dict->Slots);
+    dict->Entries = staged->Entries;
+    dict->Capacity = dict->Count ? dict->Count : 1;
+    dict->Count = staged->Count;
+    dict->Slots = staged->Slots;
+    dict->SlotCount = staged->SlotCount;
+    FillSlots(dict, into);
+
+    free(staged->Remap);
+    memset(staged, 0, sizeof(DictionaryCompaction));
+}
+
+// Frees a staged compaction that will not be committed. Its strings stay in the arena they
+// were copied into.
+void DiscardDictionaryCompaction(DictionaryCompaction *staged) {
+    free(staged->Remap);
+    free(staged->Entries);
+    free(staged->Slots);
+    memset(staged, 0, sizeof(DictionaryCompaction));
+}
@@ -1,885 +1,1261 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdbool.h>
-
-#include <sys/stat.h>
-#include <errno.h>
-#ifdef _WIN32
-    #include <direct.h>
-    #define MAKE_DIR(dir) _mkdir(dir)
-#else
-    #include <sys/stat.h>
-    #define MAKE_DIR(dir) mkdir(dir, 0777)
-#endif
-#include "functions.h"
-#include "database.h"
-
-#define INITIAL_ROW_CAPACITY 4
-
-Table *CreateTable(const char *TableName, Attribute *Attributes, size_t AttributeCount) {
-    Table *table = malloc(sizeof(Table));
-    if (!table) return NULL;
-
-    table->TableName = strdup(TableName);
-    table->AttributeCount = AttributeCount;
-
-    table->Attributes = malloc(sizeof(Attribute) * AttributeCount);
-    for (size_t i = 0; i < AttributeCount; ++i) {
-        table->Attributes[i].AttributeName = strdup(Attributes[i].AttributeName);
-        table->Attributes[i].AttributeType = Attributes[i].AttributeType;
-    }
-
-    table->RowCount = 0;
-    table->RowCapacity = INITIAL_ROW_CAPACITY;
-    table->Rows = malloc(sizeof(Row) * table->RowCapacity);
-    for (size_t i = 0; i < table->RowCapacity; ++i) {
-        table->Rows[i].values = NULL;
-    }
-
-    return table;
-}
-
-void FreeTable(Table *table) {
-    if (!table) return;
-
-    free(table->TableName);
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        free(table->Attributes[i].AttributeName);
-    }
-    free(table->Attributes);
-
-    for (size_t i = 0; i < table->RowCount; ++i) {
-        Row *row = &table->Rows[i];
-        if (row->values) {
-            for (size_t j = 0; j < table->AttributeCount; ++j) {
-                if (table->Attributes[j].AttributeType == DT_STRING) {
-                    free(row->values[j]);
-                } else {
-                    free(row->values[j]);
-                }
-            }
-            free(row->values);
-        }
-    }
-
-    free(table->Rows);
-    free(table);
-}
-
-void DisplayTable(const Table *table) {
-    if (!table) return;
-
-    printf("Table: %s\n", table->TableName);
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        printf("| %-15s ", table->Attributes[i].AttributeName);
-    }
-    printf("|\n");
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        printf("+-----------------");
-    }
-    printf("+\n");
-
-    for (size_t i = 0; i < table->RowCount; ++i) {
-        Row *row = &table->Rows[i];
-        for (size_t j = 0; j < table->AttributeCount; ++j) {
-            void *value = row->values[j];
-            switch (table->Attributes[j].AttributeType) {
-                case DT_INT:
-                    printf("| %-15d ", *(int *)value);
-                    break;
-                case DT_UINT:
-                    printf("| %-15u ", *(unsigned int *)value);
-                    break;
-                case DT_FLOAT:
-                    printf("| %-15.2f ", *(float *)value);
-                    break;
-                case DT_STRING:
-                    printf("| %-15s ", (char *)value);
-                    break;
-            }
-        }
-        printf("|\n");
-    }
-}
-
-void InsertRowFromInput(Table *table) {
-    if (!table) return;
-
-    void **values = malloc(sizeof(void *) * table->AttributeCount);
-    if (!values) {
-        printf("Memory allocation failed.\n");
-        return;
-    }
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        Attribute attr = table->Attributes[i];
-        char buffer[256];
-
-        printf("Enter value for %s (%s): ", attr.AttributeName,
-               attr.AttributeType == DT_INT ? "INT" :
-               attr.AttributeType == DT_UINT ? "UINT" :
-               attr.AttributeType == DT_FLOAT ? "FLOAT" : "STRING");
-
-        scanf("%255s", buffer);
-
-        switch (attr.AttributeType) {
-            case DT_INT: {
-                int *val = malloc(sizeof(int));
-                *val = atoi(buffer);
-                values[i] = val;
-                break;
-            }
-            case DT_UINT: {
-                unsigned int *val = malloc(sizeof(unsigned int));
-                *val = (unsigned int)strtoul(buffer, NULL, 10);
-                values[i] = val;
-                break;
-            }
-            case DT_FLOAT: {
-                float *val = malloc(sizeof(float));
-                *val = strtof(buffer, NULL);
-                values[i] = val;
-                break;
-            }
-            case DT_STRING: {
-                values[i] = strdup(buffer);
-                break;
-            }
-        }
-    }
-
-    if (InsertRow(table, values)) {
-        printf("Row inserted successfully.\n");
-    } else {
-        printf("Row insertion failed.\n");
-    }
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        free(values[i]);
-    }
-    free(values);
-}
-
-bool InsertRow(Table *table, void **values) {
-    if (!table || !values) return false;
-
-
-    if (table->RowCount >= table->RowCapacity) {
-        size_t newCapacity = table->RowCapacity * 2;
-        Row *newRows = realloc(table->Rows, sizeof(Row) * newCapacity);
-        if (!newRows) return false;
-        table->Rows = newRows;
-        table->RowCapacity = newCapacity;
-    }
-
-    Row *newRow = &table->Rows[table->RowCount];
-    newRow->values = malloc(sizeof(void *) * table->AttributeCount);
-    if (!newRow->values) return false;
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        DataTypes type = table->Attributes[i].AttributeType;
-
-        switch (type) {
-            case DT_INT: {
-                int *val = malloc(sizeof(int));
-                *val = *(int *)values[i];
-                newRow->values[i] = val;
-                break;
-            }
-            case DT_UINT: {
-                unsigned int *val = malloc(sizeof(unsigned int));
-                *val = *(unsigned int *)values[i];
-                newRow->values[i] = val;
-                break;
-            }
-            case DT_FLOAT: {
-                float *val = malloc(sizeof(float));
-                *val = *(float *)values[i];
-                newRow->values[i] = val;
-                break;
-            }
-            case DT_STRING: {
-                newRow->values[i] = strdup((char *)values[i]);
-                break;
-            }
-        }
-    }
-
-    table->RowCount++;
-    return true;
-}
-
-bool PromptAndInsertRow(Table *table) {
-    if (!table) return false;
-
-    void **values = malloc(sizeof(void *) * table->AttributeCount);
-    if (!values) return false;
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        DataTypes type = table->Attributes[i].AttributeType;
-        char *attrName = table->Attributes[i].AttributeName;
-
-        printf("Enter value for '%s': ", attrName);
-
-        switch (type) {
-            case DT_INT: {
-                int *val = malloc(sizeof(int));
-                if (!val) return false;
-                scanf("%d", val);
-                values[i] = val;
-                break;
-            }
-            case DT_UINT: {
-                unsigned int *val = malloc(sizeof(unsigned int));
-                if (!val) return false;
-                scanf("%u", val);
-                values[i] = val;
-                break;
-            }
-            case DT_FLOAT: {
-                float *val = malloc(sizeof(float));
-                if (!val) return false;
-                scanf("%f", val);
-                values[i] = val;
-                break;
-            }
-            case DT_STRING: {
-                char buffer[256];
-                scanf("%s", buffer);
-                values[i] = strdup(buffer);  // strdup handles allocation
-                break;
-            }
-        }
-    }
-
-    bool success = InsertRow(table, values);
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        if (table->Attributes[i].AttributeType == DT_STRING) {
-            free(values[i]);  // strdup
-        } else {
-            free(values[i]);  // INT, FLOAT, UINT
-        }
-    }
-    free(values);
-
-    return success;
-}
-
-Table *PromptAndCreateTable() {
-    char tableName[100];
-    size_t columnCount;
-
-    printf("Enter table name: ");
-    scanf("%99s", tableName);  // limit input to avoid buffer overflow
-
-    printf("Enter number of columns: ");
-    scanf("%zu", &columnCount);
-
-    Attribute *attributes = malloc(sizeof(Attribute) * columnCount);
-    if (!attributes) return NULL;
-
-    for (size_t i = 0; i < columnCount; ++i) {
-        char attrName[100];
-        int type;
-
-        printf("Enter name for column %zu: ", i + 1);
-        scanf("%99s", attrName);
-
-        printf("Select type for '%s':\n", attrName);
-        printf(" 0 - INT\n 1 - UINT\n 2 - FLOAT\n 3 - STRING\n");
-        printf("Type: ");
-        scanf("%d", &type);
-
-        attributes[i].AttributeName = strdup(attrName);
-        attributes[i].AttributeType = (DataTypes)type;
-    }
-
-    Table *table = CreateTable(tableName, attributes, columnCount);
-
-    for (size_t i = 0; i < columnCount; ++i) {
-        free(attributes[i].AttributeName);
-    }
-    free(attributes);
-
-    return table;
-}
-
-
-
-bool SaveTableToFile(const Table *table) {
-    if (!table) return false;
-
-
-    MAKE_DIR("data");
-
-    char path[256];
-    snprintf(path, sizeof(path), "data/%s.tbl", table->TableName);
-
-    FILE *file = fopen(path, "wb");
-    if (!file) {
-        perror("Failed to open file for writing");
-        return false;
-    }
-
-
-    size_t nameLen = strlen(table->TableName);
-    fwrite(&nameLen, sizeof(size_t), 1, file);
-    fwrite(table->TableName, sizeof(char), nameLen, file);
-
-
-    fwrite(&table->AttributeCount, sizeof(size_t), 1, file);
-
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        size_t attrNameLen = strlen(table->Attributes[i].AttributeName);
-        fwrite(&attrNameLen, sizeof(size_t), 1, file);
-        fwrite(table->Attributes[i].AttributeName, sizeof(char), attrNameLen, file);
-        fwrite(&table->Attributes[i].AttributeType, sizeof(DataTypes), 1, file);
-    }
-
-
-    fwrite(&table->RowCount, sizeof(size_t), 1, file);
-
-
-    for (size_t i = 0; i < table->RowCount; ++i) {
-        for (size_t j = 0; j < table->AttributeCount; ++j) {
-            void *val = table->Rows[i].values[j];
-            switch (table->Attributes[j].AttributeType) {
-                case DT_INT:
-                    fwrite(val, sizeof(int), 1, file);
-                    break;
-                case DT_UINT:
-                    fwrite(val, sizeof(unsigned int), 1, file);
-                    break;
-                case DT_FLOAT:
-                    fwrite(val, sizeof(float), 1, file);
-                    break;
-                case DT_STRING: {
-                    char *str = (char *)val;
-                    size_t len = strlen(str);
-                    fwrite(&len, sizeof(size_t), 1, file);
-                    fwrite(str, sizeof(char), len, file);
-                    break;
-                }
-            }
-        }
-    }
-
-    fclose(file);
-    printf("Table '%s' saved to disk successfully.\n", table->TableName);
-    return true;
-}
-
-
-Table *LoadTableFromFile(const char *filename) {
-    if (!filename) return NULL;
-
-    FILE *file = fopen(filename, "rb");
-    if (!file) {
-        perror("Failed to open file for reading");
-        return NULL;
-    }
-
-    Table *table = (Table *)malloc(sizeof(Table));
-    if (!table) {
-        fclose(file);
-        return NULL;
-    }
-    memset(table, 0, sizeof(Table));
-
-
-    size_t nameLen = 0;
-    fread(&nameLen, sizeof(size_t), 1, file);
-    table->TableName = (char *)malloc(nameLen + 1);
-    fread(table->TableName, sizeof(char), nameLen, file);
-    table->TableName[nameLen] = '\0';
-
-
-    fread(&table->AttributeCount, sizeof(size_t), 1, file);
-    table->Attributes = (Attribute *)malloc(sizeof(Attribute) * table->AttributeCount);
-
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        size_t attrNameLen = 0;
-        fread(&attrNameLen, sizeof(size_t), 1, file);
-        table->Attributes[i].AttributeName = (char *)malloc(attrNameLen + 1);
-        fread(table->Attributes[i].AttributeName, sizeof(char), attrNameLen, file);
-        table->Attributes[i].AttributeName[attrNameLen] = '\0';
-        fread(&table->Attributes[i].AttributeType, sizeof(DataTypes), 1, file);
-    }
-
-
-    fread(&table->RowCount, sizeof(size_t), 1, file);
-    if (table->RowCount > 0) {
-        table->Rows = (Row *)malloc(sizeof(Row) * table->RowCount);
-        for (size_t i = 0; i < table->RowCount; ++i) {
-            table->Rows[i].values = (void **)malloc(sizeof(void *) * table->AttributeCount);
-            for (size_t j = 0; j < table->AttributeCount; ++j) {
-                switch (table->Attributes[j].AttributeType) {
-                    case DT_INT:
-                        table->Rows[i].values[j] = malloc(sizeof(int));
-                        fread(table->Rows[i].values[j], sizeof(int), 1, file);
-                        break;
-                    case DT_UINT:
-                        table->Rows[i].values[j] = malloc(sizeof(unsigned int));
-                        fread(table->Rows[i].values[j], sizeof(unsigned int), 1, file);
-                        break;
-                    case DT_FLOAT:
-                        table->Rows[i].values[j] = malloc(sizeof(float));
-                        fread(table->Rows[i].values[j], sizeof(float), 1, file);
-                        break;
-                    case DT_STRING: {
-                        size_t len = 0;
-                        fread(&len, sizeof(size_t), 1, file);
-                        table->Rows[i].values[j] = malloc(len + 1);
-                        fread(table->Rows[i].values[j], sizeof(char), len, file);
-                        ((char *)table->Rows[i].values[j])[len] = '\0';
-                        break;
-                    }
-                }
-            }
-        }
-    } else {
-        table->Rows = NULL;
-    }
-
-    fclose(file);
-    return table;
-}
-
-void FilterAndDisplayTable(const Table *table, const char *columnName, const char *valueAsString) {
-    if (!table || !columnName || !valueAsString) return;
-
-
-    size_t columnIndex = -1;
-    DataTypes columnType;
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        if (strcmp(table->Attributes[i].AttributeName, columnName) == 0) {
-            columnIndex = i;
-            columnType = table->Attributes[i].AttributeType;
-            break;
-        }
-    }
-
-    if (columnIndex == (size_t)-1) {
-        printf("Column '%s' not found in table.\n", columnName);
-        return;
-    }
-
-    printf("\nFiltered Results (WHERE %s = %s):\n", columnName, valueAsString);
-
-    for (size_t i = 0; i < table->AttributeCount; i++) {
-        printf("| %-15s ", table->Attributes[i].AttributeName);
-    }
-    printf("|\n");
-
-    for (size_t i = 0; i < table->AttributeCount; i++) {
-        printf("+-----------------");
-    }
-    printf("+\n");
-
-    for (size_t i = 0; i < table->RowCount; ++i) {
-        Row *row = &table->Rows[i];
-        void *val = row->values[columnIndex];
-        bool match = false;
-
-        switch (columnType) {
-            case DT_INT: {
-                int cmpVal = atoi(valueAsString);
-                match = (*(int *)val == cmpVal);
-                break;
-            }
-            case DT_UINT: {
-                unsigned int cmpVal = (unsigned int)strtoul(valueAsString, NULL, 10);
-                match = (*(unsigned int *)val == cmpVal);
-                break;
-            }
-            case DT_FLOAT: {
-                float cmpVal = strtof(valueAsString, NULL);
-                match = (*(float *)val == cmpVal);
-                break;
-            }
-            case DT_STRING: {
-                match = (strcmp((char *)val, valueAsString) == 0);
-                break;
-            }
-        }
-
-        if (match) {
-            for (size_t j = 0; j < table->AttributeCount; j++) {
-                void *cell = row->values[j];
-                switch (table->Attributes[j].AttributeType) {
-                    case DT_INT:    printf("| %-15d ", *(int *)cell); break;
-                    case DT_UINT:   printf("| %-15u ", *(unsigned int *)cell); break;
-                    case DT_FLOAT:  printf("| %-15.2f ", *(float *)cell); break;
-                    case DT_STRING: printf("| %-15s ", (char *)cell); break;
-                }
-            }
-            printf("|\n");
-        }
-    }
-}
-
-
-
-CompareOperator ParseOperator(const char *op) {
-    if (strcmp(op, "=") == 0) return OP_EQ;
-    if (strcmp(op, "!=") == 0) return OP_NEQ;
-    if (strcmp(op, ">") == 0) return OP_GT;
-    if (strcmp(op, "<") == 0) return OP_LT;
-    if (strcmp(op, ">=") == 0) return OP_GTE;
-    if (strcmp(op, "<=") == 0) return OP_LTE;
-    return OP_UNKNOWN;
-}
-
-
-
-bool Compare(DataTypes type, void *left, const char *rightLiteral, CompareOperator op) {
-    switch (type) {
-        case DT_INT: {
-            int leftVal = *(int *)left;
-            int rightVal = atoi(rightLiteral);
-            switch (op) {
-                case OP_EQ: return leftVal == rightVal;
-                case OP_NEQ: return leftVal != rightVal;
-                case OP_GT: return leftVal > rightVal;
-                case OP_LT: return leftVal < rightVal;
-                case OP_GTE: return leftVal >= rightVal;
-                case OP_LTE: return leftVal <= rightVal;
-                default: return false;
-            }
-        }
-        case DT_UINT: {
-            unsigned int leftVal = *(unsigned int *)left;
-            unsigned int rightVal = (unsigned int)strtoul(rightLiteral, NULL, 10);
-            switch (op) {
-                case OP_EQ: return leftVal == rightVal;
-                case OP_NEQ: return leftVal != rightVal;
-                case OP_GT: return leftVal > rightVal;
-                case OP_LT: return leftVal < rightVal;
-                case OP_GTE: return leftVal >= rightVal;
-                case OP_LTE: return leftVal <= rightVal;
-                default: return false;
-            }
-        }
-        case DT_FLOAT: {
-            float leftVal = *(float *)left;
-            float rightVal = strtof(rightLiteral, NULL);
-            switch (op) {
-                case OP_EQ: return leftVal == rightVal;
-                case OP_NEQ: return leftVal != rightVal;
-                case OP_GT: return leftVal > rightVal;
-                case OP_LT: return leftVal < rightVal;
-                case OP_GTE: return leftVal >= rightVal;
-                case OP_LTE: return leftVal <= rightVal;
-                default: return false;
-            }
-        }
-        case DT_STRING: {
-            int cmp = strcmp((char *)left, rightLiteral);
-            switch (op) {
-                case OP_EQ: return cmp == 0;
-                case OP_NEQ: return cmp != 0;
-                case OP_GT: return cmp > 0;
-                case OP_LT: return cmp < 0;
-                case OP_GTE: return cmp >= 0;
-                case OP_LTE: return cmp <= 0;
-                default: return false;
-            }
-        }
-        default: return false;
-    }
-}
-
-
-
-bool SelectQuery(Table *table, const char *columnName, const char *operator, const char *valueLiteral) {
-    if (!table || !columnName || !operator || !valueLiteral) return false;
-
-    int colIndex = -1;
-
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        if (strcmp(table->Attributes[i].AttributeName, columnName) == 0) {
-            colIndex = i;
-            break;
-        }
-    }
-
-    if (colIndex == -1) {
-        printf("Column '%s' not found in table '%s'.\n", columnName, table->TableName);
-        return false;
-    }
-
-    DataTypes type = table->Attributes[colIndex].AttributeType;
-    CompareOperator op = ParseOperator(operator);
-
-    if (op == OP_UNKNOWN) {
-        printf("Unknown operator: %s\n", operator);
-        return false;
-    }
-
-    printf("\nMatching rows from table '%s':\n", table->TableName);
-
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        printf("| %-12s ", table->Attributes[i].AttributeName);
-    }
-    printf("|\n");
-
-
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        printf("+--------------");
-    }
-    printf("+\n");
-
-    size_t matchCount = 0;
-    for (size_t i = 0; i < table->RowCount; ++i) {
-        void *cellValue = table->Rows[i].values[colIndex];
-
-        if (Compare(type, cellValue, valueLiteral, op)) {
-            matchCount++;
-            for (size_t j = 0; j < table->AttributeCount; ++j) {
-                switch (table->Attributes[j].AttributeType) {
-                    case DT_INT:
-                        printf("| %-12d ", *(int *)table->Rows[i].values[j]); break;
-                    case DT_UINT:
-                        printf("| %-12u ", *(unsigned int *)table->Rows[i].values[j]); break;
-                    case DT_FLOAT:
-                        printf("| %-12.2f ", *(float *)table->Rows[i].values[j]); break;
-                    case DT_STRING:
-                        printf("| %-12s ", (char *)table->Rows[i].values[j]); break;
-                }
-            }
-            printf("|\n");
-        }
-    }
-
-    if (matchCount == 0) {
-        printf("No rows matched the condition.\n");
-    }
-
-    return true;
-}
-
-size_t DeleteRows(Table *table, const char *columnName, const char *operator, const char *valueLiteral) {
-    if (!table || !columnName || !operator || !valueLiteral) return 0;
-
-    int colIndex = -1;
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        if (strcmp(table->Attributes[i].AttributeName, columnName) == 0) {
-            colIndex = i;
-            break;
-        }
-    }
-    if (colIndex == -1) {
-        printf("Column not found.\n");
-        return 0;
-    }
-
-    CompareOperator op = ParseOperator(operator);
-    if (op == OP_UNKNOWN) {
-        printf("Unsupported operator.\n");
-        return 0;
-    }
-
-    size_t deleted = 0;
-
-    for (size_t i = 0; i < table->RowCount;) {
-        void *value = table->Rows[i].values[colIndex];
-        if (Compare(table->Attributes[colIndex].AttributeType, value, valueLiteral, op)) {
-            // Free each attribute value in row
-            for (size_t j = 0; j < table->AttributeCount; ++j) {
-                if (table->Attributes[j].AttributeType == DT_STRING) {
-                    free(table->Rows[i].values[j]);
-                } else {
-                    free(table->Rows[i].values[j]);
-                }
-            }
-            free(table->Rows[i].values);
-
-
-            for (size_t k = i + 1; k < table->RowCount; ++k) {
-                table->Rows[k - 1] = table->Rows[k];
-            }
-
-            table->RowCount--;
-            deleted++;
-
-        } else {
-            i++;
-        }
-    }
-
-    return deleted;
-}
-
-size_t UpdateRows(Table *table, const char *targetColumn, const char *newValueLiteral,
-                  const char *filterColumn, const char *operator, const char *filterValueLiteral) {
-    if (!table || !targetColumn || !newValueLiteral || !filterColumn || !operator || !filterValueLiteral) return 0;
-
-    int filterColIndex = -1, targetColIndex = -1;
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        if (strcmp(table->Attributes[i].AttributeName, filterColumn) == 0)
-            filterColIndex = i;
-        if (strcmp(table->Attributes[i].AttributeName, targetColumn) == 0)
-            targetColIndex = i;
-    }
-
-    if (filterColIndex == -1 || targetColIndex == -1) {
-        printf("Column not found.\n");
-        return 0;
-    }
-
-    CompareOperator op = ParseOperator(operator);
-    if (op == OP_UNKNOWN) {
-        printf("Invalid operator.\n");
-        return 0;
-    }
-
-    size_t updated = 0;
-
-    for (size_t i = 0; i < table->RowCount; ++i) {
-        void *filterVal = table->Rows[i].values[filterColIndex];
-        if (Compare(table->Attributes[filterColIndex].AttributeType, filterVal, filterValueLiteral, op)) {
-
-            if (table->Attributes[targetColIndex].AttributeType == DT_STRING) {
-                free(table->Rows[i].values[targetColIndex]);
-                table->Rows[i].values[targetColIndex] = strdup(newValueLiteral);
-            } else if (table->Attributes[targetColIndex].AttributeType == DT_INT) {
-                int *ptr = malloc(sizeof(int));
-                *ptr = atoi(newValueLiteral);
-                free(table->Rows[i].values[targetColIndex]);
-                table->Rows[i].values[targetColIndex] = ptr;
-            } else if (table->Attributes[targetColIndex].AttributeType == DT_UINT) {
-                unsigned int *ptr = malloc(sizeof(unsigned int));
-                *ptr = (unsigned int)strtoul(newValueLiteral, NULL, 10);
-                free(table->Rows[i].values[targetColIndex]);
-                table->Rows[i].values[targetColIndex] = ptr;
-            } else if (table->Attributes[targetColIndex].AttributeType == DT_FLOAT) {
-                float *ptr = malloc(sizeof(float));
-                *ptr = strtof(newValueLiteral, NULL);
-                free(table->Rows[i].values[targetColIndex]);
-                table->Rows[i].values[targetColIndex] = ptr;
-            }
-
-            updated++;
-        }
-    }
-
-    return updated;
-}
-
-bool AlterAddColumn(Table *table, const char *columnName, const char *typeStr) {
-    if (!table || !columnName || !typeStr) return false;
-
-    DataTypes newType;
-    if (strcmp(typeStr, "INT") == 0) newType = DT_INT;
-    else if (strcmp(typeStr, "UINT") == 0) newType = DT_UINT;
-    else if (strcmp(typeStr, "FLOAT") == 0) newType = DT_FLOAT;
-    else if (strcmp(typeStr, "STRING") == 0) newType = DT_STRING;
-    else return false;
-
-
-    Attribute *newAttrs = realloc(table->Attributes, sizeof(Attribute) * (table->AttributeCount + 1));
-    if (!newAttrs) return false;
-
-    table->Attributes = newAttrs;
-    table->Attributes[table->AttributeCount].AttributeName = strdup(columnName);
-    table->Attributes[table->AttributeCount].AttributeType = newType;
-    table->AttributeCount++;
-
-
-    for (size_t i = 0; i < table->RowCount; ++i) {
-        void **newValues = realloc(table->Rows[i].values, sizeof(void *) * table->AttributeCount);
-        if (!newValues) return false;
-
-        table->Rows[i].values = newValues;
-
-
-        switch (newType) {
-            case DT_INT:
-                newValues[table->AttributeCount - 1] = malloc(sizeof(int));
-                *((int *)newValues[table->AttributeCount - 1]) = 0;
-                break;
-            case DT_UINT:
-                newValues[table->AttributeCount - 1] = malloc(sizeof(unsigned int));
-                *((unsigned int *)newValues[table->AttributeCount - 1]) = 0;
-                break;
-            case DT_FLOAT:
-                newValues[table->AttributeCount - 1] = malloc(sizeof(float));
-                *((float *)newValues[table->AttributeCount - 1]) = 0.0f;
-                break;
-            case DT_STRING:
-                newValues[table->AttributeCount - 1] = strdup("");
-                break;
-        }
-    }
-
-    return true;
-}
-
-bool AlterDropColumn(Table *table, const char *columnName) {
-    if (!table || !columnName) return false;
-
-    int colIndex = -1;
-    for (size_t i = 0; i < table->AttributeCount; ++i) {
-        if (strcmp(table->Attributes[i].AttributeName, columnName) == 0) {
-            colIndex = (int)i;
-            break;
-        }
-    }
-    if (colIndex == -1) return false;
-
-
-    free(table->Attributes[colIndex].AttributeName);
-
-
-    for (size_t i = colIndex; i < table->AttributeCount - 1; ++i) {
-        table->Attributes[i] = table->Attributes[i + 1];
-    }
-
-    Attribute *shrunkAttrs = realloc(table->Attributes, sizeof(Attribute) * (table->AttributeCount - 1));
-    if (shrunkAttrs) table->Attributes = shrunkAttrs;
-
-
-    for (size_t i = 0; i < table->RowCount; ++i) {
-        free(table->Rows[i].values[colIndex]);
-        for (size_t j = colIndex; j < table->AttributeCount - 1; ++j) {
-            table->Rows[i].values[j] = table->Rows[i].values[j + 1];
-        }
-
-        void **shrunkValues = realloc(table->Rows[i].values, sizeof(void *) * (table->AttributeCount - 1));
-        if (shrunkValues) table->Rows[i].values = shrunkValues;
-    }
-
-    table->AttributeCount--;
-    return true;
-}
-
-bool DeleteTableFile(const char *tableName) {
-    if (!tableName) return false;
-
-    char filename[200];
-    snprintf(filename, sizeof(filename), "data/%s.tbl", tableName);
-
-    if (remove(filename) == 0) {
-        printf("File '%s' deleted from disk.\n", filename);
-        return true;
-    } else {
-        printf("Failed to delete '%s'. File may not exist.\n", filename);
-        return false;
-    }
-}
-
-
-
-
-
-
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <sys/stat.h>
+#include <errno.h>
+#ifdef _WIN32
+    #include <direct.h>
+    #define MAKE_DIR(dir) _mkdir(dir)
+#else
+    #include <sys/stat.h>
+    #define MAKE_DIR(dir) mkdir(dir, 0777)
+#endif
+#include "functions.h"
+#include "database.h"
+
+#define INITIAL_ROW_CAPACITY 4
+// Type number offered by the CREATE prompt for an interned STRING column.
+#define TYPE_CHOICE_DICT 4
+// Tables are compacted once this share of their rows are tombstones.
+#define COMPACT_DEAD_PERCENT 25
+
+static size_t ColumnWidth(DataTypes type) {
+    switch (type) {
+        case DT_INT: return sizeof(int);
+        case DT_UINT: return sizeof(unsigned int);
+        case DT_FLOAT: return sizeof(float);
+        case DT_STRING: return sizeof(StringRef);
+    }
+    return 0;
+}
+
+// Interned STRING columns hold 4-byte codes rather than refs.
+static size_t CellWidth(const Table *table, size_t col) {
+    if (table->Columns[col].Dict) return sizeof(uint32_t);
+    return ColumnWidth(table->Attributes[col].AttributeType);
+}
+
+static bool ReserveColumns(Table *table, size_t capacity) {
+    if (capacity <= table->RowCapacity) return true;
+
+    for (size_t i = 0; i < table->AttributeCount; ++i) {
+        Column *column = &table->Columns[i];
+        size_t width = CellWidth(table, i);
+        void *values = column->Mapped ? malloc(width * capacity) : realloc(column->Values, width * capacity);
+        if (!values) return false;
+        if (column->Mapped) memcpy(values, column->Values, width * table->RowCount);
+        column->Values = values;
+        column->Mapped = 0;
+
+        ZoneMap *zones = realloc(table->Columns[i].Zones, sizeof(ZoneMap) * ((capacity + ZONE_ROWS - 1) / ZONE_ROWS));
+        if (!zones) return false;
+        table->Columns[i].Zones = zones;
+    }
+
+    if (table->Deleted) {
+        size_t oldWords = (table->RowCapacity + 63) / 64, newWords = (capacity + 63) / 64;
+        uint64_t *deleted = realloc(table->Deleted, sizeof(uint64_t) * newWords);
+        if (!deleted) return false;
+        memset(deleted + oldWords, 0, sizeof(uint64_t) * (newWords - oldWords));
+        table->Deleted = deleted;
+    }
+    table->RowCapacity = capacity;
+    return true;
+}
+
+static bool EnsureRowCapacity(Table *table, size_t needed) {
+    if (needed <= table->RowCapacity) return true;
+
+    size_t newCapacity = table->RowCapacity ? table->RowCapacity : INITIAL_ROW_CAPACITY;
+    while (newCapacity < needed) newCapacity *= 2;
+    return ReserveColumns(table, newCapacity);
+}
+
+// Sizes every column for exactly rows rows ahead of a known number of inserts, so they
+// need no doubling on the way; RowCount is unchanged and a smaller rows is a no-op.
+bool ReserveRows(Table *table, size_t rows) {
+    if (!table) return false;
+    if (!ReserveColumns(table, rows)) {
+        printf("Out of memory reserving %zu rows for table '%s'.\n", rows, table->TableName);
+        return false;
+    }
+    return true;
+}
+
+// Points the numeric columns of a new, empty table at values[j] inside its file mapping and
+// sizes everything else for rows rows. String columns (values[j] NULL) get their own ref array.
+bool AttachMappedColumns(Table *table, size_t rows, void **values) {
+    size_t groups = (rows + ZONE_ROWS - 1) / ZONE_ROWS;
+
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        Column *column = &table->Columns[j];
+        if (values[j]) {
+            free(column->Values);
+            column->Values = values[j];
+            column->Mapped = 1;
+        } else {
+            void *refs = realloc(column->Values, CellWidth(table, j) * (rows ? rows : 1));
+            if (!refs) return false;
+            column->Values = refs;
+        }
+
+        ZoneMap *zones = realloc(column->Zones, sizeof(ZoneMap) * (groups ? groups : 1));
+        if (!zones) return false;
+        column->Zones = zones;
+    }
+    table->RowCapacity = rows;
+    return true;
+}
+
+// Gives a mapped column memory of its own before it is written; the file stays untouched.
+static bool PromoteColumn(Table *table, size_t col) {
+    Column *column = &table->Columns[col];
+    if (!column->Mapped) return true;
+
+    size_t width = CellWidth(table, col);
+    void *values = malloc(width * (table->RowCapacity ? table->RowCapacity : 1));
+    if (!values) {
+        printf("Out of memory copying column '%s'.\n", table->Attributes[col].AttributeName);
+        return false;
+    }
+    memcpy(values, column->Values, width * table->RowCount);
+    column->Values = values;
+    column->Mapped = 0;
+    return true;
+}
+
+static bool SetStringCell(Table *table, size_t col, size_t row, const char *str) {
+    if (table->Columns[col].Dict) return InternString(table, col, str, &((uint32_t *)table->Columns[col].Values)[row]);
+
+    StringRef *refs = table->Columns[col].Values;
+    StringRef ref;
+    if (!ArenaStoreString(&table->Strings, str, strlen(str), &ref)) return false;
+    ArenaFreeString(&table->Strings, refs[row]);
+    refs[row] = ref;
+    return true;
+}
+
+// Moves every live string into a fresh arena, giving back chunks left sparse by UPDATE/DELETE churn.
+// New refs are built aside and only swapped in once every string has been copied, so running
+// out of memory part way leaves the table as it was.
+static bool CompactStrings(Table *table) {
+    Arena compacted;
+    InitArena(&compacted);
+    StringRef **staged = calloc(table->AttributeCount ? table->AttributeCount : 1, sizeof(StringRef *));
+    DictionaryCompaction *dicts = calloc(table->AttributeCount ? table->AttributeCount : 1, sizeof(DictionaryCompaction));
+    bool ok = staged && dicts;
+
+    for (size_t j = 0; ok && j < table->AttributeCount; ++j) {
+        if (table->Attributes[j].AttributeType != DT_STRING || table->Columns[j].Dict) continue;
+
+        const StringRef *refs = table->Columns[j].Values;
+        staged[j] = malloc(sizeof(StringRef) * (table->RowCapacity ? table->RowCapacity : 1));
+        ok = staged[j] != NULL;
+        for (size_t i = 0; ok && i < table->RowCount; ++i) {
+            const char *str = ArenaString(&table->Strings, refs[i]);
+            ok = ArenaStoreString(&compacted, str, strlen(str), &staged[j][i]);
+        }
+    }
+
+    for (size_t j = 0; ok && j < table->AttributeCount; ++j) {
+        if (table->Columns[j].Dict) ok = StageDictionaryCompaction(table, j, &compacted, &dicts[j]);
+    }
+
+    if (!ok) {
+        for (size_t j = 0; staged && j < table->AttributeCount; ++j) free(staged[j]);
+        for (size_t j = 0; dicts && j < table->AttributeCount; ++j) DiscardDictionaryCompaction(&dicts[j]);
+        free(staged);
+        free(dicts);
+        FreeArena(&compacted);
+        return false;
+    }
+
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        if (table->Columns[j].Dict) CommitDictionaryCompaction(table, j, &compacted, &dicts[j]);
+        if (!staged[j]) continue;
+        if (!table->Columns[j].Mapped) free(table->Columns[j].Values);
+        table->Columns[j].Values = staged[j];
+        table->Columns[j].Mapped = 0;
+    }
+    free(staged);
+    free(dicts);
+    FreeArena(&table->Strings);
+    table->Strings = compacted;
+    return true;
+}
+
+// Copies everything still read from the file mapping and unmaps it, so the file can be
+// rewritten or removed.
+bool ReleaseTableMapping(Table *table) {
+    if (!table->Mapping) return true;
+
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        if (!PromoteColumn(table, j)) return false;
+    }
+    if (!CompactStrings(table)) return false;
+
+    UnmapTableFile(table->Mapping);
+    table->Mapping = NULL;
+    return true;
+}
+
+// LOAD and DROPFILE rewrite or remove data/<name>.tbl (name with or without the extension),
+// so any loaded table still mapped from it is released first. Returns false if a mapping
+// could not be released, in which case the file must not be touched.
+bool ReleaseTableFile(Table **tables, size_t tableCount, const char *name) {
+    size_t len = strlen(name);
+    if (len >= 4 && strcmp(name + len - 4, ".tbl") == 0) len -= 4;
+
+    for (size_t i = 0; i < tableCount; ++i) {
+        if (strlen(tables[i]->TableName) != len || strncmp(tables[i]->TableName, name, len) != 0) continue;
+        if (!ReleaseTableMapping(tables[i])) {
+            printf("Could not release the file of table '%s'; it is left untouched.\n", tables[i]->TableName);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void MaybeCompactStrings(Table *table) {
+    if (ArenaNeedsCompaction(&table->Strings)) {
+        CompactStrings(table);
+    }
+}
+
+void *GetCell(const Table *table, size_t col, size_t row) {
+    const Column *column = &table->Columns[col];
+    switch (table->Attributes[col].AttributeType) {
+        case DT_INT: return &((int *)column->Values)[row];
+        case DT_UINT: return &((unsigned int *)column->Values)[row];
+        case DT_FLOAT: return &((float *)column->Values)[row];
+        case DT_STRING:
+            if (column->Dict) return (void *)DictionaryString(table, col, ((uint32_t *)column->Values)[row]);
+            return ArenaString(&table->Strings, ((StringRef *)column->Values)[row]);
+    }
+    return NULL;
+}
+
+void PrintCell(const Table *table, size_t col, size_t row, int width) {
+    void *value = GetCell(table, col, row);
+    switch (table->Attributes[col].AttributeType) {
+        case DT_INT:
+            printf("| %-*d ", width, *(int *)value);
+            break;
+        case DT_UINT:
+            printf("| %-*u ", width, *(unsigned int *)value);
+            break;
+        case DT_FLOAT:
+            printf("| %-*.2f ", width, *(float *)value);
+            break;
+        case DT_STRING:
+            printf("| %-*s ", width, (char *)value);
+            break;
+    }
+}
+
+#define SCHEMA_FIRST_SLOTS 16
+#define SCHEMA_NO_COLUMN   UINT32_MAX
+
+static uint64_t NextSchemaVersion;
+
+static uint32_t HashColumnName(const char *name) {
+    uint32_t hash = 2166136261u;
+    while (*name) hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    return hash;
+}
+
+// Slot holding the column called name, or the empty slot where it would go.
+static size_t FindSchemaSlot(const Table *table, const char *name) {
+    size_t mask = table->ColumnSlotCount - 1;
+    size_t slot = HashColumnName(name) & mask;
+    while (table->ColumnSlots[slot] != SCHEMA_NO_COLUMN &&
+           strcmp(table->Attributes[table->ColumnSlots[slot]].AttributeName, name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Refills the name hash from Attributes, at most half full, and moves the table to a new
+// schema version. Where names repeat the first column keeps the name, as with a scan. Out of
+// memory the hash is dropped and FindColumn scans the names instead.
+void RebuildSchemaMap(Table *table) {
+    table->SchemaVersion = ++NextSchemaVersion;
+
+    size_t slotCount = SCHEMA_FIRST_SLOTS;
+    while (slotCount < table->AttributeCount * 2) slotCount *= 2;
+    if (slotCount != table->ColumnSlotCount) {
+        uint32_t *slots = realloc(table->ColumnSlots, sizeof(uint32_t) * slotCount);
+        if (!slots) {
+            free(table->ColumnSlots);
+            table->ColumnSlots = NULL;
+            table->ColumnSlotCount = 0;
+            return;
+        }
+        table->ColumnSlots = slots;
+        table->ColumnSlotCount = slotCount;
+    }
+    memset(table->ColumnSlots, 0xFF, sizeof(uint32_t) * slotCount);
+
+    for (size_t i = 0; i < table->AttributeCount; ++i) {
+        size_t slot = FindSchemaSlot(table, table->Attributes[i].AttributeName);
+        if (table->ColumnSlots[slot] == SCHEMA_NO_COLUMN) table->ColumnSlots[slot] = (uint32_t)i;
+    }
+}
+
+int FindColumn(const Table *table, const char *columnName) {
+    if (table->ColumnSlots) {
+        uint32_t col = table->ColumnSlots[FindSchemaSlot(table, columnName)];
+        return col == SCHEMA_NO_COLUMN ? -1 : (int)col;
+    }
+    for (size_t i = 0; i < table->AttributeCount; ++i) {
+        if (strcmp(table->Attributes[i].AttributeName, columnName) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+bool ResolveColumn(const Table *table, const char *columnName, ColumnHandle *column) {
+    int col = FindColumn(table, columnName);
+    if (col == -1) return false;
+    column->Index = (size_t)col;
+    column->Version = table->SchemaVersion;
+    return true;
+}
+
+bool ColumnHandleValid(const Table *table, ColumnHandle column) {
+    if (column.Version == table->SchemaVersion && column.Index < table->AttributeCount) return true;
+    printf("Column handle for table '%s' is stale; look the column up again.\n", table->TableName);
+    return false;
+}
+
+Table *CreateTable(const char *TableName, Attribute *Attributes, size_t AttributeCount) {
+    Table *table = malloc(sizeof(Table));
+    if (!table) return NULL;
+
+    table->TableName = strdup(TableName);
+    table->AttributeCount = AttributeCount;
+
+    table->Attributes = malloc(sizeof(Attribute) * AttributeCount);
+    for (size_t i = 0; i < AttributeCount; ++i) {
+        table->Attributes[i].AttributeName = strdup(Attributes[i].AttributeName);
+        table->Attributes[i].AttributeType = Attributes[i].AttributeType;
+    }
+
+    table->RowCount = 0;
+    table->RowCapacity = 0;
+    table->Deleted = NULL;
+    table->DeletedCount = 0;
+    table->Mapping = NULL;
+    table->Log = NULL;
+    table->ColumnSlots = NULL;
+    table->ColumnSlotCount = 0;
+    RebuildSchemaMap(table);
+    InitArena(&table->Strings);
+    table->Columns = calloc(AttributeCount ? AttributeCount : 1, sizeof(Column));
+    if (!table->Columns || !ReserveColumns(table, INITIAL_ROW_CAPACITY)) {
+        FreeTable(table);
+        return NULL;
+    }
+
+    return table;
+}
+
+void FreeTable(Table *table) {
+    if (!table) return;
+
+    if (table->Columns) CloseTableIndexes(table);
+    free(table->TableName);
+
+    for (size_t i = 0; i < table->AttributeCount; ++i) {
+        free(table->Attributes[i].AttributeName);
+        if (table->Columns) {
+            if (!table->Columns[i].Mapped) free(table->Columns[i].Values);
+            free(table->Columns[i].Zones);
+            FreeColumnDictionary(table->Columns[i].Dict);
+        }
+    }
+    free(table->Attributes);
+    free(table->ColumnSlots);
+    free(table->Columns);
+    free(table->Deleted);
+    FreeArena(&table->Strings);
+    UnmapTableFile(table->Mapping);
+    CloseTableLog(table);
+    free(table);
+}
+
+void DisplayTable(const Table *table) {
+    if (!table) return;
+
+    ResultSet *result = TableResultSet(table);
+    if (!result) return;
+    printf("Table: %s\n", table->TableName);
+    RenderResultSet(result);
+    FreeResultSet(result);
+}
+
+// DISPLAY ... PAGE n SIZE k: only the k live rows of 1-based page n are rendered.
+bool DisplayTablePage(const Table *table, size_t page, size_t pageRows) {
+    if (!table) return false;
+    if (page == 0 || pageRows == 0) {
+        printf("Pages are numbered from 1 and must hold at least one row.\n");
+        return false;
+    }
+
+    ResultSet *result = TableResultSet(table);
+    if (!result) return false;
+
+    size_t live = ResultSetCount(result);
+    size_t pages = live ? (live - 1) / pageRows + 1 : 1;
+    size_t first = page - 1 <= live / pageRows ? (page - 1) * pageRows : live;
+    ResultSetLimit(result, first, pageRows);
+
+    printf("Table: %s\n", table->TableName);
+    size_t shown = RenderResultSet(result);
+    if (shown > 0) {
+        printf("Page %zu of %zu (rows %zu-%zu of %zu).\n", page, pages, first + 1, first + shown, live);
+    } else {
+        printf("Page %zu of %zu is empty (%zu rows).\n", page, pages, live);
+    }
+    FreeResultSet(result);
+    return true;
+}
+
+void InsertRowFromInput(Table *table) {
+    if (!table) return;
+
+    void **values = malloc(sizeof(void *) * table->AttributeCount);
+    if (!values) {
+        printf("Memory allocation failed.\n");
+        return;
+    }
+
+    for (size_t i = 0; i < table->AttributeCount; ++i) {
+        Attribute attr = table->Attributes[i];
+        char buffer[256];
+
+        printf("Enter value for %s (%s): ", attr.AttributeName,
+               attr.AttributeType == DT_INT ? "INT" :
+               attr.AttributeType == DT_UINT ? "UINT" :
+               attr.AttributeType == DT_FLOAT ? "FLOAT" : "STRING");
+
+        scanf("%255s", buffer);
+
+        switch (attr.AttributeType) {
+            case DT_INT: {
+                int *val = malloc(sizeof(int));
+                *val = atoi(buffer);
+                values[i] = val;
+                break;
+            }
+            case DT_UINT: {
+                unsigned int *val = malloc(sizeof(unsigned int));
+                *val = (unsigned int)strtoul(buffer, NULL, 10);
+                values[i] = val;
+                break;
+            }
+            case DT_FLOAT: {
+                float *val = malloc(sizeof(float));
+                *val = strtof(buffer, NULL);
+                values[i] = val;
+                break;
+            }
+            case DT_STRING: {
+                values[i] = strdup(buffer);
+                break;
+            }
+        }
+    }
+
+    if (InsertRow(table, values)) {
+        printf("Row inserted successfully.\n");
+    } else {
+        printf("Row insertion failed.\n");
+    }
+
+    for (size_t i = 0; i < table->AttributeCount; ++i) {
+        free(values[i]);
+    }
+    free(values);
+}
+
+bool InsertRow(Table *table, void **values) {
+    if (!table || !values) return false;
+
+    if (!EnsureRowCapacity(table, table->RowCount + 1)) return false;
+
+    size_t row = table->RowCount;
+    for (size_t i = 0; i < table->AttributeCount; ++i) {
+        Column *column = &table->Columns[i];
+
+        switch (table->Attributes[i].AttributeType) {
+            case DT_INT:
+                ((int *)column->Values)[row] = *(int *)values[i];
+                break;
+            case DT_UINT:
+                ((unsigned int *)column->Values)[row] = *(unsigned int *)values[i];
+                break;
+            case DT_FLOAT:
+                ((float *)column->Values)[row] = *(float *)values[i];
+                break;
+            case DT_STRING: {
+                const char *str = (const char *)values[i];
+                if (column->Dict) {
+                    if (!InternString(table, i, str, &((uint32_t *)column->Values)[row])) return false;
+                } else if (!ArenaStoreString(&table->Strings, str, strlen(str), &((StringRef *)column->Values)[row])) {
+                    return false;
+                }
+                break;
+            }
+        }
+    }
+
+    table->RowCount++;
+    ZoneMapAppendRow(table, row);
+    IndexInsertRow(table, row);
+    LogInsertRow(table, values);
+    return true;
+}
+
+// An empty table takes an owned batch's numeric arrays as its own storage instead of
+// copying them; the table is first sized to exactly count rows to match them.
+static bool AdoptBatchColumns(Table *table, RowBatch *batch, size_t count) {
+    if (!batch->Owned || table->RowCount != 0 || count < table->RowCapacity) return false;
+    if (!ReserveColumns(table, count)) return false;
+
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        Column *column = &table->Columns[j];
+        if (table->Attributes[j].AttributeType == DT_STRING || column->Mapped) continue;
+        free(column->Values);
+        column->Values = batch->Columns[j];
+        batch->Columns[j] = NULL;
+    }
+    return true;
+}
+
+static void FreeBatch(const Table *table, RowBatch *batch, size_t count) {
+    if (!batch->Owned) return;
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        if (table->Attributes[j].AttributeType == DT_STRING && batch->Columns[j]) {
+            char **strings = batch->Columns[j];
+            for (size_t i = 0; i < count; ++i) free(strings[i]);
+        }
+        free(batch->Columns[j]);
+        batch->Columns[j] = NULL;
+    }
+}
+
+// Appends count rows in one go: storage grows once, numeric columns are copied (or adopted,
+// see RowBatch) whole, and zone maps, indexes and the log are brought up to date once for
+// the batch. Rows only become visible if every one of them was stored.
+bool InsertRows(Table *table, RowBatch *batch, size_t count) {
+    if (!table || !batch) return false;
+    if (count == 0) {
+        FreeBatch(table, batch, 0);
+        return true;
+    }
+
+    size_t first = table->RowCount;
+    if (!AdoptBatchColumns(table, batch, count) && !EnsureRowCapacity(table, first + count)) {
+        printf("Out of memory inserting %zu rows into '%s'.\n", count, table->TableName);
+        FreeBatch(table, batch, count);
+        return false;
+    }
+
+    bool ok = true;
+    for (size_t j = 0; ok && j < table->AttributeCount; ++j) {
+        Column *column = &table->Columns[j];
+        if (!batch->Columns[j]) continue;
+
+        if (table->Attributes[j].AttributeType != DT_STRING) {
+            size_t width = ColumnWidth(table->Attributes[j].AttributeType);
+            memcpy((char *)column->Values + width * first, batch->Columns[j], width * count);
+            continue;
+        }
+
+        char **strings = batch->Columns[j];
+        for (size_t i = 0; ok && i < count; ++i) {
+            if (column->Dict) {
+                ok = InternString(table, j, strings[i], &((uint32_t *)column->Values)[first + i]);
+            } else {
+                ok = ArenaStoreString(&table->Strings, strings[i], strlen(strings[i]), &((StringRef *)column->Values)[first + i]);
+            }
+        }
+    }
+    FreeBatch(table, batch, count);
+    if (!ok) {
+        printf("Out of memory inserting %zu rows into '%s'.\n", count, table->TableName);
+        return false;
+    }
+
+    table->RowCount += count;
+    ZoneMapAppendRows(table, first, table->RowCount);
+    IndexInsertRows(table, first, table->RowCount);
+    LogInsertRows(table, first, table->RowCount);
+    return true;
+}
+
+bool PromptAndInsertRow(Table *table) {
+    if (!table) return false;
+
+    void **values = malloc(sizeof(void *) * table->AttributeCount);
+    if (!values) return false;
+
+    for (size_t i = 0; i < table->AttributeCount; ++i) {
+        DataTypes type = table->Attributes[i].AttributeType;
+        char *attrName = table->Attributes[i].AttributeName;
+
+        printf("Enter value for '%s': ", attrName);
+
+        switch (type) {
+            case DT_INT: {
+                int *val = malloc(sizeof(int));
+                if (!val) return false;
+                scanf("%d", val);
+                values[i] = val;
+                break;
+            }
+            case DT_UINT: {
+                unsigned int *val = malloc(sizeof(unsigned int));
+                if (!val) return false;
+                scanf("%u", val);
+                values[i] = val;
+                break;
+            }
+            case DT_FLOAT: {
+                float *val = malloc(sizeof(float));
+                if (!val) return false;
+                scanf("%f", val);
+                values[i] = val;
+                break;
+            }
+            case DT_STRING: {
+                char buffer[256];
+                scanf("%s", buffer);
+                values[i] = strdup(buffer);  // strdup handles allocation
+                break;
+            }
+        }
+    }
+
+    bool success = InsertRow(table, values);
+
+    for (size_t i = 0; i < table->AttributeCount; ++i) {
+        if (table->Attributes[i].AttributeType == DT_STRING) {
+            free(values[i]);  // strdup
+        } else {
+            free(values[i]);  // INT, FLOAT, UINT
+        }
+    }
+    free(values);
+
+    return success;
+}
+
+Table *PromptAndCreateTable() {
+    char tableName[100];
+    size_t columnCount;
+
+    printf("Enter table name: ");
+    scanf("%99s", tableName);  // limit input to avoid buffer overflow
+
+    printf("Enter number of columns: ");
+    scanf("%zu", &columnCount);
+
+    Attribute *attributes = malloc(sizeof(Attribute) * columnCount);
+    bool *interned = malloc(sizeof(bool) * (columnCount ? columnCount : 1));
+    if (!attributes || !interned) {
+        free(attributes);
+        free(interned);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < columnCount; ++i) {
+        char attrName[100];
+        int type;
+
+        printf("Enter name for column %zu: ", i + 1);
+        scanf("%99s", attrName);
+
+        printf("Select type for '%s':\n", attrName);
+        printf(" 0 - INT\n 1 - UINT\n 2 - FLOAT\n 3 - STRING\n 4 - DICT (STRING with few distinct values)\n");
+        printf("Type: ");
+        scanf("%d", &type);
+
+        attributes[i].AttributeName = strdup(attrName);
+        attributes[i].AttributeType = type == TYPE_CHOICE_DICT ? DT_STRING : (DataTypes)type;
+        interned[i] = type == TYPE_CHOICE_DICT;
+    }
+
+    Table *table = CreateTable(tableName, attributes, columnCount);
+    for (size_t i = 0; table && i < columnCount; ++i) {
+        if (interned[i] && !InternColumn(table, i)) {
+            FreeTable(table);
+            table = NULL;
+        }
+    }
+
+    for (size_t i = 0; i < columnCount; ++i) {
+        free(attributes[i].AttributeName);
+    }
+    free(attributes);
+    free(interned);
+
+    return table;
+}
+
+
+
+bool SaveTableToFile(Table *table) {
+    if (!table) return false;
+
+    // Row ids in synced index files must match the rows written, so tombstones go first.
+    // Zone maps loosened by updates are tightened before they are written.
+    CompactTable(table);
+    RebuildZoneMaps(table);
+
+    MAKE_DIR("data");
+
+    char path[256];
+    snprintf(path, sizeof(path), "data/%s.tbl", table->TableName);
+
+    uint64_t tableBytes = 0;
+    if (!SaveTableFile(table, path, &tableBytes)) {
+        printf("Failed to write table '%s'.\n", table->TableName);
+        return false;
+    }
+    RemapTableFile(table, path);
+    SyncTableIndexes(table, tableBytes);
+    ResetTableLog(table, path, tableBytes);
+    printf("Table '%s' saved to disk successfully.\n", table->TableName);
+    return true;
+}
+
+// SAVE: a table that already has a file only needs its log of changes made durable, so the
+// cost follows the change. The whole table is written when there is no file or log yet, or
+// once the log outgrows the file it applies to.
+bool SaveTable(Table *table) {
+    if (!table) return false;
+
+    uint64_t logBytes, baseBytes;
+    GetTableLogSize(table, &logBytes, &baseBytes);
+    if (table->Log && logBytes <= baseBytes && SyncTableLog(table)) {
+        printf("Table '%s' saved to disk successfully (%llu bytes of changes logged).\n", table->TableName,
+               (unsigned long long)logBytes);
+        return true;
+    }
+    return SaveTableToFile(table);
+}
+
+
+// Reads the original row-by-row format, still accepted so older saves keep loading.
+static Table *LoadTableV1(FILE *file, uint64_t *tableBytes) {
+    Table *table = (Table *)malloc(sizeof(Table));
+    if (!table) return NULL;
+    memset(table, 0, sizeof(Table));
+    InitArena(&table->Strings);
+
+
+    size_t nameLen = 0;
+    fread(&nameLen, sizeof(size_t), 1, file);
+    table->TableName = (char *)malloc(nameLen + 1);
+    fread(table->TableName, sizeof(char), nameLen, file);
+    table->TableName[nameLen] = '\0';
+
+
+    fread(&table->AttributeCount, sizeof(size_t), 1, file);
+    table->Attributes = (Attribute *)malloc(sizeof(Attribute) * table->AttributeCount);
+
+
+    for (size_t i = 0; i < table->AttributeCount; ++i) {
+        size_t attrNameLen = 0;
+        fread(&attrNameLen, sizeof(size_t), 1, file);
+        table->Attributes[i].AttributeName = (char *)malloc(attrNameLen + 1);
+        fread(table->Attributes[i].AttributeName, sizeof(char), attrNameLen, file);
+        table->Attributes[i].AttributeName[attrNameLen] = '\0';
+        fread(&table->Attributes[i].AttributeType, sizeof(DataTypes), 1, file);
+    }
+    RebuildSchemaMap(table);
+
+
+    size_t rowCount = 0;
+    fread(&rowCount, sizeof(size_t), 1, file);
+
+    table->Columns = calloc(table->AttributeCount ? table->AttributeCount : 1, sizeof(Column));
+    if (!table->Columns || !ReserveColumns(table, rowCount ? rowCount : INITIAL_ROW_CAPACITY)) {
+        FreeTable(table);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < rowCount; ++i) {
+        for (size_t j = 0; j < table->AttributeCount; ++j) {
+            Column *column = &table->Columns[j];
+            switch (table->Attributes[j].AttributeType) {
+                case DT_INT:
+                    fread(&((int *)column->Values)[i], sizeof(int), 1, file);
+                    break;
+                case DT_UINT:
+                    fread(&((unsigned int *)column->Values)[i], sizeof(unsigned int), 1, file);
+                    break;
+                case DT_FLOAT:
+                    fread(&((float *)column->Values)[i], sizeof(float), 1, file);
+                    break;
+                case DT_STRING: {
+                    size_t len = 0;
+                    fread(&len, sizeof(size_t), 1, file);
+                    char *dest = ArenaAllocString(&table->Strings, len, &((StringRef *)column->Values)[i]);
+                    if (dest) fread(dest, sizeof(char), len, file);
+                    break;
+                }
+            }
+        }
+    }
+    table->RowCount = rowCount;
+    ReadZoneMaps(table, file);
+
+    *tableBytes = (uint64_t)FILE_TELL(file);
+    return table;
+}
+
+Table *LoadTableFromFile(const char *filename) {
+    if (!filename) return NULL;
+
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        perror("Failed to open file for reading");
+        return NULL;
+    }
+
+    uint64_t tableBytes = 0;
+    Table *table = IsTableFileV2(file) ? ReadTableFile(file, &tableBytes) : LoadTableV1(file, &tableBytes);
+    fclose(file);
+    if (table) {
+        OpenTableIndexes(table, tableBytes);
+        OpenTableLog(table, filename, tableBytes);
+    }
+    return table;
+}
+
+void FilterAndDisplayTable(const Table *table, const char *columnName, const char *valueAsString) {
+    if (!table || !columnName || !valueAsString) return;
+
+
+    ColumnHandle column;
+    if (!ResolveColumn(table, columnName, &column)) {
+        printf("Column '%s' not found in table.\n", columnName);
+        return;
+    }
+    FilterAndDisplayColumn(table, column, valueAsString);
+}
+
+void FilterAndDisplayColumn(const Table *table, ColumnHandle column, const char *valueAsString) {
+    if (!table || !valueAsString || !ColumnHandleValid(table, column)) return;
+
+    const char *columnName = table->Attributes[column.Index].AttributeName;
+    Predicate pred;
+    if (!CompilePredicate(table, column.Index, OP_EQ, valueAsString, &pred)) return;
+
+    size_t *rows;
+    size_t matchCount = ScanPredicate(&pred, table, &rows);
+    FreePredicate(&pred);
+    if (matchCount == (size_t)-1) return;
+
+    ResultSet *result = CreateResultSet(table, rows, matchCount);
+    if (!result) return;
+    printf("\nFiltered Results (WHERE %s = %s):\n", columnName, valueAsString);
+    RenderResultSet(result);
+    FreeResultSet(result);
+}
+
+
+
+CompareOperator ParseOperator(const char *op) {
+    if (strcmp(op, "=") == 0) return OP_EQ;
+    if (strcmp(op, "!=") == 0) return OP_NEQ;
+    if (strcmp(op, ">") == 0) return OP_GT;
+    if (strcmp(op, "<") == 0) return OP_LT;
+    if (strcmp(op, ">=") == 0) return OP_GTE;
+    if (strcmp(op, "<=") == 0) return OP_LTE;
+    return OP_UNKNOWN;
+}
+
+
+
+bool Compare(DataTypes type, void *left, const char *rightLiteral, CompareOperator op) {
+    switch (type) {
+        case DT_INT: {
+            int leftVal = *(int *)left;
+            int rightVal = atoi(rightLiteral);
+            switch (op) {
+                case OP_EQ: return leftVal == rightVal;
+                case OP_NEQ: return leftVal != rightVal;
+                case OP_GT: return leftVal > rightVal;
+                case OP_LT: return leftVal < rightVal;
+                case OP_GTE: return leftVal >= rightVal;
+                case OP_LTE: return leftVal <= rightVal;
+                default: return false;
+            }
+        }
+        case DT_UINT: {
+            unsigned int leftVal = *(unsigned int *)left;
+            unsigned int rightVal = (unsigned int)strtoul(rightLiteral, NULL, 10);
+            switch (op) {
+                case OP_EQ: return leftVal == rightVal;
+                case OP_NEQ: return leftVal != rightVal;
+                case OP_GT: return leftVal > rightVal;
+                case OP_LT: return leftVal < rightVal;
+                case OP_GTE: return leftVal >= rightVal;
+                case OP_LTE: return leftVal <= rightVal;
+                default: return false;
+            }
+        }
+        case DT_FLOAT: {
+            float leftVal = *(float *)left;
+            float rightVal = strtof(rightLiteral, NULL);
+            switch (op) {
+                case OP_EQ: return leftVal == rightVal;
+                case OP_NEQ: return leftVal != rightVal;
+                case OP_GT: return leftVal > rightVal;
+                case OP_LT: return leftVal < rightVal;
+                case OP_GTE: return leftVal >= rightVal;
+                case OP_LTE: return leftVal <= rightVal;
+                default: return false;
+            }
+        }
+        case DT_STRING: {
+            int cmp = strcmp((char *)left, rightLiteral);
+            switch (op) {
+                case OP_EQ: return cmp == 0;
+                case OP_NEQ: return cmp != 0;
+                case OP_GT: return cmp > 0;
+                case OP_LT: return cmp < 0;
+                case OP_GTE: return cmp >= 0;
+                case OP_LTE: return cmp <= 0;
+                default: return false;
+            }
+        }
+        default: return false;
+    }
+}
+
+
+
+// Collects the ascending ids of live rows matching a WHERE clause; returns (size_t)-1 if the
+// clause does not parse or memory runs out.
+size_t FindMatchingRows(Table *table, const char *where, size_t **rows) {
+    *rows = NULL;
+    Condition *cond = ParseCondition(table, where);
+    if (!cond) return (size_t)-1;
+
+    size_t count = EvaluateCondition(table, cond, rows);
+    FreeCondition(cond);
+    return count;
+}
+
+// Prints the columns ("a, b", NULL or "*" for all) of the rows matching where (NULL for
+// every row), in the order given by orderBy (e.g. "price DESC LIMIT 10") or in table order
+// without one.
+bool SelectQuery(Table *table, const char *columns, const char *where, const char *orderBy) {
+    ResultSet *result = ExecuteQuery(table, columns, where, orderBy);
+    if (!result) return false;
+
+    printf("\nMatching rows from table '%s':\n", table->TableName);
+    if (RenderResultSet(result) == 0) {
+        printf("No rows matched the condition.\n");
+    }
+    FreeResultSet(result);
+    return true;
+}
+
+size_t DeleteRows(Table *table, const char *where) {
+    if (!table || !where) return 0;
+
+    size_t *rows;
+    size_t count = FindMatchingRows(table, where, &rows);
+    if (count == (size_t)-1) return 0;
+    return DeleteMatchedRows(table, rows, count, where);
+}
+
+// Tombstones rows already found to match where (taken over), which is what gets logged.
+size_t DeleteMatchedRows(Table *table, size_t *rows, size_t deleted, const char *where) {
+    if (deleted == 0) {
+        free(rows);
+        return 0;
+    }
+
+    if (!table->Deleted) {
+        table->Deleted = calloc((table->RowCapacity + 63) / 64, sizeof(uint64_t));
+        if (!table->Deleted) {
+            free(rows);
+            return 0;
+        }
+    }
+
+    // A delete that pushes the table over the threshold is compacted right away, and
+    // compaction rebuilds the indexes anyway; otherwise the rows leave the indexes one by one.
+    bool compact = (table->DeletedCount + deleted) * 100 >= table->RowCount * COMPACT_DEAD_PERCENT;
+
+    for (size_t m = 0; m < deleted; ++m) {
+        size_t row = rows[m];
+        if (!compact) {
+            for (size_t j = 0; j < table->AttributeCount; ++j) IndexRemoveCell(table, j, row);
+        }
+        table->Deleted[row >> 6] |= (uint64_t)1 << (row & 63);
+    }
+    table->DeletedCount += deleted;
+    free(rows);
+    LogDeleteRows(table, where);
+
+    if (compact) CompactTable(table);
+    return deleted;
+}
+
+// Drops tombstoned rows in a single pass: surviving rows slide down over deleted ones in every
+// column and the indexes are rebuilt for the shifted row ids.
+void CompactTable(Table *table) {
+    if (!table || table->DeletedCount == 0) return;
+
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        if (!PromoteColumn(table, j)) return;
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < table->RowCount; ++i) {
+        if (IsRowDeleted(table, i)) {
+            for (size_t j = 0; j < table->AttributeCount; ++j) {
+                if (table->Attributes[j].AttributeType == DT_STRING && !table->Columns[j].Dict) {
+                    ArenaFreeString(&table->Strings, ((StringRef *)table->Columns[j].Values)[i]);
+                }
+            }
+            continue;
+        }
+
+        if (kept != i) {
+            for (size_t j = 0; j < table->AttributeCount; ++j) {
+                size_t width = CellWidth(table, j);
+                char *values = table->Columns[j].Values;
+                memcpy(values + kept * width, values + i * width, width);
+            }
+        }
+        kept++;
+    }
+
+    table->RowCount = kept;
+    free(table->Deleted);
+    table->Deleted = NULL;
+    table->DeletedCount = 0;
+
+    RebuildZoneMaps(table);
+    RebuildTableIndexes(table);
+    MaybeCompactStrings(table);
+}
+
+size_t UpdateRows(Table *table, const char *targetColumn, const char *newValueLiteral, const char *where) {
+    if (!table || !targetColumn || !newValueLiteral || !where) return 0;
+
+    ColumnHandle column;
+    if (!ResolveColumn(table, targetColumn, &column)) {
+        printf("Column not found.\n");
+        return 0;
+    }
+    return UpdateColumnRows(table, column, newValueLiteral, where);
+}
+
+size_t UpdateColumnRows(Table *table, ColumnHandle column, const char *newValueLiteral, const char *where) {
+    if (!table || !newValueLiteral || !where || !ColumnHandleValid(table, column)) return 0;
+
+    size_t *rows;
+    size_t matchCount = FindMatchingRows(table, where, &rows);
+    if (matchCount == (size_t)-1) return 0;
+    return UpdateMatchedRows(table, column.Index, newValueLiteral, rows, matchCount, where);
+}
+
+// Sets column targetColIndex of rows already found to match where (taken over) to the value, logged
+// as an update of those rows by where.
+size_t UpdateMatchedRows(Table *table, size_t targetColIndex, const char *newValueLiteral, size_t *rows,
+                         size_t matchCount, const char *where) {
+    DataTypes targetType = table->Attributes[targetColIndex].AttributeType;
+
+    if (matchCount > 0 && !PromoteColumn(table, targetColIndex)) {
+        free(rows);
+        return 0;
+    }
+
+    void *target = table->Columns[targetColIndex].Values;
+    size_t updated = 0;
+
+    for (size_t m = 0; m < matchCount; ++m) {
+        size_t i = rows[m];
+        IndexRemoveCell(table, targetColIndex, i);
+
+        if (targetType == DT_STRING) {
+            if (!SetStringCell(table, targetColIndex, i, newValueLiteral)) {
+                IndexAddCell(table, targetColIndex, i);
+                break;
+            }
+        } else if (targetType == DT_INT) {
+            ((int *)target)[i] = atoi(newValueLiteral);
+        } else if (targetType == DT_UINT) {
+            ((unsigned int *)target)[i] = (unsigned int)strtoul(newValueLiteral, NULL, 10);
+        } else if (targetType == DT_FLOAT) {
+            ((float *)target)[i] = strtof(newValueLiteral, NULL);
+        }
+
+        IndexAddCell(table, targetColIndex, i);
+        ZoneMapUpdateCell(table, targetColIndex, i);
+        updated++;
+    }
+    // Replaying the logged statement would update every matched row, so an update that
+    // stopped part way is left to the next full save instead.
+    if (updated < matchCount) printf("Out of memory after updating %zu of %zu rows.\n", updated, matchCount);
+    if (updated == matchCount && updated > 0) {
+        LogUpdateRows(table, table->Attributes[targetColIndex].AttributeName, newValueLiteral, where);
+    } else if (updated > 0) {
+        LogBulkChange(table);
+    }
+    free(rows);
+
+    MaybeCompactStrings(table);
+    return updated;
+}
+
+bool AlterAddColumn(Table *table, const char *columnName, const char *typeStr) {
+    if (!table || !columnName || !typeStr) return false;
+
+    DataTypes newType;
+    if (strcmp(typeStr, "INT") == 0) newType = DT_INT;
+    else if (strcmp(typeStr, "UINT") == 0) newType = DT_UINT;
+    else if (strcmp(typeStr, "FLOAT") == 0) newType = DT_FLOAT;
+    else if (strcmp(typeStr, "STRING") == 0 || strcmp(typeStr, "DICT") == 0) newType = DT_STRING;
+    else return false;
+
+
+    Attribute *newAttrs = realloc(table->Attributes, sizeof(Attribute) * (table->AttributeCount + 1));
+    if (!newAttrs) return false;
+    table->Attributes = newAttrs;
+
+    Column *newColumns = realloc(table->Columns, sizeof(Column) * (table->AttributeCount + 1));
+    if (!newColumns) return false;
+    table->Columns = newColumns;
+
+    Column *column = &table->Columns[table->AttributeCount];
+    memset(column, 0, sizeof(Column));
+    column->Values = calloc(table->RowCapacity, ColumnWidth(newType));
+    column->Zones = malloc(sizeof(ZoneMap) * ((table->RowCapacity + ZONE_ROWS - 1) / ZONE_ROWS));
+    if (!column->Values || !column->Zones) {
+        free(column->Values);
+        free(column->Zones);
+        return false;
+    }
+
+    if (newType == DT_STRING) {
+        StringRef *refs = column->Values;
+        for (size_t i = 0; i < table->RowCount; ++i) {
+            if (!ArenaStoreString(&table->Strings, "", 0, &refs[i])) {
+                for (size_t j = 0; j < i; ++j) ArenaFreeString(&table->Strings, refs[j]);
+                free(column->Values);
+                free(column->Zones);
+                return false;
+            }
+        }
+    }
+
+    // Interned before the column joins the schema, so a failure leaves the table as it was.
+    table->Attributes[table->AttributeCount].AttributeType = newType;
+    if (strcmp(typeStr, "DICT") == 0 && !InternColumn(table, table->AttributeCount)) {
+        StringRef *refs = column->Values;
+        for (size_t i = 0; i < table->RowCount; ++i) ArenaFreeString(&table->Strings, refs[i]);
+        free(column->Values);
+        free(column->Zones);
+        return false;
+    }
+
+    table->Attributes[table->AttributeCount].AttributeName = strdup(columnName);
+    table->AttributeCount++;
+    RebuildSchemaMap(table);
+    RebuildColumnZoneMap(table, table->AttributeCount - 1);
+    LogAddColumn(table, columnName, typeStr);
+
+    return true;
+}
+
+bool AlterDropColumn(Table *table, const char *columnName) {
+    if (!table || !columnName) return false;
+
+    ColumnHandle column;
+    if (!ResolveColumn(table, columnName, &column)) return false;
+    return AlterDropColumnAt(table, column);
+}
+
+bool AlterDropColumnAt(Table *table, ColumnHandle column) {
+    if (!table || !ColumnHandleValid(table, column)) return false;
+
+    size_t colIndex = column.Index;
+    char *columnName = table->Attributes[colIndex].AttributeName;
+
+    DropIndex(table, colIndex);
+    if (table->Columns[colIndex].Dict) {
+        ReleaseColumnDictionary(table, colIndex);
+    } else if (table->Attributes[colIndex].AttributeType == DT_STRING) {
+        StringRef *refs = table->Columns[colIndex].Values;
+        for (size_t i = 0; i < table->RowCount; ++i) {
+            ArenaFreeString(&table->Strings, refs[i]);
+        }
+    }
+    if (!table->Columns[colIndex].Mapped) free(table->Columns[colIndex].Values);
+    free(table->Columns[colIndex].Zones);
+
+
+    for (size_t i = colIndex; i < table->AttributeCount - 1; ++i) {
+        table->Attributes[i] = table->Attributes[i + 1];
+        table->Columns[i] = table->Columns[i + 1];
+    }
+
+    Attribute *shrunkAttrs = realloc(table->Attributes, sizeof(Attribute) * (table->AttributeCount - 1));
+    if (shrunkAttrs) table->Attributes = shrunkAttrs;
+
+    table->AttributeCount--;
+    RebuildSchemaMap(table);
+    MaybeCompactStrings(table);
+    LogDropColumn(table, columnName);
+    free(columnName);
+    return true;
+}
+
+bool DeleteTableFile(const char *tableName) {
+    if (!tableName) return false;
+
+    char filename[200];
+    snprintf(filename, sizeof(filename), "data/%s.tbl", tableName);
+
+    RemoveTableLog(tableName);
+    if (remove(filename) == 0) {
+        printf("File '%s' deleted from disk.\n", filename);
+        return true;
+    } else {
+        printf("Failed to delete '%s'. File may not exist.\n", filename);
+        return false;
+    }
+}
+
+void PrintTableStats(const Table *table) {
+    if (!table) return;
+
+    ArenaStats stats;
+    GetArenaStats(&table->Strings, &stats);
+
+    printf("Table '%s': %zu rows, %zu columns, %zu deleted rows awaiting compaction\n", table->TableName,
+           table->RowCount - table->DeletedCount, table->AttributeCount, table->DeletedCount);
+    size_t mapped = 0;
+    for (size_t j = 0; j < table->AttributeCount; ++j) mapped += table->Columns[j].Mapped ? 1 : 0;
+    if (table->Mapping) printf("Mapped from disk: %zu of %zu columns\n", mapped, table->AttributeCount);
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        const ColumnDictionary *dict = table->Columns[j].Dict;
+        if (dict) printf("Column '%s' is interned: %zu distinct values\n", table->Attributes[j].AttributeName, dict->Count);
+    }
+    printf("String arena: %zu chunks, %zu bytes reserved, %zu live, %zu free, %zu waste\n",
+           stats.ChunkCount, stats.BytesReserved, stats.BytesLive, stats.BytesFree, stats.BytesWaste);
+}
@@ -1,32 +1,368 @@
-#ifndef FUNCTIONS_H
-#define FUNCTIONS_H
-#include "database.h"
-#include <stdbool.h>
-#include <stddef.h>
-typedef enum {
-    OP_EQ, OP_NEQ, OP_GT, OP_LT, OP_GTE, OP_LTE, OP_UNKNOWN
-} CompareOperator;
-
-Table *CreateTable(const char *TableName, Attribute *Attributes, size_t AttributeCount);
-void FreeTable(Table *table);
-void DisplayTable(const Table *table);
-bool InsertRow(Table *table, void **values);
-bool PromptAndInsertRow(Table *table);
-bool SaveTableToFile(const Table *table);
-Table *LoadTableFromFile(const char *filename);
-void ListTablesFromServer(void);
-Table *LoadTableFromServer(const char *filename);
-void FreeFileList(char **files, int count);
-Table *PromptAndCreateTable();
-void FilterAndDisplayTable(const Table *table, const char *columnName, const char *valueAsString);
-bool Compare(DataTypes type, void *left, const char *rightLiteral, CompareOperator op);
-CompareOperator ParseOperator(const char *op);
-bool SelectQuery(Table *table, const char *columnName, const char *operator, const char *valueLiteral);
-size_t DeleteRows(Table *table, const char *columnName, const char *operator, const char *valueLiteral);
-size_t UpdateRows(Table *table, const char *targetColumn, const char *newValueLiteral, const char *filterColumn, const char *operator, const char *filterValueLiteral);
-bool AlterAddColumn(Table *table, const char *columnName, const char *typeStr);
-bool AlterDropColumn(Table *table, const char *columnName);
-bool DeleteTableFile(const char *tableName);
-void SendFileToServer(const char *filename);
-
-#endif //FUNCTIONS_H
+#ifndef FUNCTIONS_H
+#define FUNCTIONS_H
+#include "database.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// 64-bit file positions: long is 32 bits on Windows, so ftell/fseek stop at 2 GB.
+#ifdef _WIN32
+    #define FILE_SEEK(file, offset, whence) _fseeki64(file, (__int64)(offset), whence)
+    #define FILE_TELL(file) ((int64_t)_ftelli64(file))
+#else
+    #define FILE_SEEK(file, offset, whence) fseeko(file, (off_t)(offset), whence)
+    #define FILE_TELL(file) ((int64_t)ftello(file))
+#endif
+
+typedef enum {
+    OP_EQ, OP_NEQ, OP_GT, OP_LT, OP_GTE, OP_LTE, OP_UNKNOWN
+} CompareOperator;
+
+// Rows handed to a filter kernel per call.
+#define SCAN_BLOCK_ROWS 4096
+
+// Parallel scans hand each thread morsels of this many rows; tables shorter than
+// PARALLEL_MIN_ROWS are scanned on the calling thread.
+#define MORSEL_ROWS         (4 * SCAN_BLOCK_ROWS)
+#define PARALLEL_MIN_ROWS   (8 * MORSEL_ROWS)
+
+typedef void (*ParallelTask)(void *context, size_t worker, size_t index);
+// Writes the matching ids of [begin, end) to out and returns how many; (size_t)-1 on failure.
+typedef size_t (*MorselScan)(void *context, size_t worker, size_t begin, size_t end, size_t *out);
+
+// A `column op literal` filter with the literal parsed once and a kernel specialized for the
+// column type and operator.
+typedef struct Predicate Predicate;
+typedef size_t (*PredicateKernel)(const Predicate *pred, const Table *table, size_t begin, size_t end, size_t *out);
+typedef size_t (*PredicateRefineKernel)(const Predicate *pred, const Table *table, const size_t *in, size_t count, size_t *out);
+
+struct Predicate {
+    size_t Column;
+    DataTypes Type;
+    CompareOperator Op;
+    union {
+        int Int;
+        unsigned int Uint;
+        float Float;
+        char *String;
+    } Literal;
+    PredicateKernel Kernel;
+    PredicateRefineKernel Refine;
+    uint32_t Code;            // literal's code on an interned column, UINT32_MAX if absent
+    unsigned char *CodeMatches;  // per code of an interned column, whether it satisfies Op
+    uint64_t Key;             // literal as an index key, for zone map checks
+    bool Zoned;               // whether zone maps can rule groups out
+};
+
+// A WHERE clause: comparisons combined with AND, OR and NOT. AND/OR children are kept in
+// the order they are evaluated, cheapest and most decisive first.
+typedef enum {
+    COND_PREDICATE, COND_AND, COND_OR, COND_NOT
+} ConditionKind;
+
+typedef struct Condition Condition;
+
+struct Condition {
+    ConditionKind Kind;
+    Predicate Pred;           // COND_PREDICATE
+    char *Literal;            // COND_PREDICATE, as written, for index lookups
+    bool IndexBacked;         // COND_PREDICATE an index can answer
+    Condition **Children;     // AND/OR: ChildCount children, NOT: one
+    size_t ChildCount;
+    double Selectivity;       // estimated share of rows that match
+    double Cost;              // estimated relative cost of testing one row
+    size_t Id;                // position in the tree, selects the node's scratch vectors
+    size_t Parameter;         // COND_PREDICATE: number of its ? placeholder, SIZE_MAX for a literal
+};
+
+// Encodings of .tbl column sections, recorded per column in the file footer.
+typedef enum {
+    ENCODING_PLAIN, ENCODING_RLE, ENCODING_DELTA, ENCODING_BITPACK, ENCODING_DICT
+} ColumnEncoding;
+
+// Largest encoded size of a group of rows in any numeric encoding.
+#define CODEC_GROUP_BOUND(rows) (5 * (rows) + 16)
+
+// Distinct strings of a column in order of first appearance and each row's code.
+typedef struct {
+    const char **Entries;
+    size_t Count;
+    uint32_t *Codes;
+} StringDictionary;
+
+// The entries of an interned column copied into another arena, plus the renumbering of its codes
+// and a hash sized for them, ready to replace the column's dictionary.
+typedef struct {
+    uint32_t *Remap;
+    StringRef *Entries;
+    size_t Count;
+    uint32_t *Slots;
+    size_t SlotCount;
+} DictionaryCompaction;
+
+// Rows for InsertRows, stored a column at a time: int, unsigned int or float arrays for the
+// numeric columns and char * arrays for STRING ones. An Owned batch was built with malloc and
+// passes to the table, which keeps the numeric arrays when it is empty and frees the rest.
+typedef struct {
+    void **Columns;
+    bool Owned;
+} RowBatch;
+
+// A column looked up by name once, for calls that would otherwise find it again each time.
+// It holds while the table's SchemaVersion is unchanged; adding or dropping a column makes
+// it stale, and calls taking it refuse stale handles.
+typedef struct {
+    size_t Index;
+    uint64_t Version;
+} ColumnHandle;
+
+// ORDER BY column [ASC|DESC] [LIMIT n [OFFSET m]]; Limit is SIZE_MAX without a LIMIT.
+typedef struct {
+    size_t Column;
+    bool Descending;
+    size_t Limit;
+    size_t Offset;
+} OrderBy;
+
+// A row of the left and a row of the right table whose join keys are equal.
+typedef struct {
+    size_t Left;
+    size_t Right;
+} JoinPair;
+
+// Row ids handed to result set consumers per batch when rendering or materializing.
+#define RESULT_BATCH_ROWS 4096
+
+// Rows of a query over a table: a selection vector in output order, the columns shown and
+// an offset/limit window, consumed a batch at a time through ResultSetNext.
+typedef struct {
+    const Table *Table;
+    size_t *Rows;             // row ids in output order, unless AllRows
+    size_t RowCount;
+    bool AllRows;             // streams every live row in table order instead
+    size_t *Columns;          // ColumnCount table columns shown, in order
+    size_t ColumnCount;
+    size_t Offset;            // rows skipped before the first one returned
+    size_t Limit;             // most rows returned, SIZE_MAX for all
+    size_t Cursor;            // next position in Rows, or next table row
+    size_t Skipped;           // offset rows passed so far when streaming
+    size_t Returned;          // rows returned since the last rewind
+} ResultSet;
+
+// Parsed SQL statements kept by a session, keyed by their normalized text.
+typedef struct Statement Statement;
+
+#define STATEMENT_CACHE_SIZE 64
+
+// SQL runs against the loaded tables, which CREATE TABLE adds to. Statements that read or
+// change rows stay cached until the schema changes; Hits and Misses count cache lookups.
+typedef struct {
+    Table **Tables;
+    size_t *TableCount;
+    size_t MaxTables;
+    Statement *Cache[STATEMENT_CACHE_SIZE];
+    size_t CacheCount;
+    uint64_t Clock;
+    size_t Hits;
+    size_t Misses;
+} SqlSession;
+
+// Instruction sets the numeric filter kernels can use, detected at runtime.
+typedef enum {
+    SIMD_UNSET = -1, SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2
+} SimdLevel;
+
+Table *CreateTable(const char *TableName, Attribute *Attributes, size_t AttributeCount);
+void FreeTable(Table *table);
+void DisplayTable(const Table *table);
+bool DisplayTablePage(const Table *table, size_t page, size_t pageRows);
+void *GetCell(const Table *table, size_t col, size_t row);
+void PrintCell(const Table *table, size_t col, size_t row, int width);
+bool ReserveRows(Table *table, size_t rows);
+bool InsertRow(Table *table, void **values);
+bool InsertRows(Table *table, RowBatch *batch, size_t count);
+bool PromptAndInsertRow(Table *table);
+bool SaveTableToFile(Table *table);
+Table *LoadTableFromFile(const char *filename);
+bool SaveTableFile(Table *table, const char *path, uint64_t *fileBytes);
+void RemapTableFile(Table *table, const char *path);
+void SetAtomicSaves(bool enabled);
+void SetMappedLoads(bool enabled);
+bool IsTableFileV2(FILE *file);
+Table *ReadTableFile(FILE *file, uint64_t *fileBytes);
+void UnmapTableFile(TableMapping *mapping);
+
+ColumnEncoding ChooseNumericEncoding(DataTypes type, const uint32_t *values, size_t rows);
+size_t EncodeNumericGroup(ColumnEncoding encoding, DataTypes type, const uint32_t *values, size_t count,
+                          unsigned char *out);
+bool DecodeNumericGroup(ColumnEncoding encoding, DataTypes type, const unsigned char *in, size_t size,
+                        uint32_t *values, size_t count);
+bool BuildStringDictionary(const Table *table, size_t col, StringDictionary *dict);
+bool DictionaryPaysOff(const StringDictionary *dict, const Table *table, size_t col);
+void FreeStringDictionary(StringDictionary *dict);
+
+void OpenTableLog(Table *table, const char *basePath, uint64_t baseBytes);
+void ResetTableLog(Table *table, const char *basePath, uint64_t baseBytes);
+void CloseTableLog(Table *table);
+void RemoveTableLog(const char *tableName);
+bool SyncTableLog(Table *table);
+void GetTableLogSize(const Table *table, uint64_t *logBytes, uint64_t *baseBytes);
+void LogBulkChange(Table *table);
+void LogInsertRow(Table *table, void **values);
+void LogInsertRows(Table *table, size_t begin, size_t end);
+void LogUpdateRows(Table *table, const char *column, const char *value, const char *where);
+void LogDeleteRows(Table *table, const char *where);
+void LogAddColumn(Table *table, const char *column, const char *type);
+void LogDropColumn(Table *table, const char *column);
+bool SaveTable(Table *table);
+bool AttachMappedColumns(Table *table, size_t rows, void **values);
+bool ReleaseTableMapping(Table *table);
+bool ReleaseTableFile(Table **tables, size_t tableCount, const char *name);
+void ListTablesFromServer(void);
+Table *LoadTableFromServer(const char *filename);
+void FreeFileList(char **files, int count);
+Table *PromptAndCreateTable();
+void FilterAndDisplayTable(const Table *table, const char *columnName, const char *valueAsString);
+void FilterAndDisplayColumn(const Table *table, ColumnHandle column, const char *valueAsString);
+bool Compare(DataTypes type, void *left, const char *rightLiteral, CompareOperator op);
+CompareOperator ParseOperator(const char *op);
+size_t FindMatchingRows(Table *table, const char *where, size_t **rows);
+bool ParseOrderBy(const Table *table, const char *text, OrderBy *order);
+size_t *SortRows(const Table *table, const size_t *rows, size_t count, const OrderBy *order, size_t *sortedCount);
+bool SelectQuery(Table *table, const char *columns, const char *where, const char *orderBy);
+ResultSet *CreateResultSet(const Table *table, size_t *rows, size_t count);
+ResultSet *TableResultSet(const Table *table);
+ResultSet *ExecuteQuery(Table *table, const char *columns, const char *where, const char *orderBy);
+bool ProjectResultSet(ResultSet *result, const char *list);
+bool ProjectResultSetColumns(ResultSet *result, const ColumnHandle *columns, size_t count);
+void ResultSetLimit(ResultSet *result, size_t offset, size_t limit);
+void ResultSetRewind(ResultSet *result);
+size_t ResultSetCount(const ResultSet *result);
+size_t ResultSetNext(ResultSet *result, size_t *rows, size_t max);
+size_t RenderResultSet(ResultSet *result);
+Table *MaterializeResultSet(ResultSet *result, const char *name);
+void FreeResultSet(ResultSet *result);
+void InitSqlSession(SqlSession *session, Table **tables, size_t *tableCount, size_t maxTables);
+void ClearStatementCache(SqlSession *session);
+bool ExecuteSql(SqlSession *session, const char *sql, const char *const *parameters, size_t parameterCount);
+size_t RunSqlText(SqlSession *session, const char *text);
+size_t RunSqlScript(SqlSession *session, FILE *file);
+bool AggregateQuery(Table *table, const char *aggregates, const char *groupBy, const char *where);
+size_t HashJoin(const Table *left, size_t leftCol, const Table *right, size_t rightCol, JoinPair **pairs);
+Table *JoinTables(const Table *left, const char *leftColumn, const Table *right, const char *rightColumn, const char *name);
+size_t DeleteRows(Table *table, const char *where);
+size_t DeleteMatchedRows(Table *table, size_t *rows, size_t count, const char *where);
+size_t UpdateRows(Table *table, const char *targetColumn, const char *newValueLiteral, const char *where);
+size_t UpdateColumnRows(Table *table, ColumnHandle column, const char *newValueLiteral, const char *where);
+size_t UpdateMatchedRows(Table *table, size_t col, const char *newValueLiteral, size_t *rows, size_t count, const char *where);
+bool AlterAddColumn(Table *table, const char *columnName, const char *typeStr);
+bool AlterDropColumn(Table *table, const char *columnName);
+bool AlterDropColumnAt(Table *table, ColumnHandle column);
+bool DeleteTableFile(const char *tableName);
+void SendFileToServer(const char *filename);
+
+void InitArena(Arena *arena);
+void FreeArena(Arena *arena);
+char *ArenaAllocString(Arena *arena, size_t len, StringRef *ref);
+bool ArenaStoreString(Arena *arena, const char *str, size_t len, StringRef *ref);
+bool ArenaBorrowChunk(Arena *arena, char *base, size_t size, size_t *index);
+void ArenaFreeString(Arena *arena, StringRef ref);
+bool ArenaNeedsCompaction(const Arena *arena);
+
+bool InternColumn(Table *table, size_t col);
+bool InternString(Table *table, size_t col, const char *str, uint32_t *code);
+uint32_t FindDictionaryCode(const Table *table, size_t col, const char *str);
+const char *DictionaryString(const Table *table, size_t col, uint32_t code);
+bool AddDictionaryEntry(Table *table, size_t col, StringRef ref, uint32_t *code);
+bool StageDictionaryCompaction(const Table *table, size_t col, Arena *into, DictionaryCompaction *staged);
+void CommitDictionaryCompaction(Table *table, size_t col, const Arena *into, DictionaryCompaction *staged);
+void DiscardDictionaryCompaction(DictionaryCompaction *staged);
+void ReleaseColumnDictionary(Table *table, size_t col);
+void FreeColumnDictionary(ColumnDictionary *dict);
+void GetArenaStats(const Arena *arena, ArenaStats *stats);
+void PrintTableStats(const Table *table);
+void CompactTable(Table *table);
+int FindColumn(const Table *table, const char *columnName);
+void RebuildSchemaMap(Table *table);
+bool ResolveColumn(const Table *table, const char *columnName, ColumnHandle *column);
+bool ColumnHandleValid(const Table *table, ColumnHandle column);
+
+BTree *BTreeCreate(const char *path, DataTypes keyType);
+BTree *BTreeOpen(const char *path);
+void BTreeClose(BTree *tree);
+bool BTreeFlush(BTree *tree);
+const char *BTreePath(const BTree *tree);
+size_t BTreeEntryCount(const BTree *tree);
+bool BTreeIsSynced(const BTree *tree, uint64_t tableBytes);
+bool BTreeMarkSynced(BTree *tree, uint64_t tableBytes);
+bool BTreeInsert(BTree *tree, uint64_t key, uint64_t row);
+bool BTreeDelete(BTree *tree, uint64_t key, uint64_t row);
+size_t BTreeSearchRange(BTree *tree, uint64_t low, uint64_t high, size_t **rows);
+bool BTreeBulkLoad(BTree *tree, BTreeEntry *entries, size_t count);
+uint64_t EncodeIndexKey(DataTypes type, const void *value);
+
+HashIndex *BuildHashIndex(const Table *table, size_t col);
+void FreeHashIndex(HashIndex *index);
+bool HashIndexInsert(HashIndex *index, const Table *table, size_t col, size_t row);
+bool HashIndexInsertRows(HashIndex *index, const Table *table, size_t col, size_t begin, size_t end);
+void HashIndexRemove(HashIndex *index, const Table *table, size_t col, size_t row);
+size_t HashIndexLookup(HashIndex *index, const Table *table, size_t col, const char *literal, size_t **rows);
+
+bool CompilePredicate(const Table *table, size_t col, CompareOperator op, const char *literal, Predicate *pred);
+void FreePredicate(Predicate *pred);
+size_t RunPredicate(const Predicate *pred, const Table *table, size_t begin, size_t end, size_t *out);
+size_t RefinePredicate(const Predicate *pred, const Table *table, const size_t *in, size_t count, size_t *out);
+size_t ScanPredicate(const Predicate *pred, const Table *table, size_t **rows);
+size_t DropDeletedRows(const Table *table, size_t *rows, size_t count);
+
+void ZoneMapAppendRow(Table *table, size_t row);
+void ZoneMapAppendRows(Table *table, size_t begin, size_t end);
+void ZoneMapUpdateCell(Table *table, size_t col, size_t row);
+void RebuildColumnZoneMap(Table *table, size_t col);
+void RebuildZoneMaps(Table *table);
+bool ZonesMayMatch(const Predicate *pred, const Table *table, size_t begin, size_t end);
+void ZoneMapPreparePredicate(Predicate *pred);
+void WriteZoneMaps(const Table *table, FILE *file);
+void ReadZoneMaps(Table *table, FILE *file);
+
+Condition *ParseCondition(const Table *table, const char *text);
+Condition *PrepareCondition(const Table *table, const char *text, size_t *parameterCount);
+bool BindCondition(const Table *table, Condition *cond, const char *const *values);
+void FreeCondition(Condition *cond);
+size_t EvaluateCondition(Table *table, Condition *cond, size_t **rows);
+
+SimdLevel DetectSimdLevel(void);
+SimdLevel GetSimdLevel(void);
+void SetSimdLevel(SimdLevel level);
+const char *SimdLevelName(SimdLevel level);
+PredicateKernel SelectSimdKernel(DataTypes type, CompareOperator op);
+void RunScanBenchmark(size_t rowCount);
+size_t FindFieldEnd(const char *text, size_t len, char delimiter);
+bool ImportTable(Table *table, const char *path);
+bool ParseIntField(const char *text, int *value);
+bool ParseUintField(const char *text, unsigned int *value);
+bool ParseFloatField(const char *text, float *value);
+
+size_t GetScanThreads(void);
+void SetScanThreads(size_t threads);
+void ShutdownThreadPool(void);
+void ParallelFor(size_t taskCount, ParallelTask task, void *context);
+size_t ParallelScan(size_t itemCount, MorselScan scan, void *context, size_t **rows);
+
+bool CreateIndex(Table *table, const char *columnName);
+bool CreateHashIndex(Table *table, const char *columnName);
+bool RebuildIndex(Table *table, size_t col);
+void RebuildTableIndexes(Table *table);
+void DropIndex(Table *table, size_t col);
+void IndexInsertRow(Table *table, size_t row);
+void IndexInsertRows(Table *table, size_t begin, size_t end);
+void IndexRemoveCell(Table *table, size_t col, size_t row);
+void IndexAddCell(Table *table, size_t col, size_t row);
+bool IndexCanAnswer(const Table *table, size_t col, CompareOperator op);
+size_t IndexLookup(Table *table, size_t col, CompareOperator op, const char *literal, size_t **rows);
+void OpenTableIndexes(Table *table, uint64_t tableBytes);
+void SyncTableIndexes(Table *table, uint64_t tableBytes);
+void CloseTableIndexes(Table *table);
+bool RenameTableIndexes(Table *table, const char *oldName);
+
+#endif //FUNCTIONS_H
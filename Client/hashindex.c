@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "functions.h"
+#include "database.h"
+
+#define HASH_INITIAL_SLOTS  1024
+#define HASH_NO_ROW         SIZE_MAX
+
+// Open-addressing table from key to the first row holding it; rows sharing a key are chained
+// through Next/Prev so one can be unlinked in O(1). String keys are 64-bit hashes, so string
+// lookups compare the actual text of every chained row.
+struct HashIndex {
+    DataTypes Type;
+
+    uint64_t *Keys;
+    size_t *Heads;
+    size_t SlotCount;
+    size_t SlotsUsed;
+
+    size_t *Next;
+    size_t *Prev;
+    size_t RowCapacity;
+};
+
+static uint64_t MixBits(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static uint64_t HashString(const char *str) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char *)str; *p; ++p) {
+        h ^= *p;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static uint64_t CellKey(DataTypes type, const void *value) {
+    switch (type) {
+        case DT_INT: return (uint64_t)(uint32_t)*(const int *)value;
+        case DT_UINT: return *(const unsigned int *)value;
+        case DT_STRING: {
+            uint64_t h = HashString(value);
+            return h == UINT64_MAX ? h - 1 : h;
+        }
+        default: return 0;
+    }
+}
+
+// Keys are stored as key + 1 so an all-zero slot means empty; a slot whose chain emptied
+// keeps its key and is reused if that key comes back.
+static bool SlotEmpty(const HashIndex *index, size_t slot) {
+    return index->Keys[slot] == 0;
+}
+
+// Returns the slot holding key, or the empty slot where it would go.
+static size_t FindSlot(const HashIndex *index, uint64_t key) {
+    size_t mask = index->SlotCount - 1;
+    size_t slot = (size_t)MixBits(key) & mask;
+    while (!SlotEmpty(index, slot)) {
+        if (index->Keys[slot] == key + 1) return slot;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static bool ReserveChains(HashIndex *index, size_t rows) {
+    if (rows <= index->RowCapacity) return true;
+
+    size_t capacity = index->RowCapacity ? index->RowCapacity : 64;
+    while (capacity < rows) capacity *= 2;
+    size_t *next = realloc(index->Next, sizeof(size_t) * capacity);
+    if (!next) return false;
+    index->Next = next;
+    size_t *prev = realloc(index->Prev, sizeof(size_t) * capacity);
+    if (!prev) return false;
+    index->Prev = prev;
+    index->RowCapacity = capacity;
+    return true;
+}
+
+static bool AllocSlots(HashIndex *index, size_t slotCount) {
+    index->Keys = calloc(slotCount, sizeof(uint64_t));
+    index->Heads = malloc(sizeof(size_t) * slotCount);
+    if (!index->Keys || !index->Heads) return false;
+    for (size_t i = 0; i < slotCount; ++i) index->Heads[i] = HASH_NO_ROW;
+    index->SlotCount = slotCount;
+    index->SlotsUsed = 0;
+    return true;
+}
+
+static bool Grow(HashIndex *index) {
+    uint64_t *oldKeys = index->Keys;
+    size_t *oldHeads = index->Heads;
+    size_t oldCount = index->SlotCount;
+
+    // Slots whose chains emptied still take part in probing, so they count towards the load
+    // factor; rehashing drops them, and the table only doubles if live keys need the room.
+    size_t live = 0;
+    for (size_t i = 0; i < oldCount; ++i) {
+        if (oldKeys[i] != 0 && oldHeads[i] != HASH_NO_ROW) live++;
+    }
+    size_t newCount = (live + 1) * 10 > oldCount * 7 / 2 ? oldCount * 2 : oldCount;
+    if (!AllocSlots(index, newCount)) {
+        free(index->Keys);
+        free(index->Heads);
+        index->Keys = oldKeys;
+        index->Heads = oldHeads;
+        index->SlotCount = oldCount;
+        return false;
+    }
+
+    for (size_t i = 0; i < oldCount; ++i) {
+        if (oldKeys[i] == 0 || oldHeads[i] == HASH_NO_ROW) continue;
+        size_t slot = FindSlot(index, oldKeys[i] - 1);
+        index->Keys[slot] = oldKeys[i];
+        index->Heads[slot] = oldHeads[i];
+        index->SlotsUsed++;
+    }
+
+    free(oldKeys);
+    free(oldHeads);
+    return true;
+}
+
+static bool LinkRow(HashIndex *index, uint64_t key, size_t row) {
+    if (!ReserveChains(index, row + 1)) return false;
+    if ((index->SlotsUsed + 1) * 10 > index->SlotCount * 7 && !Grow(index)) return false;
+
+    size_t slot = FindSlot(index, key);
+    if (SlotEmpty(index, slot)) {
+        index->Keys[slot] = key + 1;
+        index->SlotsUsed++;
+    }
+
+    size_t head = index->Heads[slot];
+    index->Next[row] = head;
+    index->Prev[row] = HASH_NO_ROW;
+    if (head != HASH_NO_ROW) index->Prev[head] = row;
+    index->Heads[slot] = row;
+    return true;
+}
+
+HashIndex *BuildHashIndex(const Table *table, size_t col) {
+    DataTypes type = table->Attributes[col].AttributeType;
+    if (type == DT_FLOAT) return NULL;
+
+    HashIndex *index = calloc(1, sizeof(HashIndex));
+    if (!index) return NULL;
+    index->Type = type;
+
+    size_t slotCount = HASH_INITIAL_SLOTS;
+    while (slotCount * 7 < table->RowCount * 10) slotCount *= 2;
+    if (!AllocSlots(index, slotCount) || !ReserveChains(index, table->RowCount)) {
+        FreeHashIndex(index);
+        return NULL;
+    }
+
+    for (size_t i = table->RowCount; i-- > 0;) {
+        if (IsRowDeleted(table, i)) continue;
+        if (!LinkRow(index, CellKey(type, GetCell(table, col, i)), i)) {
+            FreeHashIndex(index);
+            return NULL;
+        }
+    }
+    return index;
+}
+
+void FreeHashIndex(HashIndex *index) {
+    if (!index) return;
+    free(index->Keys);
+    free(index->Heads);
+    free(index->Next);
+    free(index->Prev);
+    free(index);
+}
+
+bool HashIndexInsert(HashIndex *index, const Table *table, size_t col, size_t row) {
+    return LinkRow(index, CellKey(index->Type, GetCell(table, col, row)), row);
+}
+
+// Links the appended rows [begin, end), sizing the chains once for the whole batch.
+bool HashIndexInsertRows(HashIndex *index, const Table *table, size_t col, size_t begin, size_t end) {
+    if (!ReserveChains(index, end)) return false;
+    for (size_t i = begin; i < end; ++i) {
+        if (!LinkRow(index, CellKey(index->Type, GetCell(table, col, i)), i)) return false;
+    }
+    return true;
+}
+
+// Unlinks a row; call it while the cell still holds the value the row was indexed under.
+void HashIndexRemove(HashIndex *index, const Table *table, size_t col, size_t row) {
+    size_t prev = index->Prev[row], next = index->Next[row];
+    if (prev != HASH_NO_ROW) {
+        index->Next[prev] = next;
+    } else {
+        size_t slot = FindSlot(index, CellKey(index->Type, GetCell(table, col, row)));
+        if (!SlotEmpty(index, slot)) index->Heads[slot] = next;
+    }
+    if (next != HASH_NO_ROW) index->Prev[next] = prev;
+}
+
+// Collects the rows whose cell equals literal, in chain order; (size_t)-1 if memory runs out.
+size_t HashIndexLookup(HashIndex *index, const Table *table, size_t col, const char *literal, size_t **rows) {
+    *rows = NULL;
+
+    uint64_t key;
+    if (index->Type == DT_INT) {
+        int value = atoi(literal);
+        key = CellKey(DT_INT, &value);
+    } else if (index->Type == DT_UINT) {
+        unsigned int value = (unsigned int)strtoul(literal, NULL, 10);
+        key = CellKey(DT_UINT, &value);
+    } else {
+        key = CellKey(DT_STRING, literal);
+    }
+
+    size_t slot = FindSlot(index, key);
+    if (SlotEmpty(index, slot)) return 0;
+
+    size_t count = 0, capacity = 0;
+    for (size_t row = index->Heads[slot]; row != HASH_NO_ROW; row = index->Next[row]) {
+        if (index->Type == DT_STRING && strcmp(GetCell(table, col, row), literal) != 0) continue;
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            size_t *grown = realloc(*rows, sizeof(size_t) * capacity);
+            if (!grown) {
+                free(*rows);
+                *rows = NULL;
+                return (size_t)-1;
+            }
+            *rows = grown;
+        }
+        (*rows)[count++] = row;
+    }
+    return count;
+}
@@ -0,0 +1,425 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+
+#include "functions.h"
+#include "database.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+// Bulk loading of CSV and TSV files. The file is read in large chunks and split into records
+// in place: unquoted fields are skipped over with the vector scanner, quoted ones ("a, ""b""")
+// may hold delimiters, quotes and line breaks. Every field of a line is checked against the
+// column types before anything is stored, so a bad line is reported and skipped whole.
+// Good lines are gathered into batches that go to InsertRows before the chunk buffer moves.
+
+#define IMPORT_CHUNK_BYTES      (4 * 1024 * 1024)
+#define IMPORT_BAD_LINES_SHOWN  10
+#define IMPORT_BATCH_ROWS       4096
+
+typedef struct {
+    char *Text;
+    size_t Len;
+    bool Quoted;
+} Field;
+
+typedef struct {
+    FILE *File;
+    char *Buffer;
+    size_t Capacity;
+    size_t Begin;       // first byte not yet parsed
+    size_t End;         // bytes held
+    bool Eof;
+} ChunkReader;
+
+typedef struct {
+    Field *Fields;
+    size_t Count;
+    size_t Capacity;
+    size_t Lines;       // line breaks the record spans, its own included
+    bool Malformed;
+} Record;
+
+static double NowSeconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+// Moves the unparsed tail to the front and reads more after it, doubling the buffer when one
+// record fills it. One byte is always kept free so the last field can be NUL-terminated.
+static bool Refill(ChunkReader *reader) {
+    if (reader->Eof) return false;
+
+    size_t left = reader->End - reader->Begin;
+    memmove(reader->Buffer, reader->Buffer + reader->Begin, left);
+    reader->Begin = 0;
+    reader->End = left;
+
+    if (reader->Capacity - reader->End - 1 < IMPORT_CHUNK_BYTES / 2) {
+        char *grown = realloc(reader->Buffer, reader->Capacity * 2);
+        if (!grown) return false;
+        reader->Buffer = grown;
+        reader->Capacity *= 2;
+    }
+
+    size_t got = fread(reader->Buffer + reader->End, 1, reader->Capacity - reader->End - 1, reader->File);
+    reader->End += got;
+    if (got == 0) reader->Eof = true;
+    return true;
+}
+
+static bool AddField(Record *record, char *text, size_t len, bool quoted) {
+    if (record->Count == record->Capacity) {
+        size_t capacity = record->Capacity ? record->Capacity * 2 : 16;
+        Field *grown = realloc(record->Fields, sizeof(Field) * capacity);
+        if (!grown) return false;
+        record->Fields = grown;
+        record->Capacity = capacity;
+    }
+    record->Fields[record->Count++] = (Field){text, len, quoted};
+    return true;
+}
+
+static size_t CountLineBreaks(const char *text, size_t len) {
+    size_t lines = 0;
+    for (const char *p = text, *end = text + len; (p = memchr(p, '\n', (size_t)(end - p))) != NULL; ++p) lines++;
+    return lines;
+}
+
+typedef enum {
+    SPLIT_RECORD,       // a whole record was split off
+    SPLIT_MORE,         // the record runs past the buffered bytes
+    SPLIT_END,          // nothing left
+    SPLIT_FAILED,       // out of memory
+} SplitResult;
+
+// Splits the record at the reader position into fields without changing the buffer, so a
+// record cut off by the chunk end can be split again once more bytes are in.
+static SplitResult SplitRecord(const ChunkReader *reader, char delimiter, Record *record, size_t *next) {
+    char *buffer = reader->Buffer;
+    size_t p = reader->Begin, end = reader->End;
+    record->Count = 0;
+    record->Lines = 0;
+    record->Malformed = false;
+    if (p == end) return SPLIT_END;
+
+    for (;;) {
+        size_t fieldEnd;
+        if (p < end && buffer[p] == '"') {
+            // A quote ends the field unless another follows it; "" stands for one quote.
+            size_t q = p + 1;
+            for (;;) {
+                char *quote = memchr(buffer + q, '"', end - q);
+                if (!quote) {
+                    if (!reader->Eof) return SPLIT_MORE;
+                    record->Malformed = true;
+                    q = end;
+                    break;
+                }
+                q = (size_t)(quote - buffer);
+                if (q + 1 == end && !reader->Eof) return SPLIT_MORE;
+                if (q + 1 < end && buffer[q + 1] == '"') {
+                    q += 2;
+                    continue;
+                }
+                break;
+            }
+            if (!AddField(record, buffer + p + 1, q - p - 1, true)) return SPLIT_FAILED;
+            record->Lines += CountLineBreaks(buffer + p + 1, q - p - 1);
+
+            // Anything between the closing quote and the next delimiter makes the line bad.
+            fieldEnd = q < end ? q + 1 : end;
+            if (fieldEnd < end && buffer[fieldEnd] != delimiter && buffer[fieldEnd] != '\n' && buffer[fieldEnd] != '\r') {
+                record->Malformed = true;
+                fieldEnd += FindFieldEnd(buffer + fieldEnd, end - fieldEnd, delimiter);
+            }
+        } else {
+            fieldEnd = p + FindFieldEnd(buffer + p, end - p, delimiter);
+            if (!AddField(record, buffer + p, fieldEnd - p, false)) return SPLIT_FAILED;
+        }
+
+        if (fieldEnd == end && !reader->Eof) return SPLIT_MORE;
+        if (fieldEnd < end && buffer[fieldEnd] == delimiter) {
+            p = fieldEnd + 1;
+            continue;
+        }
+
+        // End of line: \n, \r\n or a lone \r, or the end of the file.
+        p = fieldEnd;
+        if (p < end && buffer[p] == '\r') {
+            if (p + 1 == end && !reader->Eof) return SPLIT_MORE;
+            p++;
+            if (p < end && buffer[p] == '\n') p++;
+            record->Lines++;
+        } else if (p < end && buffer[p] == '\n') {
+            p++;
+            record->Lines++;
+        }
+        *next = p;
+        return SPLIT_RECORD;
+    }
+}
+
+// Terminates every field in place, undoubling quotes in quoted ones. Only done once the
+// record is complete, since it overwrites the delimiters.
+static void FinishFields(Record *record) {
+    for (size_t k = 0; k < record->Count; ++k) {
+        Field *field = &record->Fields[k];
+        if (field->Quoted) {
+            size_t out = 0;
+            for (size_t in = 0; in < field->Len; ++in) {
+                field->Text[out++] = field->Text[in];
+                if (field->Text[in] == '"') in++;
+            }
+            field->Len = out;
+        }
+        field->Text[field->Len] = '\0';
+    }
+}
+
+bool ParseIntField(const char *text, int *value) {
+    const char *p = text;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+') p++;
+    if (*p == '\0') return false;
+
+    long long result = 0;
+    for (; *p; ++p) {
+        if (*p < '0' || *p > '9') return false;
+        result = result * 10 + (*p - '0');
+        if (result > (long long)INT_MAX + 1) return false;
+    }
+    if (negative) result = -result;
+    if (result > INT_MAX || result < INT_MIN) return false;
+    *value = (int)result;
+    return true;
+}
+
+bool ParseUintField(const char *text, unsigned int *value) {
+    const char *p = text;
+    if (*p == '+') p++;
+    if (*p == '\0') return false;
+
+    unsigned long long result = 0;
+    for (; *p; ++p) {
+        if (*p < '0' || *p > '9') return false;
+        result = result * 10 + (unsigned)(*p - '0');
+        if (result > UINT_MAX) return false;
+    }
+    *value = (unsigned int)result;
+    return true;
+}
+
+bool ParseFloatField(const char *text, float *value) {
+    // strtof skips leading whitespace and accepts nan/inf, neither of which is a valid cell
+    const char *p = text;
+    if (*p == '-' || *p == '+') p++;
+    if ((*p < '0' || *p > '9') && *p != '.') return false;
+
+    char *end;
+    *value = strtof(text, &end);
+    return *end == '\0' && isfinite(*value);
+}
+
+typedef struct {
+    Table *Table;
+    size_t *ColumnOf;       // column each field goes to
+    void **Batch;           // per column: converted numbers, or string fields in the chunk buffer
+    size_t BatchRows;
+    size_t Line;            // line the current record starts on
+    size_t Imported;
+    size_t BadLines;
+} ImportState;
+
+static void **AllocBatch(const Table *table) {
+    void **batch = calloc(table->AttributeCount ? table->AttributeCount : 1, sizeof(void *));
+    if (!batch) return NULL;
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        size_t width = table->Attributes[j].AttributeType == DT_STRING ? sizeof(char *) : sizeof(uint32_t);
+        batch[j] = malloc(width * IMPORT_BATCH_ROWS);
+        if (!batch[j]) return batch;
+    }
+    return batch;
+}
+
+static void FreeImportBatch(const Table *table, void **batch) {
+    if (!batch) return;
+    for (size_t j = 0; j < table->AttributeCount; ++j) free(batch[j]);
+    free(batch);
+}
+
+// Stores the gathered lines; call it before the chunk buffer the strings point into changes.
+static bool FlushBatch(ImportState *state) {
+    if (state->BatchRows == 0) return true;
+
+    RowBatch batch = {state->Batch, false};
+    bool ok = InsertRows(state->Table, &batch, state->BatchRows);
+    if (ok) state->Imported += state->BatchRows;
+    state->BatchRows = 0;
+    return ok;
+}
+
+static void ReportBadLine(ImportState *state, const char *reason) {
+    if (state->BadLines++ < IMPORT_BAD_LINES_SHOWN) printf("Line %zu: %s, line skipped.\n", state->Line, reason);
+}
+
+// Checks a complete record against the schema and adds it to the batch. Returns false only
+// when the table cannot take the rows at all.
+static bool ImportRecord(ImportState *state, Record *record) {
+    Table *table = state->Table;
+    char reason[160];
+    if (record->Malformed) {
+        ReportBadLine(state, "text after a closing quote or a quote that never closes");
+        return true;
+    }
+    if (record->Count != table->AttributeCount) {
+        snprintf(reason, sizeof(reason), "%zu fields, expected %zu", record->Count, table->AttributeCount);
+        ReportBadLine(state, reason);
+        return true;
+    }
+
+    // Numbers are parsed straight into the batch; a bad line leaves its slot to the next one
+    size_t row = state->BatchRows;
+    for (size_t k = 0; k < record->Count; ++k) {
+        size_t col = state->ColumnOf[k];
+        char *text = record->Fields[k].Text;
+        bool ok = true;
+        switch (table->Attributes[col].AttributeType) {
+            case DT_INT: ok = ParseIntField(text, &((int *)state->Batch[col])[row]); break;
+            case DT_UINT: ok = ParseUintField(text, &((unsigned int *)state->Batch[col])[row]); break;
+            case DT_FLOAT: ok = ParseFloatField(text, &((float *)state->Batch[col])[row]); break;
+            case DT_STRING: ((char **)state->Batch[col])[row] = text; break;
+        }
+        if (!ok) {
+            snprintf(reason, sizeof(reason), "'%.40s' is not a valid %s for column '%s'", text,
+                     table->Attributes[col].AttributeType == DT_FLOAT ? "FLOAT" :
+                     table->Attributes[col].AttributeType == DT_UINT ? "UINT" : "INT",
+                     table->Attributes[col].AttributeName);
+            ReportBadLine(state, reason);
+            return true;
+        }
+    }
+
+    if (++state->BatchRows == IMPORT_BATCH_ROWS) return FlushBatch(state);
+    return true;
+}
+
+// A first line naming every column once is a header and sets the field order.
+static bool ReadHeader(ImportState *state, const Record *record) {
+    const Table *table = state->Table;
+    if (record->Count != table->AttributeCount) return false;
+
+    bool header = true;
+    for (size_t k = 0; header && k < record->Count; ++k) {
+        int col = FindColumn(table, record->Fields[k].Text);
+        header = col >= 0;
+        for (size_t seen = 0; header && seen < k; ++seen) header = state->ColumnOf[seen] != (size_t)col;
+        if (header) state->ColumnOf[k] = (size_t)col;
+    }
+    if (!header) {
+        for (size_t k = 0; k < table->AttributeCount; ++k) state->ColumnOf[k] = k;
+    }
+    return header;
+}
+
+// TSV if the path says so or the first line has more tabs than commas, CSV otherwise.
+static char DetectDelimiter(const char *path, const char *text, size_t len) {
+    size_t pathLen = strlen(path);
+    if (pathLen > 4 && (strcmp(path + pathLen - 4, ".tsv") == 0 || strcmp(path + pathLen - 4, ".tab") == 0)) return '\t';
+
+    size_t tabs = 0, commas = 0;
+    for (size_t i = 0; i < len && text[i] != '\n'; ++i) {
+        tabs += text[i] == '\t';
+        commas += text[i] == ',';
+    }
+    return tabs > commas ? '\t' : ',';
+}
+
+// Rows the file probably holds, judged by the line length in its first chunk.
+static size_t EstimateRows(FILE *file, const char *text, size_t len) {
+    size_t lines = CountLineBreaks(text, len);
+    if (lines == 0 || FILE_SEEK(file, 0, SEEK_END) != 0) return 0;
+    int64_t size = FILE_TELL(file);
+    FILE_SEEK(file, len, SEEK_SET);
+    return size > 0 ? (size_t)((double)size / (double)len * (double)lines) : 0;
+}
+
+// Appends every line of a CSV or TSV file to the table and reports the rows per second.
+// Lines that do not fit the schema are reported and skipped; the load carries on.
+bool ImportTable(Table *table, const char *path) {
+    if (!table || !path) return false;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror("Failed to open import file");
+        return false;
+    }
+
+    double start = NowSeconds();
+    ChunkReader reader = {file, malloc(IMPORT_CHUNK_BYTES + 1), IMPORT_CHUNK_BYTES + 1, 0, 0, false};
+    ImportState state = {table, malloc(sizeof(size_t) * (table->AttributeCount ? table->AttributeCount : 1)),
+                         AllocBatch(table), 0, 1, 0, 0};
+    Record record = {0};
+    bool ok = reader.Buffer && state.ColumnOf && state.Batch && Refill(&reader);
+    for (size_t j = 0; ok && j < table->AttributeCount; ++j) ok = state.Batch[j] != NULL;
+
+    for (size_t k = 0; ok && k < table->AttributeCount; ++k) state.ColumnOf[k] = k;
+    char delimiter = ok ? DetectDelimiter(path, reader.Buffer, reader.End) : ',';
+    size_t estimate = ok ? EstimateRows(file, reader.Buffer, reader.End) : 0;
+    if (ok && estimate > 0) ReserveRows(table, table->RowCount + estimate);
+
+    bool first = true;
+    while (ok) {
+        size_t next;
+        SplitResult result = SplitRecord(&reader, delimiter, &record, &next);
+        if (result == SPLIT_MORE || (result == SPLIT_END && !reader.Eof)) {
+            ok = FlushBatch(&state) && Refill(&reader);
+            continue;
+        }
+        if (result != SPLIT_RECORD) {
+            ok = result == SPLIT_END && FlushBatch(&state);
+            break;
+        }
+
+        reader.Begin = next;
+        FinishFields(&record);
+        bool blank = record.Count == 1 && record.Fields[0].Len == 0 && !record.Fields[0].Quoted;
+        if (!blank && !(first && ReadHeader(&state, &record))) ok = ImportRecord(&state, &record);
+        first = first && blank;
+        state.Line += record.Lines;
+    }
+
+    if (ferror(file)) ok = false;
+    if (!ok) printf("Import of '%s' stopped at line %zu: out of memory or read error.\n", path, state.Line);
+    if (state.BadLines > IMPORT_BAD_LINES_SHOWN) {
+        printf("... %zu more bad lines not shown.\n", state.BadLines - IMPORT_BAD_LINES_SHOWN);
+    }
+
+    double elapsed = NowSeconds() - start;
+    printf("Imported %zu rows into '%s' in %.2f s (%.0f rows/sec), %zu bad lines skipped.\n", state.Imported,
+           table->TableName, elapsed, elapsed > 0 ? (double)state.Imported / elapsed : 0.0, state.BadLines);
+    if (state.Imported > 0) LogBulkChange(table);
+
+    fclose(file);
+    free(reader.Buffer);
+    free(state.ColumnOf);
+    FreeImportBatch(table, state.Batch);
+    free(record.Fields);
+    return ok;
+}
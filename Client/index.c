@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+    #include <direct.h>
+    #define MAKE_DIR(dir) _mkdir(dir)
+#else
+    #define MAKE_DIR(dir) mkdir(dir, 0777)
+#endif
+#include "functions.h"
+#include "database.h"
+
+// Equality lookups on columns at least this long build a hash index on first use.
+#define HASH_LAZY_MIN_ROWS 4096
+
+static void IndexPath(const char *tableName, const char *columnName, char *path, size_t size) {
+    snprintf(path, size, "data/%s.%s.idx", tableName, columnName);
+}
+
+static int CompareRowIds(const void *a, const void *b) {
+    size_t x = *(const size_t *)a, y = *(const size_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void DropTree(Table *table, size_t col) {
+    BTree *tree = table->Columns[col].Index;
+    if (!tree) return;
+
+    char *path = strdup(BTreePath(tree));
+    BTreeClose(tree);
+    if (path) remove(path);
+    free(path);
+    table->Columns[col].Index = NULL;
+}
+
+// Bulk-loads the B+tree of col from the live rows. A tree that fails part way is half written
+// (or has lost its file), so it is dropped.
+bool RebuildIndex(Table *table, size_t col) {
+    BTree *tree = table->Columns[col].Index;
+    if (!tree) return false;
+
+    BTreeEntry *entries = malloc(sizeof(BTreeEntry) * (table->RowCount ? table->RowCount : 1));
+    bool ok = entries != NULL;
+    if (ok) {
+        DataTypes type = table->Attributes[col].AttributeType;
+        size_t count = 0;
+        for (size_t i = 0; i < table->RowCount; ++i) {
+            if (IsRowDeleted(table, i)) continue;
+            entries[count].Key = EncodeIndexKey(type, GetCell(table, col, i));
+            entries[count].Row = i;
+            count++;
+        }
+        ok = BTreeBulkLoad(tree, entries, count);
+        free(entries);
+    }
+    if (!ok) {
+        printf("Index on '%s' could not be rebuilt; dropping it.\n", table->Attributes[col].AttributeName);
+        DropTree(table, col);
+    }
+    return ok;
+}
+
+bool CreateIndex(Table *table, const char *columnName) {
+    if (!table || !columnName) return false;
+
+    int col = FindColumn(table, columnName);
+    if (col == -1) {
+        printf("Column '%s' not found in table '%s'.\n", columnName, table->TableName);
+        return false;
+    }
+    if (table->Columns[col].Index) {
+        printf("Column '%s' is already indexed.\n", columnName);
+        return true;
+    }
+
+    MAKE_DIR("data");
+
+    char path[512];
+    IndexPath(table->TableName, columnName, path, sizeof(path));
+    table->Columns[col].Index = BTreeCreate(path, table->Attributes[col].AttributeType);
+    if (!table->Columns[col].Index) return false;
+
+    return RebuildIndex(table, col);
+}
+
+bool CreateHashIndex(Table *table, const char *columnName) {
+    if (!table || !columnName) return false;
+
+    int col = FindColumn(table, columnName);
+    if (col == -1) {
+        printf("Column '%s' not found in table '%s'.\n", columnName, table->TableName);
+        return false;
+    }
+    if (table->Attributes[col].AttributeType == DT_FLOAT) {
+        printf("Hash indexes support INT, UINT and STRING columns only.\n");
+        return false;
+    }
+    if (table->Columns[col].Hash) return true;
+
+    table->Columns[col].Hash = BuildHashIndex(table, col);
+    return table->Columns[col].Hash != NULL;
+}
+
+// Used after row ids shift: B+trees are bulk-loaded again and hash indexes rebuilt in memory.
+void RebuildTableIndexes(Table *table) {
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        Column *column = &table->Columns[j];
+        if (column->Index) RebuildIndex(table, j);
+        if (column->Hash) {
+            FreeHashIndex(column->Hash);
+            column->Hash = BuildHashIndex(table, j);
+        }
+    }
+}
+
+void DropIndex(Table *table, size_t col) {
+    FreeHashIndex(table->Columns[col].Hash);
+    table->Columns[col].Hash = NULL;
+    DropTree(table, col);
+}
+
+void IndexInsertRow(Table *table, size_t row) {
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        Column *column = &table->Columns[j];
+        if (column->Index) {
+            BTreeInsert(column->Index, EncodeIndexKey(table->Attributes[j].AttributeType, GetCell(table, j, row)), row);
+        }
+        if (column->Hash && !HashIndexInsert(column->Hash, table, j, row)) {
+            FreeHashIndex(column->Hash);
+            column->Hash = NULL;
+        }
+    }
+}
+
+static int CompareBatchEntries(const void *a, const void *b) {
+    const BTreeEntry *x = a, *y = b;
+    if (x->Key != y->Key) return x->Key < y->Key ? -1 : 1;
+    return x->Row < y->Row ? -1 : x->Row > y->Row;
+}
+
+// Adds B+tree entries for the appended rows [begin, end). A batch at least as large as the
+// rows before it is cheaper to bulk-load from scratch; a smaller one goes in key order so
+// consecutive inserts land on the same leaves.
+static bool TreeInsertRows(Table *table, size_t col, size_t begin, size_t end) {
+    if (end - begin >= begin) return RebuildIndex(table, col);
+
+    BTreeEntry *entries = malloc(sizeof(BTreeEntry) * (end - begin));
+    if (!entries) return false;
+
+    DataTypes type = table->Attributes[col].AttributeType;
+    for (size_t i = begin; i < end; ++i) {
+        entries[i - begin].Key = EncodeIndexKey(type, GetCell(table, col, i));
+        entries[i - begin].Row = i;
+    }
+    qsort(entries, end - begin, sizeof(BTreeEntry), CompareBatchEntries);
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < end - begin; ++i) ok = BTreeInsert(table->Columns[col].Index, entries[i].Key, entries[i].Row);
+    free(entries);
+    return ok;
+}
+
+void IndexInsertRows(Table *table, size_t begin, size_t end) {
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        Column *column = &table->Columns[j];
+        // A batch that was bulk-loaded drops the tree itself when it fails.
+        if (column->Index && !TreeInsertRows(table, j, begin, end) && column->Index) {
+            printf("Index on '%s' could not take the new rows; rebuilding it.\n", table->Attributes[j].AttributeName);
+            RebuildIndex(table, j);
+        }
+        if (column->Hash && !HashIndexInsertRows(column->Hash, table, j, begin, end)) {
+            FreeHashIndex(column->Hash);
+            column->Hash = NULL;
+        }
+    }
+}
+
+// Call before a cell changes, then IndexAddCell once it holds the new value.
+void IndexRemoveCell(Table *table, size_t col, size_t row) {
+    Column *column = &table->Columns[col];
+    if (column->Index) {
+        BTreeDelete(column->Index, EncodeIndexKey(table->Attributes[col].AttributeType, GetCell(table, col, row)), row);
+    }
+    if (column->Hash) HashIndexRemove(column->Hash, table, col, row);
+}
+
+void IndexAddCell(Table *table, size_t col, size_t row) {
+    Column *column = &table->Columns[col];
+    if (column->Index) {
+        BTreeInsert(column->Index, EncodeIndexKey(table->Attributes[col].AttributeType, GetCell(table, col, row)), row);
+    }
+    if (column->Hash && !HashIndexInsert(column->Hash, table, col, row)) {
+        FreeHashIndex(column->Hash);
+        column->Hash = NULL;
+    }
+}
+
+// Whether IndexLookup would answer `col op literal` from an index rather than give up.
+bool IndexCanAnswer(const Table *table, size_t col, CompareOperator op) {
+    const Column *column = &table->Columns[col];
+    DataTypes type = table->Attributes[col].AttributeType;
+
+    if (op == OP_EQ && type != DT_FLOAT && (column->Hash || table->RowCount >= HASH_LAZY_MIN_ROWS)) return true;
+    return column->Index && op != OP_NEQ && op != OP_UNKNOWN;
+}
+
+// Returns the rows matching `col op literal` in ascending order, or (size_t)-1 when no index
+// can answer it or the lookup runs out of memory, so that the caller scans instead. Equality
+// goes through the hash index, building one for large INT/UINT/STRING columns on first use;
+// ranges go through the B+tree.
+size_t IndexLookup(Table *table, size_t col, CompareOperator op, const char *literal, size_t **rows) {
+    *rows = NULL;
+    Column *column = &table->Columns[col];
+    DataTypes type = table->Attributes[col].AttributeType;
+
+    if (op == OP_EQ && type != DT_FLOAT) {
+        if (!column->Hash && table->RowCount >= HASH_LAZY_MIN_ROWS) {
+            column->Hash = BuildHashIndex(table, col);
+        }
+        if (column->Hash) {
+            size_t count = HashIndexLookup(column->Hash, table, col, literal, rows);
+            if (count != (size_t)-1 && count > 1) qsort(*rows, count, sizeof(size_t), CompareRowIds);
+            return count;
+        }
+    }
+
+    BTree *tree = column->Index;
+    if (!tree || op == OP_NEQ || op == OP_UNKNOWN) return (size_t)-1;
+
+    int intVal;
+    unsigned int uintVal;
+    float floatVal;
+    const void *value = literal;
+    switch (type) {
+        case DT_INT:
+            intVal = atoi(literal);
+            value = &intVal;
+            break;
+        case DT_UINT:
+            uintVal = (unsigned int)strtoul(literal, NULL, 10);
+            value = &uintVal;
+            break;
+        case DT_FLOAT:
+            floatVal = strtof(literal, NULL);
+            if (isnan(floatVal)) return (size_t)-1;
+            value = &floatVal;
+            break;
+        case DT_STRING:
+            break;
+    }
+
+    // INT and UINT keys are exact, so strict bounds can step past the literal. Float keys
+    // (NaN) and string keys (8-byte prefix) only narrow the search and are re-checked below.
+    bool exact = type == DT_INT || type == DT_UINT;
+    uint64_t key = EncodeIndexKey(type, value);
+    uint64_t low = 0, high = UINT64_MAX;
+    switch (op) {
+        case OP_EQ: low = high = key; break;
+        case OP_GT:
+            if (exact && key == UINT64_MAX) return 0;
+            low = exact ? key + 1 : key;
+            break;
+        case OP_GTE: low = key; break;
+        case OP_LT:
+            if (exact && key == 0) return 0;
+            high = exact ? key - 1 : key;
+            break;
+        case OP_LTE: high = key; break;
+        default: return (size_t)-1;
+    }
+
+    size_t count = BTreeSearchRange(tree, low, high, rows);
+    if (count == (size_t)-1) return count;
+
+    if (!exact) {
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (Compare(type, GetCell(table, col, (*rows)[i]), literal, op)) {
+                (*rows)[kept++] = (*rows)[i];
+            }
+        }
+        count = kept;
+    }
+
+    if (count > 1) qsort(*rows, count, sizeof(size_t), CompareRowIds);
+    return count;
+}
+
+// Reattaches index files left next to a freshly loaded table. An index that was not synced
+// with this exact table file is rebuilt from the loaded rows.
+void OpenTableIndexes(Table *table, uint64_t tableBytes) {
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        char path[512];
+        IndexPath(table->TableName, table->Attributes[j].AttributeName, path, sizeof(path));
+
+        BTree *tree = BTreeOpen(path);
+        if (!tree) continue;
+        table->Columns[j].Index = tree;
+
+        if (!BTreeIsSynced(tree, tableBytes) || BTreeEntryCount(tree) != table->RowCount) {
+            printf("Rebuilding stale index '%s'.\n", path);
+            if (!RebuildIndex(table, j)) {
+                BTreeClose(tree);
+                table->Columns[j].Index = NULL;
+                continue;
+            }
+            BTreeMarkSynced(tree, tableBytes);
+        }
+    }
+}
+
+void SyncTableIndexes(Table *table, uint64_t tableBytes) {
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        if (table->Columns[j].Index) BTreeMarkSynced(table->Columns[j].Index, tableBytes);
+    }
+}
+
+void CloseTableIndexes(Table *table) {
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        BTreeClose(table->Columns[j].Index);
+        table->Columns[j].Index = NULL;
+        FreeHashIndex(table->Columns[j].Hash);
+        table->Columns[j].Hash = NULL;
+    }
+}
+
+bool RenameTableIndexes(Table *table, const char *oldName) {
+    bool ok = true;
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        if (!table->Columns[j].Index) continue;
+
+        char oldPath[512], newPath[512];
+        IndexPath(oldName, table->Attributes[j].AttributeName, oldPath, sizeof(oldPath));
+        IndexPath(table->TableName, table->Attributes[j].AttributeName, newPath, sizeof(newPath));
+
+        BTreeClose(table->Columns[j].Index);
+        remove(newPath);
+        if (rename(oldPath, newPath) != 0) {
+            ok = false;
+            table->Columns[j].Index = BTreeOpen(oldPath);
+            continue;
+        }
+        table->Columns[j].Index = BTreeOpen(newPath);
+    }
+    return ok;
+}
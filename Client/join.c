@@ -0,0 +1,444 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "functions.h"
+#include "database.h"
+
+// Equi-join of two tables on one column each. The side with fewer live rows is the build
+// side: its (hash, row) pairs are laid out bucket by bucket in one contiguous array, so a
+// probe reads a single short run. When the build side would not fit in cache, both sides
+// are first radix partitioned on the top bits of the hash and every partition gets its own
+// small table, which the probe side then visits partition by partition. Probing runs in
+// parallel over morsels of the probe side; the pairs come out in the order of the probe
+// rows within each partition, whatever the thread count.
+
+// Build rows per partition, sized so a partition's entries and buckets stay in L2.
+#define JOIN_PARTITION_ROWS     32768
+#define JOIN_MAX_PARTITION_BITS 10
+// Rows gathered per InsertRows call when materializing.
+#define JOIN_BATCH_ROWS         65536
+
+typedef struct {
+    uint64_t Hash;
+    size_t Row;
+} KeyedRow;
+
+typedef struct {
+    const Table *Table;
+    size_t Column;
+    KeyedRow *Rows;
+    size_t Count;
+} JoinSide;
+
+typedef struct {
+    JoinPair *Pairs;
+    size_t Count;
+    size_t Capacity;
+    bool Failed;
+} WorkerPairs;
+
+typedef struct {
+    size_t Worker;
+    size_t Offset;
+    size_t Count;
+} MorselPairs;
+
+typedef struct {
+    JoinSide Build;
+    JoinSide Probe;
+    bool BuildIsLeft;
+
+    unsigned PartitionBits;
+    size_t *PartitionStart;     // per partition, first build entry; PartitionCount + 1 entries
+    size_t *BucketBase;         // per partition, its first slot in BucketStart
+    size_t *BucketMask;         // per partition, bucket count - 1
+    size_t *BucketStart;        // per bucket, first entry in Build.Rows, then an end marker
+    KeyedRow *Scratch;
+
+    WorkerPairs *Workers;
+    MorselPairs *Morsels;
+} JoinJob;
+
+static uint64_t MixBits(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static uint64_t HashText(const char *str) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char *)str; *p; ++p) {
+        h ^= *p;
+        h *= 0x100000001b3ULL;
+    }
+    return MixBits(h);
+}
+
+// Hashes the key of every live row. Equal keys hash equally across tables: strings by text
+// (interned ones once per distinct value), floats with -0.0 folded into 0.0. NaN never
+// equals anything, so those rows are left out.
+static bool CollectKeys(JoinSide *side) {
+    const Table *table = side->Table;
+    const Column *column = &table->Columns[side->Column];
+    DataTypes type = table->Attributes[side->Column].AttributeType;
+
+    side->Rows = malloc(sizeof(KeyedRow) * (table->RowCount ? table->RowCount : 1));
+    uint64_t *codeHashes = NULL;
+    if (column->Dict) codeHashes = malloc(sizeof(uint64_t) * (column->Dict->Count ? column->Dict->Count : 1));
+    if (!side->Rows || (column->Dict && !codeHashes)) {
+        free(codeHashes);
+        return false;
+    }
+    for (size_t c = 0; codeHashes && c < column->Dict->Count; ++c) {
+        codeHashes[c] = HashText(DictionaryString(table, side->Column, (uint32_t)c));
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < table->RowCount; ++i) {
+        if (IsRowDeleted(table, i)) continue;
+
+        uint64_t hash;
+        if (codeHashes) {
+            hash = codeHashes[((const uint32_t *)column->Values)[i]];
+        } else if (type == DT_STRING) {
+            hash = HashText(ArenaString(&table->Strings, ((const StringRef *)column->Values)[i]));
+        } else if (type == DT_FLOAT) {
+            float value = ((const float *)column->Values)[i];
+            if (value != value) continue;
+            if (value == 0.0f) value = 0.0f;
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            hash = MixBits(bits);
+        } else {
+            hash = MixBits(((const uint32_t *)column->Values)[i]);
+        }
+        side->Rows[count].Hash = hash;
+        side->Rows[count].Row = i;
+        count++;
+    }
+    side->Count = count;
+    free(codeHashes);
+    return true;
+}
+
+static bool SameKey(const JoinJob *job, size_t buildRow, size_t probeRow) {
+    const Table *build = job->Build.Table, *probe = job->Probe.Table;
+    size_t buildCol = job->Build.Column, probeCol = job->Probe.Column;
+
+    switch (build->Attributes[buildCol].AttributeType) {
+        case DT_STRING: return strcmp(GetCell(build, buildCol, buildRow), GetCell(probe, probeCol, probeRow)) == 0;
+        case DT_FLOAT: return *(const float *)GetCell(build, buildCol, buildRow) == *(const float *)GetCell(probe, probeCol, probeRow);
+        default:
+            return ((const uint32_t *)build->Columns[buildCol].Values)[buildRow] ==
+                   ((const uint32_t *)probe->Columns[probeCol].Values)[probeRow];
+    }
+}
+
+static size_t PartitionOf(const JoinJob *job, uint64_t hash) {
+    return job->PartitionBits ? (size_t)(hash >> (64 - job->PartitionBits)) : 0;
+}
+
+// Stable scatter of a side's rows into partition order; start receives the first index of
+// every partition plus an end marker.
+static bool PartitionSide(const JoinJob *job, JoinSide *side, size_t *start) {
+    size_t partitions = (size_t)1 << job->PartitionBits;
+    memset(start, 0, sizeof(size_t) * (partitions + 1));
+    if (job->PartitionBits == 0) {
+        start[1] = side->Count;
+        return true;
+    }
+
+    KeyedRow *scattered = malloc(sizeof(KeyedRow) * (side->Count ? side->Count : 1));
+    if (!scattered) return false;
+
+    for (size_t i = 0; i < side->Count; ++i) start[PartitionOf(job, side->Rows[i].Hash) + 1]++;
+    for (size_t p = 0; p < partitions; ++p) start[p + 1] += start[p];
+
+    size_t *next = malloc(sizeof(size_t) * partitions);
+    if (!next) {
+        free(scattered);
+        return false;
+    }
+    memcpy(next, start, sizeof(size_t) * partitions);
+    for (size_t i = 0; i < side->Count; ++i) scattered[next[PartitionOf(job, side->Rows[i].Hash)]++] = side->Rows[i];
+    free(next);
+
+    free(side->Rows);
+    side->Rows = scattered;
+    return true;
+}
+
+// Orders one partition's build entries by bucket (a counting sort on the low hash bits) and
+// records where each bucket starts.
+static void BuildPartition(void *context, size_t worker, size_t partition) {
+    (void)worker;
+    JoinJob *job = context;
+    size_t begin = job->PartitionStart[partition], end = job->PartitionStart[partition + 1];
+    size_t mask = job->BucketMask[partition];
+    size_t *bucketStart = job->BucketStart + job->BucketBase[partition];
+
+    memset(bucketStart, 0, sizeof(size_t) * (mask + 2));
+    for (size_t i = begin; i < end; ++i) bucketStart[(job->Build.Rows[i].Hash & mask) + 1]++;
+    bucketStart[0] = begin;
+    for (size_t b = 0; b <= mask; ++b) bucketStart[b + 1] += bucketStart[b];
+
+    for (size_t i = begin; i < end; ++i) {
+        const KeyedRow *row = &job->Build.Rows[i];
+        job->Scratch[bucketStart[row->Hash & mask]++] = *row;
+    }
+    // The scatter advanced every start to the next bucket's; shift them back
+    for (size_t b = mask + 1; b > 0; --b) bucketStart[b] = bucketStart[b - 1];
+    bucketStart[0] = begin;
+    memcpy(job->Build.Rows + begin, job->Scratch + begin, sizeof(KeyedRow) * (end - begin));
+}
+
+static bool AppendPair(WorkerPairs *out, size_t left, size_t right) {
+    if (out->Count == out->Capacity) {
+        size_t capacity = out->Capacity ? out->Capacity * 2 : MORSEL_ROWS;
+        JoinPair *grown = realloc(out->Pairs, sizeof(JoinPair) * capacity);
+        if (!grown) return false;
+        out->Pairs = grown;
+        out->Capacity = capacity;
+    }
+    out->Pairs[out->Count].Left = left;
+    out->Pairs[out->Count].Right = right;
+    out->Count++;
+    return true;
+}
+
+static void ProbeMorsel(void *context, size_t worker, size_t morsel) {
+    JoinJob *job = context;
+    WorkerPairs *out = &job->Workers[worker];
+    size_t begin = morsel * MORSEL_ROWS;
+    size_t end = begin + MORSEL_ROWS < job->Probe.Count ? begin + MORSEL_ROWS : job->Probe.Count;
+
+    job->Morsels[morsel].Worker = worker;
+    job->Morsels[morsel].Offset = out->Count;
+    for (size_t i = begin; i < end && !out->Failed; ++i) {
+        const KeyedRow *probe = &job->Probe.Rows[i];
+        size_t partition = PartitionOf(job, probe->Hash);
+        const size_t *bucketStart = job->BucketStart + job->BucketBase[partition];
+        size_t bucket = probe->Hash & job->BucketMask[partition];
+
+        for (size_t e = bucketStart[bucket]; e < bucketStart[bucket + 1]; ++e) {
+            const KeyedRow *build = &job->Build.Rows[e];
+            if (build->Hash != probe->Hash || !SameKey(job, build->Row, probe->Row)) continue;
+
+            bool ok = job->BuildIsLeft ? AppendPair(out, build->Row, probe->Row) : AppendPair(out, probe->Row, build->Row);
+            if (!ok) {
+                out->Failed = true;
+                break;
+            }
+        }
+    }
+    job->Morsels[morsel].Count = out->Count - job->Morsels[morsel].Offset;
+}
+
+static bool PrepareBuild(JoinJob *job) {
+    size_t partitions = (size_t)1 << job->PartitionBits;
+    size_t *probeStart = malloc(sizeof(size_t) * (partitions + 1));
+    job->PartitionStart = malloc(sizeof(size_t) * (partitions + 1));
+    job->BucketBase = malloc(sizeof(size_t) * partitions);
+    job->BucketMask = malloc(sizeof(size_t) * partitions);
+    bool ok = probeStart && job->PartitionStart && job->BucketBase && job->BucketMask &&
+              PartitionSide(job, &job->Build, job->PartitionStart) && PartitionSide(job, &job->Probe, probeStart);
+    free(probeStart);
+    if (!ok) return false;
+
+    // A power-of-two bucket count at least the partition's row count
+    size_t slots = 0;
+    for (size_t p = 0; p < partitions; ++p) {
+        size_t rows = job->PartitionStart[p + 1] - job->PartitionStart[p], buckets = 1;
+        while (buckets < rows) buckets *= 2;
+        job->BucketMask[p] = buckets - 1;
+        job->BucketBase[p] = slots;
+        slots += buckets + 1;
+    }
+    job->BucketStart = malloc(sizeof(size_t) * slots);
+    job->Scratch = malloc(sizeof(KeyedRow) * (job->Build.Count ? job->Build.Count : 1));
+    if (!job->BucketStart || !job->Scratch) return false;
+
+    if (job->Build.Count >= PARALLEL_MIN_ROWS && partitions > 1) {
+        ParallelFor(partitions, BuildPartition, job);
+    } else {
+        for (size_t p = 0; p < partitions; ++p) BuildPartition(job, 0, p);
+    }
+    free(job->Scratch);
+    job->Scratch = NULL;
+    return true;
+}
+
+static bool CheckJoinColumns(const Table *left, size_t leftCol, const Table *right, size_t rightCol) {
+    DataTypes leftType = left->Attributes[leftCol].AttributeType, rightType = right->Attributes[rightCol].AttributeType;
+    if (leftType != rightType) {
+        printf("Join columns '%s' and '%s' have different types.\n", left->Attributes[leftCol].AttributeName,
+               right->Attributes[rightCol].AttributeName);
+        return false;
+    }
+    return true;
+}
+
+// Finds every pair of live rows with left[leftCol] = right[rightCol] and returns how many,
+// the pairs in *pairs (freed by the caller); (size_t)-1 on failure.
+size_t HashJoin(const Table *left, size_t leftCol, const Table *right, size_t rightCol, JoinPair **pairs) {
+    *pairs = NULL;
+    if (!CheckJoinColumns(left, leftCol, right, rightCol)) return (size_t)-1;
+
+    JoinJob job = {0};
+    size_t leftLive = left->RowCount - left->DeletedCount, rightLive = right->RowCount - right->DeletedCount;
+    job.BuildIsLeft = leftLive <= rightLive;
+    job.Build = (JoinSide){job.BuildIsLeft ? left : right, job.BuildIsLeft ? leftCol : rightCol, NULL, 0};
+    job.Probe = (JoinSide){job.BuildIsLeft ? right : left, job.BuildIsLeft ? rightCol : leftCol, NULL, 0};
+
+    bool ok = CollectKeys(&job.Build) && CollectKeys(&job.Probe);
+    while (ok && job.PartitionBits < JOIN_MAX_PARTITION_BITS &&
+           (job.Build.Count >> job.PartitionBits) > JOIN_PARTITION_ROWS) {
+        job.PartitionBits++;
+    }
+    ok = ok && PrepareBuild(&job);
+
+    size_t morselCount = (job.Probe.Count + MORSEL_ROWS - 1) / MORSEL_ROWS;
+    size_t threads = job.Probe.Count < PARALLEL_MIN_ROWS ? 1 : GetScanThreads();
+    if (ok) {
+        job.Workers = calloc(threads, sizeof(WorkerPairs));
+        job.Morsels = calloc(morselCount ? morselCount : 1, sizeof(MorselPairs));
+        ok = job.Workers && job.Morsels;
+    }
+    if (ok) {
+        if (threads == 1) {
+            for (size_t m = 0; m < morselCount; ++m) ProbeMorsel(&job, 0, m);
+        } else {
+            ParallelFor(morselCount, ProbeMorsel, &job);
+        }
+        for (size_t w = 0; w < threads; ++w) ok = ok && !job.Workers[w].Failed;
+    }
+
+    size_t total = 0;
+    if (ok && threads == 1) {
+        *pairs = job.Workers[0].Pairs;
+        job.Workers[0].Pairs = NULL;
+        total = job.Workers[0].Count;
+    } else if (ok) {
+        for (size_t m = 0; m < morselCount; ++m) total += job.Morsels[m].Count;
+        *pairs = malloc(sizeof(JoinPair) * (total ? total : 1));
+        ok = *pairs != NULL;
+        for (size_t m = 0, n = 0; ok && m < morselCount; ++m) {
+            const MorselPairs *result = &job.Morsels[m];
+            memcpy(*pairs + n, job.Workers[result->Worker].Pairs + result->Offset, sizeof(JoinPair) * result->Count);
+            n += result->Count;
+        }
+    }
+    if (!ok) {
+        printf("Out of memory joining '%s' and '%s'.\n", left->TableName, right->TableName);
+        free(*pairs);
+        *pairs = NULL;
+        total = (size_t)-1;
+    }
+
+    for (size_t w = 0; job.Workers && w < threads; ++w) free(job.Workers[w].Pairs);
+    free(job.Workers);
+    free(job.Morsels);
+    free(job.Build.Rows);
+    free(job.Probe.Rows);
+    free(job.PartitionStart);
+    free(job.BucketBase);
+    free(job.BucketMask);
+    free(job.BucketStart);
+    free(job.Scratch);
+    return total;
+}
+
+// Copies the joined rows into table a batch at a time: columns [0, left) from the left rows,
+// the rest from the right ones.
+static bool FillJoinedTable(Table *table, const Table *left, const Table *right, const JoinPair *pairs, size_t count) {
+    size_t columns = table->AttributeCount;
+    void **cells = calloc(columns, sizeof(void *));
+    bool ok = cells && ReserveRows(table, count);
+    for (size_t j = 0; ok && j < columns; ++j) {
+        cells[j] = malloc((table->Attributes[j].AttributeType == DT_STRING ? sizeof(char *) : sizeof(uint32_t)) * JOIN_BATCH_ROWS);
+        ok = cells[j] != NULL;
+    }
+
+    for (size_t begin = 0; ok && begin < count; begin += JOIN_BATCH_ROWS) {
+        size_t n = count - begin < JOIN_BATCH_ROWS ? count - begin : JOIN_BATCH_ROWS;
+        for (size_t j = 0; j < columns; ++j) {
+            bool fromLeft = j < left->AttributeCount;
+            const Table *source = fromLeft ? left : right;
+            size_t col = fromLeft ? j : j - left->AttributeCount;
+
+            if (source->Attributes[col].AttributeType == DT_STRING) {
+                const char **texts = cells[j];
+                for (size_t i = 0; i < n; ++i) {
+                    const JoinPair *pair = &pairs[begin + i];
+                    texts[i] = GetCell(source, col, fromLeft ? pair->Left : pair->Right);
+                }
+            } else {
+                const uint32_t *values = source->Columns[col].Values;
+                uint32_t *out = cells[j];
+                for (size_t i = 0; i < n; ++i) {
+                    const JoinPair *pair = &pairs[begin + i];
+                    out[i] = values[fromLeft ? pair->Left : pair->Right];
+                }
+            }
+        }
+        RowBatch batch = {cells, false};
+        ok = InsertRows(table, &batch, n);
+    }
+
+    for (size_t j = 0; cells && j < columns; ++j) free(cells[j]);
+    free(cells);
+    return ok;
+}
+
+// Joins left and right on leftColumn = rightColumn into a new table called name whose
+// columns are those of left then right, named "<table>.<column>". Interned columns stay
+// interned. Returns NULL if the columns do not exist or do not match.
+Table *JoinTables(const Table *left, const char *leftColumn, const Table *right, const char *rightColumn, const char *name) {
+    if (!left || !right || !leftColumn || !rightColumn || !name) return NULL;
+
+    int leftCol = FindColumn(left, leftColumn), rightCol = FindColumn(right, rightColumn);
+    if (leftCol == -1 || rightCol == -1) {
+        printf("Column '%s' not found in table '%s'.\n", leftCol == -1 ? leftColumn : rightColumn,
+               leftCol == -1 ? left->TableName : right->TableName);
+        return NULL;
+    }
+
+    JoinPair *pairs;
+    size_t count = HashJoin(left, (size_t)leftCol, right, (size_t)rightCol, &pairs);
+    if (count == (size_t)-1) return NULL;
+
+    size_t columns = left->AttributeCount + right->AttributeCount;
+    Attribute *attributes = calloc(columns ? columns : 1, sizeof(Attribute));
+    bool ok = attributes != NULL;
+    for (size_t j = 0; ok && j < columns; ++j) {
+        const Table *source = j < left->AttributeCount ? left : right;
+        const Attribute *from = &source->Attributes[j < left->AttributeCount ? j : j - left->AttributeCount];
+        size_t size = strlen(source->TableName) + strlen(from->AttributeName) + 2;
+        attributes[j].AttributeName = malloc(size);
+        attributes[j].AttributeType = from->AttributeType;
+        ok = attributes[j].AttributeName != NULL;
+        if (ok) snprintf(attributes[j].AttributeName, size, "%s.%s", source->TableName, from->AttributeName);
+    }
+
+    Table *table = ok ? CreateTable(name, attributes, columns) : NULL;
+    for (size_t j = 0; ok && table && j < columns; ++j) {
+        const Table *source = j < left->AttributeCount ? left : right;
+        if (source->Columns[j < left->AttributeCount ? j : j - left->AttributeCount].Dict) InternColumn(table, j);
+    }
+    if (table && !FillJoinedTable(table, left, right, pairs, count)) {
+        printf("Out of memory building the joined table '%s'.\n", name);
+        FreeTable(table);
+        table = NULL;
+    }
+
+    for (size_t j = 0; attributes && j < columns; ++j) free(attributes[j].AttributeName);
+    free(attributes);
+    free(pairs);
+    return table;
+}
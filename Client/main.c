@@ -6,18 +6,50 @@
 
 #define MAX_TABLES 10
 
-int main() {
+// Longest statement line the SQL command reads.
+#define MAX_SQL_LINE 65536
+
+int main(int argc, char **argv) {
     Table *tables[MAX_TABLES];
     size_t tableCount = 0;
 
+    SqlSession session;
+    InitSqlSession(&session, tables, &tableCount, MAX_TABLES);
+
+    // client.exe script.sql (or - for stdin) runs the statements and exits.
+    if (argc > 1) {
+        FILE *script = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "r");
+        if (!script) {
+            perror("Failed to open script");
+            return 1;
+        }
+        size_t failed = RunSqlScript(&session, script);
+        if (script != stdin) fclose(script);
+
+        ClearStatementCache(&session);
+        for (size_t i = 0; i < tableCount; ++i) {
+            FreeTable(tables[i]);
+        }
+        ShutdownThreadPool();
+        return failed > 0;
+    }
+
     char command[100];
+    static char sql[MAX_SQL_LINE];
 
     while (1) {
         printf(
-            "\nEnter command (CREATE, INSERT, DISPLAY, LIST, SAVE, LOAD, SELECT, DELETE, UPDATE, RENAME, DROP, EXIT): ");
-        scanf("%99s", command);
+            "\nEnter command (SQL, CREATE, INSERT, IMPORT, DISPLAY, LIST, SAVE, CHECKPOINT, LOAD, SELECT, AGGREGATE, JOIN, DELETE, UPDATE, RENAME, DROP, INDEX, HASHINDEX, STATS, BENCH, THREADS, EXIT): ");
+        if (scanf("%99s", command) != 1) break;
 
-        if (strcmp(command, "CREATE") == 0) {
+        // Prompted commands may add, drop, reload or alter tables that cached statements
+        // point at.
+        if (strcmp(command, "SQL") != 0) ClearStatementCache(&session);
+
+        if (strcmp(command, "SQL") == 0) {
+            printf("Enter statements separated by ';' (e.g. SELECT name, age FROM people WHERE age > 30 ORDER BY age LIMIT 10): ");
+            if (scanf(" %65535[^\n]", sql) == 1) RunSqlText(&session, sql);
+        } else if (strcmp(command, "CREATE") == 0) {
             if (tableCount >= MAX_TABLES) {
                 printf("Max table limit reached.\n");
                 continue;
@@ -49,15 +81,45 @@ int main() {
             if (!found) {
                 printf("Table not found.\n");
             }
+        } else if (strcmp(command, "IMPORT") == 0) {
+            char name[100], path[256];
+            printf("Enter table name to import into: ");
+            scanf("%99s", name);
+
+            int found = 0;
+            for (size_t i = 0; i < tableCount; ++i) {
+                if (strcmp(tables[i]->TableName, name) == 0) {
+                    printf("Enter CSV or TSV file path: ");
+                    scanf("%255s", path);
+                    ImportTable(tables[i], path);
+                    found = 1;
+                    break;
+                }
+            }
+            if (!found) {
+                printf("Table not found.\n");
+            }
         } else if (strcmp(command, "DISPLAY") == 0) {
-            char name[100];
-            printf("Enter table name to display: ");
+            char name[100], paging[128] = "";
+            printf("Enter table name to display (optionally followed by PAGE n SIZE k): ");
             scanf("%99s", name);
+            scanf("%127[^\n]", paging);
+
+            size_t page = 0, pageRows = 0;
+            bool paged = strspn(paging, " \t") < strlen(paging);
+            if (paged && sscanf(paging, " PAGE %zu SIZE %zu", &page, &pageRows) != 2) {
+                printf("Expected PAGE n SIZE k after the table name.\n");
+                continue;
+            }
 
             int found = 0;
             for (size_t i = 0; i < tableCount; ++i) {
                 if (strcmp(tables[i]->TableName, name) == 0) {
-                    DisplayTable(tables[i]);
+                    if (paged) {
+                        DisplayTablePage(tables[i], page, pageRows);
+                    } else {
+                        DisplayTable(tables[i]);
+                    }
                     found = 1;
                     break;
                 }
@@ -75,15 +137,38 @@ int main() {
             int found = 0;
             for (size_t i = 0; i < tableCount; ++i) {
                 if (strcmp(tables[i]->TableName, name) == 0) {
-                    SaveTableToFile(tables[i]);
+                    SaveTable(tables[i]);
                     found = 1;
 
                     char sendChoice;
                     printf("Do you want to send '%s.tbl' to the server? (y/n): ", name);
                     scanf(" %c", &sendChoice);
                     if (sendChoice == 'y' || sendChoice == 'Y') {
-                        SendFileToServer(name);
+                        // The server keeps whole table files, so logged changes are folded in first.
+                        uint64_t logBytes, baseBytes;
+                        GetTableLogSize(tables[i], &logBytes, &baseBytes);
+                        if (logBytes == 0 || SaveTableToFile(tables[i])) {
+                            SendFileToServer(name);
+                        }
+                    }
+                    break;
+                }
+            }
+            if (!found) {
+                printf("Table not found.\n");
+            }
+        } else if (strcmp(command, "CHECKPOINT") == 0) {
+            char name[100];
+            printf("Enter table name to checkpoint: ");
+            scanf("%99s", name);
+
+            int found = 0;
+            for (size_t i = 0; i < tableCount; ++i) {
+                if (strcmp(tables[i]->TableName, name) == 0) {
+                    if (SaveTableToFile(tables[i])) {
+                        printf("Logged changes merged into 'data/%s.tbl'.\n", name);
                     }
+                    found = 1;
                     break;
                 }
             }
@@ -99,6 +184,7 @@ int main() {
             char name[100];
             printf("Enter table name to load from server: ");
             scanf("%99s", name);
+            if (!ReleaseTableFile(tables, tableCount, name)) continue;
 
             Table *loadedTable = LoadTableFromServer(name);
             if (loadedTable) {
@@ -108,11 +194,14 @@ int main() {
                 printf("Failed to load table '%s' from server.\n", name);
             }
         } else if (strcmp(command, "SELECT") == 0) {
-            char tableName[100], columnName[100], opStr[3], value[100];
+            char tableName[100], columns[512], where[512], orderBy[256];
 
             printf("Enter table name: ");
             scanf("%99s", tableName);
 
+            printf("Enter columns to show (e.g. name, age or * for all): ");
+            scanf(" %511[^\n]", columns);
+
             printf("Do you want to filter results? (yes/no): ");
             char choice[10];
             scanf("%9s", choice);
@@ -122,18 +211,64 @@ int main() {
                 if (strcmp(tables[i]->TableName, tableName) == 0) {
                     found = 1;
 
-                    if (strcmp(choice, "no") == 0) {
+                    bool filtered = strcmp(choice, "no") != 0;
+                    if (filtered) {
+                        printf("Enter condition (e.g. age > 30 AND (city = Paris OR NOT name = 'Ann Lee')): ");
+                        scanf(" %511[^\n]", where);
+                    }
+
+                    printf("Do you want to sort results? (yes/no): ");
+                    scanf("%9s", choice);
+                    bool sorted = strcmp(choice, "no") != 0;
+                    if (sorted) {
+                        printf("Enter ORDER BY (e.g. price DESC LIMIT 10 OFFSET 20): ");
+                        scanf(" %255[^\n]", orderBy);
+                    }
+
+                    if (!filtered && !sorted && strcmp(columns, "*") == 0) {
                         DisplayTable(tables[i]);
                     } else {
-                        printf("Enter column name: ");
-                        scanf("%99s", columnName);
-                        printf("Enter operator (=, !=, >, <, >=, <=): ");
-                        scanf("%2s", opStr);
-                        printf("Enter value to compare: ");
-                        scanf("%99s", value);
-                        SelectQuery(tables[i], columnName, opStr, value);
+                        SelectQuery(tables[i], columns, filtered ? where : NULL, sorted ? orderBy : NULL);
+                    }
+
+                    break;
+                }
+            }
+
+            if (!found) {
+                printf("Table not found.\n");
+            }
+        } else if (strcmp(command, "AGGREGATE") == 0) {
+            char tableName[100], aggregates[512], groupBy[256], where[512], choice[10];
+
+            printf("Enter table name: ");
+            scanf("%99s", tableName);
+
+            int found = 0;
+            for (size_t i = 0; i < tableCount; ++i) {
+                if (strcmp(tables[i]->TableName, tableName) == 0) {
+                    found = 1;
+
+                    printf("Enter aggregates (e.g. COUNT(*), SUM(price), AVG(qty)): ");
+                    scanf(" %511[^\n]", aggregates);
+
+                    printf("Do you want to group results? (yes/no): ");
+                    scanf("%9s", choice);
+                    bool grouped = strcmp(choice, "no") != 0;
+                    if (grouped) {
+                        printf("Enter GROUP BY columns (e.g. city, year): ");
+                        scanf(" %255[^\n]", groupBy);
+                    }
+
+                    printf("Do you want to filter results? (yes/no): ");
+                    scanf("%9s", choice);
+                    bool filtered = strcmp(choice, "no") != 0;
+                    if (filtered) {
+                        printf("Enter condition (e.g. age > 30 AND city = Paris): ");
+                        scanf(" %511[^\n]", where);
                     }
 
+                    AggregateQuery(tables[i], aggregates, grouped ? groupBy : NULL, filtered ? where : NULL);
                     break;
                 }
             }
@@ -141,8 +276,41 @@ int main() {
             if (!found) {
                 printf("Table not found.\n");
             }
+        } else if (strcmp(command, "JOIN") == 0) {
+            char condition[512], leftName[100], leftColumn[100], rightName[100], rightColumn[100], name[100];
+
+            printf("Enter join condition (e.g. orders.customer = customers.id): ");
+            scanf(" %511[^\n]", condition);
+            if (sscanf(condition, " %99[^. ] . %99[^= ] = %99[^. ] . %99s", leftName, leftColumn, rightName, rightColumn) != 4) {
+                printf("Invalid join condition: expected table.column = table.column.\n");
+                continue;
+            }
+
+            Table *left = NULL, *right = NULL;
+            for (size_t i = 0; i < tableCount; ++i) {
+                if (strcmp(tables[i]->TableName, leftName) == 0) left = tables[i];
+                if (strcmp(tables[i]->TableName, rightName) == 0) right = tables[i];
+            }
+            if (!left || !right) {
+                printf("Table '%s' not found.\n", left ? rightName : leftName);
+                continue;
+            }
+            if (tableCount >= MAX_TABLES) {
+                printf("Max table limit reached.\n");
+                continue;
+            }
+
+            printf("Enter name for the joined table: ");
+            scanf("%99s", name);
+            Table *joined = JoinTables(left, leftColumn, right, rightColumn, name);
+            if (joined) {
+                tables[tableCount++] = joined;
+                printf("Joined %zu rows into table '%s'.\n", joined->RowCount, name);
+            } else {
+                printf("Join failed.\n");
+            }
         } else if (strcmp(command, "DELETE") == 0) {
-            char tableName[100], columnName[100], opStr[3], value[100];
+            char tableName[100], where[512];
 
             printf("Enter table name: ");
             scanf("%99s", tableName);
@@ -151,14 +319,10 @@ int main() {
             for (size_t i = 0; i < tableCount; ++i) {
                 if (strcmp(tables[i]->TableName, tableName) == 0) {
                     found = 1;
-                    printf("Enter column name for deletion filter: ");
-                    scanf("%99s", columnName);
-                    printf("Enter operator (=, !=, >, <, >=, <=): ");
-                    scanf("%2s", opStr);
-                    printf("Enter value to compare: ");
-                    scanf("%99s", value);
+                    printf("Enter condition for deletion: ");
+                    scanf(" %511[^\n]", where);
 
-                    size_t deleted = DeleteRows(tables[i], columnName, opStr, value);
+                    size_t deleted = DeleteRows(tables[i], where);
                     printf("%zu rows deleted.\n", deleted);
                     break;
                 }
@@ -168,8 +332,7 @@ int main() {
                 printf("Table not found.\n");
             }
         } else if (strcmp(command, "UPDATE") == 0) {
-            char tableName[100], targetColumn[100], newValue[100];
-            char filterColumn[100], opStr[3], filterValue[100];
+            char tableName[100], targetColumn[100], newValue[100], where[512];
 
             printf("Enter table name: ");
             scanf("%99s", tableName);
@@ -183,14 +346,10 @@ int main() {
                     scanf("%99s", targetColumn);
                     printf("Enter new value: ");
                     scanf("%99s", newValue);
-                    printf("Enter filter column: ");
-                    scanf("%99s", filterColumn);
-                    printf("Enter operator (=, !=, >, <, >=, <=): ");
-                    scanf("%2s", opStr);
-                    printf("Enter filter value: ");
-                    scanf("%99s", filterValue);
-
-                    size_t updated = UpdateRows(tables[i], targetColumn, newValue, filterColumn, opStr, filterValue);
+                    printf("Enter condition for rows to update: ");
+                    scanf(" %511[^\n]", where);
+
+                    size_t updated = UpdateRows(tables[i], targetColumn, newValue, where);
                     printf("%zu rows updated.\n", updated);
                     break;
                 }
@@ -276,6 +435,7 @@ int main() {
                     free(tables[i]->TableName);
                     tables[i]->TableName = strdup(newName);
 
+                    RenameTableIndexes(tables[i], oldName);
                     SaveTableToFile(tables[i]);
                     DeleteTableFile(oldName);
 
@@ -291,7 +451,84 @@ int main() {
             char name[100];
             printf("Enter table name to delete from disk: ");
             scanf("%99s", name);
-            DeleteTableFile(name);
+            if (ReleaseTableFile(tables, tableCount, name)) DeleteTableFile(name);
+        } else if (strcmp(command, "INDEX") == 0) {
+            char tableName[100], columnName[100];
+            printf("Enter table name: ");
+            scanf("%99s", tableName);
+
+            int found = 0;
+            for (size_t i = 0; i < tableCount; ++i) {
+                if (strcmp(tables[i]->TableName, tableName) == 0) {
+                    found = 1;
+                    printf("Enter column name to index: ");
+                    scanf("%99s", columnName);
+                    if (CreateIndex(tables[i], columnName)) {
+                        printf("Index created on '%s.%s'.\n", tableName, columnName);
+                    } else {
+                        printf("Failed to create index.\n");
+                    }
+                    break;
+                }
+            }
+            if (!found) {
+                printf("Table not found.\n");
+            }
+        } else if (strcmp(command, "HASHINDEX") == 0) {
+            char tableName[100], columnName[100];
+            printf("Enter table name: ");
+            scanf("%99s", tableName);
+
+            int found = 0;
+            for (size_t i = 0; i < tableCount; ++i) {
+                if (strcmp(tables[i]->TableName, tableName) == 0) {
+                    found = 1;
+                    printf("Enter column name to hash: ");
+                    scanf("%99s", columnName);
+                    if (CreateHashIndex(tables[i], columnName)) {
+                        printf("Hash index built on '%s.%s'.\n", tableName, columnName);
+                    } else {
+                        printf("Failed to build hash index.\n");
+                    }
+                    break;
+                }
+            }
+            if (!found) {
+                printf("Table not found.\n");
+            }
+        } else if (strcmp(command, "STATS") == 0) {
+            char name[100];
+            printf("Enter table name: ");
+            scanf("%99s", name);
+
+            int found = 0;
+            for (size_t i = 0; i < tableCount; ++i) {
+                if (strcmp(tables[i]->TableName, name) == 0) {
+                    PrintTableStats(tables[i]);
+                    found = 1;
+                    break;
+                }
+            }
+            if (!found) {
+                printf("Table not found.\n");
+            }
+        } else if (strcmp(command, "BENCH") == 0) {
+            size_t rowCount;
+            printf("Enter number of rows to benchmark: ");
+            if (scanf("%zu", &rowCount) != 1 || rowCount == 0) {
+                printf("Invalid row count.\n");
+                continue;
+            }
+            RunScanBenchmark(rowCount);
+        } else if (strcmp(command, "THREADS") == 0) {
+            size_t threads;
+            printf("Scans currently use %zu threads. Enter new thread count: ", GetScanThreads());
+            if (scanf("%zu", &threads) != 1 || threads == 0) {
+                printf("Invalid thread count.\n");
+                continue;
+            }
+            SetScanThreads(threads);
+            printf("Scans will use %zu threads.\n", GetScanThreads());
         } else if (strcmp(command, "EXIT") == 0) {
             printf("Exiting program...\n");
             break;
@@ -300,9 +537,11 @@ int main() {
         }
     }
 
+    ClearStatementCache(&session);
     for (size_t i = 0; i < tableCount; ++i) {
         FreeTable(tables[i]);
     }
+    ShutdownThreadPool();
 
     return 0;
 }
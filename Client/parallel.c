@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    typedef HANDLE ThreadHandle;
+    typedef CRITICAL_SECTION Mutex;
+    typedef CONDITION_VARIABLE CondVar;
+    #define MUTEX_INIT(m)       InitializeCriticalSection(m)
+    #define MUTEX_DESTROY(m)    DeleteCriticalSection(m)
+    #define MUTEX_LOCK(m)       EnterCriticalSection(m)
+    #define MUTEX_UNLOCK(m)     LeaveCriticalSection(m)
+    #define COND_INIT(c)        InitializeConditionVariable(c)
+    #define COND_DESTROY(c)     ((void)0)
+    #define COND_WAIT(c, m)     SleepConditionVariableCS(c, m, INFINITE)
+    #define COND_BROADCAST(c)   WakeAllConditionVariable(c)
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+    typedef pthread_t ThreadHandle;
+    typedef pthread_mutex_t Mutex;
+    typedef pthread_cond_t CondVar;
+    #define MUTEX_INIT(m)       pthread_mutex_init(m, NULL)
+    #define MUTEX_DESTROY(m)    pthread_mutex_destroy(m)
+    #define MUTEX_LOCK(m)       pthread_mutex_lock(m)
+    #define MUTEX_UNLOCK(m)     pthread_mutex_unlock(m)
+    #define COND_INIT(c)        pthread_cond_init(c, NULL)
+    #define COND_DESTROY(c)     pthread_cond_destroy(c)
+    #define COND_WAIT(c, m)     pthread_cond_wait(c, m)
+    #define COND_BROADCAST(c)   pthread_cond_broadcast(c)
+#endif
+
+#include "functions.h"
+#include "database.h"
+
+#define MAX_SCAN_THREADS 64
+
+// Each worker owns a contiguous slice of the tasks and takes them from the front; a worker
+// that runs dry takes from the front of the others' slices. Padded so workers do not share
+// cache lines.
+typedef struct {
+    atomic_size_t Next;
+    size_t End;
+    char Padding[64 - sizeof(atomic_size_t) - sizeof(size_t)];
+} TaskRange;
+
+typedef struct {
+    ParallelTask Task;
+    void *Context;
+    TaskRange *Ranges;
+    size_t Workers;
+} Job;
+
+// Workers sleep until the generation changes, run the posted job and report back; the
+// calling thread takes part as worker 0.
+typedef struct {
+    ThreadHandle Threads[MAX_SCAN_THREADS];
+    size_t ThreadCount;
+
+    Mutex Lock;
+    CondVar WorkReady;
+    CondVar WorkDone;
+    size_t Generation;
+    size_t Running;
+    bool Stopping;
+    Job *Current;
+} ThreadPool;
+
+static size_t ScanThreads = 0;
+static ThreadPool *Pool = NULL;
+
+static size_t CpuCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? (size_t)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+#endif
+}
+
+size_t GetScanThreads(void) {
+    if (ScanThreads == 0) {
+        size_t cpus = CpuCount();
+        ScanThreads = cpus > MAX_SCAN_THREADS ? MAX_SCAN_THREADS : cpus;
+    }
+    return ScanThreads;
+}
+
+void SetScanThreads(size_t threads) {
+    if (threads == 0) threads = 1;
+    if (threads > MAX_SCAN_THREADS) threads = MAX_SCAN_THREADS;
+    if (threads == GetScanThreads()) return;
+
+    // The pool is sized on first use, so it is rebuilt for the new count.
+    ShutdownThreadPool();
+    ScanThreads = threads;
+}
+
+static void RunTasks(Job *job, size_t worker) {
+    for (size_t offset = 0; offset < job->Workers; ++offset) {
+        TaskRange *range = &job->Ranges[(worker + offset) % job->Workers];
+        for (;;) {
+            size_t index = atomic_fetch_add(&range->Next, 1);
+            if (index >= range->End) break;
+            job->Task(job->Context, worker, index);
+        }
+    }
+}
+
+typedef struct {
+    ThreadPool *Pool;
+    size_t Worker;
+} WorkerStart;
+
+static WorkerStart WorkerStarts[MAX_SCAN_THREADS];
+
+#ifdef _WIN32
+static DWORD WINAPI WorkerMain(LPVOID arg) {
+#else
+static void *WorkerMain(void *arg) {
+#endif
+    WorkerStart *start = arg;
+    ThreadPool *pool = start->Pool;
+    size_t seen = 0;
+
+    MUTEX_LOCK(&pool->Lock);
+    for (;;) {
+        while (!pool->Stopping && pool->Generation == seen) COND_WAIT(&pool->WorkReady, &pool->Lock);
+        if (pool->Stopping) break;
+        seen = pool->Generation;
+
+        Job *job = pool->Current;
+        MUTEX_UNLOCK(&pool->Lock);
+        if (start->Worker < job->Workers) RunTasks(job, start->Worker);
+        MUTEX_LOCK(&pool->Lock);
+
+        if (--pool->Running == 0) COND_BROADCAST(&pool->WorkDone);
+    }
+    MUTEX_UNLOCK(&pool->Lock);
+    return 0;
+}
+
+static ThreadPool *StartThreadPool(size_t threads) {
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+
+    MUTEX_INIT(&pool->Lock);
+    COND_INIT(&pool->WorkReady);
+    COND_INIT(&pool->WorkDone);
+
+    // Worker 0 is the caller, so the pool only starts the others.
+    for (size_t i = 1; i < threads; ++i) {
+        WorkerStarts[i].Pool = pool;
+        WorkerStarts[i].Worker = i;
+#ifdef _WIN32
+        pool->Threads[pool->ThreadCount] = CreateThread(NULL, 0, WorkerMain, &WorkerStarts[i], 0, NULL);
+        if (!pool->Threads[pool->ThreadCount]) break;
+#else
+        if (pthread_create(&pool->Threads[pool->ThreadCount], NULL, WorkerMain, &WorkerStarts[i]) != 0) break;
+#endif
+        pool->ThreadCount++;
+    }
+    return pool;
+}
+
+void ShutdownThreadPool(void) {
+    if (!Pool) return;
+
+    MUTEX_LOCK(&Pool->Lock);
+    Pool->Stopping = true;
+    COND_BROADCAST(&Pool->WorkReady);
+    MUTEX_UNLOCK(&Pool->Lock);
+
+    for (size_t i = 0; i < Pool->ThreadCount; ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(Pool->Threads[i], INFINITE);
+        CloseHandle(Pool->Threads[i]);
+#else
+        pthread_join(Pool->Threads[i], NULL);
+#endif
+    }
+
+    MUTEX_DESTROY(&Pool->Lock);
+    COND_DESTROY(&Pool->WorkReady);
+    COND_DESTROY(&Pool->WorkDone);
+    free(Pool);
+    Pool = NULL;
+}
+
+// Runs task(context, worker, i) for every i in [0, taskCount) across the scan threads and
+// returns once all have finished. worker is below GetScanThreads() and no two tasks run on
+// the same worker at once, so per-worker state needs no locking.
+void ParallelFor(size_t taskCount, ParallelTask task, void *context) {
+    size_t threads = GetScanThreads();
+    if (threads > 1 && !Pool) Pool = StartThreadPool(threads);
+
+    size_t workers = Pool ? Pool->ThreadCount + 1 : 1;
+    if (workers > taskCount) workers = taskCount;
+    if (workers <= 1) {
+        for (size_t i = 0; i < taskCount; ++i) task(context, 0, i);
+        return;
+    }
+
+    TaskRange *ranges = calloc(workers, sizeof(TaskRange));
+    if (!ranges) {
+        for (size_t i = 0; i < taskCount; ++i) task(context, 0, i);
+        return;
+    }
+    for (size_t w = 0; w < workers; ++w) {
+        atomic_init(&ranges[w].Next, taskCount * w / workers);
+        ranges[w].End = taskCount * (w + 1) / workers;
+    }
+
+    Job job = {task, context, ranges, workers};
+    MUTEX_LOCK(&Pool->Lock);
+    Pool->Current = &job;
+    Pool->Running = Pool->ThreadCount;
+    Pool->Generation++;
+    COND_BROADCAST(&Pool->WorkReady);
+    MUTEX_UNLOCK(&Pool->Lock);
+
+    RunTasks(&job, 0);
+
+    MUTEX_LOCK(&Pool->Lock);
+    while (Pool->Running > 0) COND_WAIT(&Pool->WorkDone, &Pool->Lock);
+    MUTEX_UNLOCK(&Pool->Lock);
+    free(ranges);
+}
+
+// Per-worker result buffer; each morsel's matches are appended to the buffer of the worker
+// that ran it and located again through the morsel's slot when merging.
+typedef struct {
+    size_t *Rows;
+    size_t Count;
+    size_t Capacity;
+} WorkerRows;
+
+typedef struct {
+    size_t Worker;
+    size_t Offset;
+    size_t Count;
+} MorselResult;
+
+typedef struct {
+    size_t ItemCount;
+    MorselScan Scan;
+    void *Context;
+    WorkerRows *Workers;
+    MorselResult *Morsels;
+    atomic_bool Failed;         // a morsel ran out of memory; the rest are skipped
+} ScanJob;
+
+static void ScanMorsel(void *context, size_t worker, size_t morsel) {
+    ScanJob *job = context;
+    WorkerRows *out = &job->Workers[worker];
+    size_t begin = morsel * MORSEL_ROWS;
+    size_t end = begin + MORSEL_ROWS < job->ItemCount ? begin + MORSEL_ROWS : job->ItemCount;
+    if (atomic_load(&job->Failed)) return;
+
+    if (out->Capacity - out->Count < end - begin) {
+        size_t capacity = out->Capacity ? out->Capacity : MORSEL_ROWS;
+        while (capacity - out->Count < end - begin) capacity *= 2;
+        size_t *grown = realloc(out->Rows, sizeof(size_t) * capacity);
+        if (!grown) {
+            atomic_store(&job->Failed, true);
+            return;
+        }
+        out->Rows = grown;
+        out->Capacity = capacity;
+    }
+
+    size_t count = job->Scan(job->Context, worker, begin, end, out->Rows + out->Count);
+    if (count == (size_t)-1) {
+        atomic_store(&job->Failed, true);
+        return;
+    }
+    job->Morsels[morsel].Worker = worker;
+    job->Morsels[morsel].Offset = out->Count;
+    job->Morsels[morsel].Count = count;
+    out->Count += count;
+}
+
+// Runs scan over [0, itemCount) in morsels of at most MORSEL_ROWS items and returns the ids
+// it produced in morsel order, so ascending scans stay ascending. Inputs below
+// PARALLEL_MIN_ROWS are scanned on the calling thread. Returns (size_t)-1 if scan or a buffer
+// runs out of memory anywhere, since a partial set would pass for every match.
+size_t ParallelScan(size_t itemCount, MorselScan scan, void *context, size_t **rows) {
+    *rows = NULL;
+    if (itemCount == 0) return 0;
+
+    size_t morselCount = (itemCount + MORSEL_ROWS - 1) / MORSEL_ROWS;
+    size_t threads = itemCount < PARALLEL_MIN_ROWS ? 1 : GetScanThreads();
+
+    ScanJob job = {itemCount, scan, context, NULL, NULL, false};
+    job.Workers = calloc(threads, sizeof(WorkerRows));
+    job.Morsels = calloc(morselCount, sizeof(MorselResult));
+    if (!job.Workers || !job.Morsels) {
+        free(job.Workers);
+        free(job.Morsels);
+        printf("Out of memory scanning rows.\n");
+        return (size_t)-1;
+    }
+
+    if (threads == 1) {
+        for (size_t m = 0; m < morselCount && !atomic_load(&job.Failed); ++m) ScanMorsel(&job, 0, m);
+    } else {
+        ParallelFor(morselCount, ScanMorsel, &job);
+    }
+
+    // A single worker's buffer is already in order and is handed over as is.
+    size_t total = 0;
+    for (size_t m = 0; m < morselCount; ++m) total += job.Morsels[m].Count;
+
+    if (atomic_load(&job.Failed)) {
+        total = (size_t)-1;
+    } else if (threads == 1) {
+        *rows = job.Workers[0].Rows;
+        job.Workers[0].Rows = NULL;
+    } else if (total > 0) {
+        *rows = malloc(sizeof(size_t) * total);
+        if (*rows) {
+            size_t n = 0;
+            for (size_t m = 0; m < morselCount; ++m) {
+                const MorselResult *result = &job.Morsels[m];
+                memcpy(*rows + n, job.Workers[result->Worker].Rows + result->Offset, sizeof(size_t) * result->Count);
+                n += result->Count;
+            }
+        } else {
+            total = (size_t)-1;
+        }
+    }
+    if (total == (size_t)-1) printf("Out of memory scanning rows.\n");
+
+    for (size_t w = 0; w < threads; ++w) free(job.Workers[w].Rows);
+    free(job.Workers);
+    free(job.Morsels);
+    return total;
+}
@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "functions.h"
+#include "database.h"
+
+// One kernel per (type, operator) pair. Each walks a row range of a single column and writes
+// the ids of matching rows to out without branching on the comparison; out must have room
+// for end - begin ids. The name##Refine twin tests only the rows listed in a selection
+// vector, for conditions that narrow what earlier ones matched.
+#define DEFINE_NUMERIC_KERNEL(name, ctype, field, cmp)                                          \
+    static size_t name(const Predicate *pred, const Table *table, size_t begin, size_t end,    \
+                       size_t *out) {                                                          \
+        const ctype *values = table->Columns[pred->Column].Values;                             \
+        const ctype literal = pred->Literal.field;                                             \
+        size_t n = 0;                                                                          \
+        for (size_t i = begin; i < end; ++i) {                                                 \
+            out[n] = i;                                                                        \
+            n += (values[i] cmp literal);                                                      \
+        }                                                                                      \
+        return n;                                                                              \
+    }                                                                                          \
+    static size_t name##Refine(const Predicate *pred, const Table *table, const size_t *in,    \
+                               size_t count, size_t *out) {                                    \
+        const ctype *values = table->Columns[pred->Column].Values;                             \
+        const ctype literal = pred->Literal.field;                                             \
+        size_t n = 0;                                                                          \
+        for (size_t k = 0; k < count; ++k) {                                                   \
+            out[n] = in[k];                                                                    \
+            n += (values[in[k]] cmp literal);                                                  \
+        }                                                                                      \
+        return n;                                                                              \
+    }
+
+#define DEFINE_STRING_KERNEL(name, cmp)                                                         \
+    static size_t name(const Predicate *pred, const Table *table, size_t begin, size_t end,    \
+                       size_t *out) {                                                          \
+        const StringRef *refs = table->Columns[pred->Column].Values;                           \
+        const Arena *arena = &table->Strings;                                                  \
+        const char *literal = pred->Literal.String;                                            \
+        size_t n = 0;                                                                          \
+        for (size_t i = begin; i < end; ++i) {                                                 \
+            out[n] = i;                                                                        \
+            n += (strcmp(ArenaString(arena, refs[i]), literal) cmp 0);                         \
+        }                                                                                      \
+        return n;                                                                              \
+    }                                                                                          \
+    static size_t name##Refine(const Predicate *pred, const Table *table, const size_t *in,    \
+                               size_t count, size_t *out) {                                    \
+        const StringRef *refs = table->Columns[pred->Column].Values;                           \
+        const Arena *arena = &table->Strings;                                                  \
+        const char *literal = pred->Literal.String;                                            \
+        size_t n = 0;                                                                          \
+        for (size_t k = 0; k < count; ++k) {                                                   \
+            out[n] = in[k];                                                                    \
+            n += (strcmp(ArenaString(arena, refs[in[k]]), literal) cmp 0);                     \
+        }                                                                                      \
+        return n;                                                                              \
+    }
+
+// Interned STRING columns compare codes: equality against the literal's code, orderings
+// through a table of which codes satisfy the comparison, filled once per predicate.
+#define DEFINE_CODE_KERNEL(name, test)                                                          \
+    static size_t name(const Predicate *pred, const Table *table, size_t begin, size_t end,    \
+                       size_t *out) {                                                          \
+        const uint32_t *codes = table->Columns[pred->Column].Values;                           \
+        const uint32_t literal = pred->Code;                                                   \
+        const unsigned char *matches = pred->CodeMatches;                                      \
+        size_t n = 0;                                                                          \
+        for (size_t i = begin; i < end; ++i) {                                                 \
+            const uint32_t code = codes[i];                                                    \
+            out[n] = i;                                                                        \
+            n += (test);                                                                       \
+        }                                                                                      \
+        (void)literal;                                                                         \
+        (void)matches;                                                                         \
+        return n;                                                                              \
+    }                                                                                          \
+    static size_t name##Refine(const Predicate *pred, const Table *table, const size_t *in,    \
+                               size_t count, size_t *out) {                                    \
+        const uint32_t *codes = table->Columns[pred->Column].Values;                           \
+        const uint32_t literal = pred->Code;                                                   \
+        const unsigned char *matches = pred->CodeMatches;                                      \
+        size_t n = 0;                                                                          \
+        for (size_t k = 0; k < count; ++k) {                                                   \
+            const uint32_t code = codes[in[k]];                                                \
+            out[n] = in[k];                                                                    \
+            n += (test);                                                                       \
+        }                                                                                      \
+        (void)literal;                                                                         \
+        (void)matches;                                                                         \
+        return n;                                                                              \
+    }
+
+DEFINE_NUMERIC_KERNEL(IntEq, int, Int, ==)
+DEFINE_NUMERIC_KERNEL(IntNeq, int, Int, !=)
+DEFINE_NUMERIC_KERNEL(IntGt, int, Int, >)
+DEFINE_NUMERIC_KERNEL(IntLt, int, Int, <)
+DEFINE_NUMERIC_KERNEL(IntGte, int, Int, >=)
+DEFINE_NUMERIC_KERNEL(IntLte, int, Int, <=)
+
+DEFINE_NUMERIC_KERNEL(UintEq, unsigned int, Uint, ==)
+DEFINE_NUMERIC_KERNEL(UintNeq, unsigned int, Uint, !=)
+DEFINE_NUMERIC_KERNEL(UintGt, unsigned int, Uint, >)
+DEFINE_NUMERIC_KERNEL(UintLt, unsigned int, Uint, <)
+DEFINE_NUMERIC_KERNEL(UintGte, unsigned int, Uint, >=)
+DEFINE_NUMERIC_KERNEL(UintLte, unsigned int, Uint, <=)
+
+DEFINE_NUMERIC_KERNEL(FloatEq, float, Float, ==)
+DEFINE_NUMERIC_KERNEL(FloatNeq, float, Float, !=)
+DEFINE_NUMERIC_KERNEL(FloatGt, float, Float, >)
+DEFINE_NUMERIC_KERNEL(FloatLt, float, Float, <)
+DEFINE_NUMERIC_KERNEL(FloatGte, float, Float, >=)
+DEFINE_NUMERIC_KERNEL(FloatLte, float, Float, <=)
+
+DEFINE_STRING_KERNEL(StringEq, ==)
+DEFINE_STRING_KERNEL(StringNeq, !=)
+DEFINE_STRING_KERNEL(StringGt, >)
+DEFINE_STRING_KERNEL(StringLt, <)
+DEFINE_STRING_KERNEL(StringGte, >=)
+DEFINE_STRING_KERNEL(StringLte, <=)
+
+DEFINE_CODE_KERNEL(CodeEq, code == literal)
+DEFINE_CODE_KERNEL(CodeNeq, code != literal)
+DEFINE_CODE_KERNEL(CodeMatch, matches[code])
+
+// Indexed by [DataTypes][CompareOperator].
+static const PredicateKernel Kernels[4][6] = {
+    {IntEq, IntNeq, IntGt, IntLt, IntGte, IntLte},
+    {UintEq, UintNeq, UintGt, UintLt, UintGte, UintLte},
+    {FloatEq, FloatNeq, FloatGt, FloatLt, FloatGte, FloatLte},
+    {StringEq, StringNeq, StringGt, StringLt, StringGte, StringLte},
+};
+
+static const PredicateRefineKernel RefineKernels[4][6] = {
+    {IntEqRefine, IntNeqRefine, IntGtRefine, IntLtRefine, IntGteRefine, IntLteRefine},
+    {UintEqRefine, UintNeqRefine, UintGtRefine, UintLtRefine, UintGteRefine, UintLteRefine},
+    {FloatEqRefine, FloatNeqRefine, FloatGtRefine, FloatLtRefine, FloatGteRefine, FloatLteRefine},
+    {StringEqRefine, StringNeqRefine, StringGtRefine, StringLtRefine, StringGteRefine, StringLteRefine},
+};
+
+// An absent literal gets a code no row holds, so equality matches nothing and inequality
+// everything without looking at a single string.
+static bool CompileCodePredicate(const Table *table, Predicate *pred) {
+    const ColumnDictionary *dict = table->Columns[pred->Column].Dict;
+    pred->Code = FindDictionaryCode(table, pred->Column, pred->Literal.String);
+
+    if (pred->Op == OP_EQ || pred->Op == OP_NEQ) {
+        pred->Kernel = pred->Op == OP_EQ ? CodeEq : CodeNeq;
+        pred->Refine = pred->Op == OP_EQ ? CodeEqRefine : CodeNeqRefine;
+    } else {
+        pred->CodeMatches = malloc(dict->Count ? dict->Count : 1);
+        if (!pred->CodeMatches) {
+            FreePredicate(pred);
+            return false;
+        }
+        for (size_t code = 0; code < dict->Count; ++code) {
+            const char *entry = DictionaryString(table, pred->Column, (uint32_t)code);
+            pred->CodeMatches[code] = Compare(DT_STRING, (void *)entry, pred->Literal.String, pred->Op);
+        }
+        pred->Kernel = CodeMatch;
+        pred->Refine = CodeMatchRefine;
+    }
+    ZoneMapPreparePredicate(pred);
+    return true;
+}
+
+bool CompilePredicate(const Table *table, size_t col, CompareOperator op, const char *literal, Predicate *pred) {
+    if (!table || !literal || col >= table->AttributeCount || op == OP_UNKNOWN) return false;
+
+    memset(pred, 0, sizeof(Predicate));
+    pred->Column = col;
+    pred->Type = table->Attributes[col].AttributeType;
+    pred->Op = op;
+
+    switch (pred->Type) {
+        case DT_INT:
+            pred->Literal.Int = atoi(literal);
+            break;
+        case DT_UINT:
+            pred->Literal.Uint = (unsigned int)strtoul(literal, NULL, 10);
+            break;
+        case DT_FLOAT:
+            pred->Literal.Float = strtof(literal, NULL);
+            break;
+        case DT_STRING:
+            pred->Literal.String = strdup(literal);
+            if (!pred->Literal.String) return false;
+            break;
+    }
+
+    if (table->Columns[col].Dict) return CompileCodePredicate(table, pred);
+
+    // Numeric columns use the vector kernels when the CPU has them.
+    pred->Kernel = SelectSimdKernel(pred->Type, op);
+    if (!pred->Kernel) pred->Kernel = Kernels[pred->Type][op];
+    pred->Refine = RefineKernels[pred->Type][op];
+    ZoneMapPreparePredicate(pred);
+    return true;
+}
+
+void FreePredicate(Predicate *pred) {
+    if (pred->Type == DT_STRING) free(pred->Literal.String);
+    pred->Literal.String = NULL;
+    free(pred->CodeMatches);
+    pred->CodeMatches = NULL;
+}
+
+size_t RunPredicate(const Predicate *pred, const Table *table, size_t begin, size_t end, size_t *out) {
+    return pred->Kernel(pred, table, begin, end, out);
+}
+
+size_t RefinePredicate(const Predicate *pred, const Table *table, const size_t *in, size_t count, size_t *out) {
+    return pred->Refine(pred, table, in, count, out);
+}
+
+// Removes tombstoned rows from a block's matches.
+size_t DropDeletedRows(const Table *table, size_t *rows, size_t count) {
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        rows[kept] = rows[i];
+        kept += !IsRowDeleted(table, rows[i]);
+    }
+    return kept;
+}
+
+typedef struct {
+    const Predicate *Pred;
+    const Table *Table;
+} PredicateScan;
+
+static size_t ScanPredicateMorsel(void *context, size_t worker, size_t begin, size_t end, size_t *out) {
+    (void)worker;
+    const PredicateScan *scan = context;
+    size_t count = 0;
+
+    for (size_t block = begin; block < end; block += SCAN_BLOCK_ROWS) {
+        size_t blockEnd = block + SCAN_BLOCK_ROWS < end ? block + SCAN_BLOCK_ROWS : end;
+        if (!ZonesMayMatch(scan->Pred, scan->Table, block, blockEnd)) continue;
+
+        size_t matched = RunPredicate(scan->Pred, scan->Table, block, blockEnd, out + count);
+        if (scan->Table->DeletedCount) matched = DropDeletedRows(scan->Table, out + count, matched);
+        count += matched;
+    }
+    return count;
+}
+
+// Runs the predicate over the whole table, morsels in parallel and blocks within them, and
+// returns the matching live row ids in ascending order, or (size_t)-1 if memory runs out.
+size_t ScanPredicate(const Predicate *pred, const Table *table, size_t **rows) {
+    PredicateScan scan = {pred, table};
+    return ParallelScan(table->RowCount, ScanPredicateMorsel, &scan, rows);
+}
@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "functions.h"
+#include "database.h"
+
+// Output is gathered here and written with one fwrite per buffer.
+#define RENDER_BUFFER_BYTES (64 * 1024)
+
+// Rows of the first batch looked at to size columns, and the widest a sampled cell can make
+// its column; longer cells still print in full.
+#define RENDER_SAMPLE_ROWS 256
+#define RENDER_MAX_WIDTH   40
+
+// Room for any formatted number, written backwards from the end.
+#define CELL_CHARS 48
+
+typedef struct {
+    char *Data;
+    size_t Length;
+} OutputBuffer;
+
+static const char DigitPairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static void Flush(OutputBuffer *out) {
+    fwrite(out->Data, 1, out->Length, stdout);
+    out->Length = 0;
+}
+
+static void Append(OutputBuffer *out, const char *text, size_t len) {
+    if (out->Length + len > RENDER_BUFFER_BYTES) {
+        Flush(out);
+        if (len > RENDER_BUFFER_BYTES) {
+            fwrite(text, 1, len, stdout);
+            return;
+        }
+    }
+    memcpy(out->Data + out->Length, text, len);
+    out->Length += len;
+}
+
+static void AppendRepeated(OutputBuffer *out, char c, size_t count) {
+    while (count > 0) {
+        if (out->Length == RENDER_BUFFER_BYTES) Flush(out);
+        size_t n = RENDER_BUFFER_BYTES - out->Length;
+        if (n > count) n = count;
+        memset(out->Data + out->Length, c, n);
+        out->Length += n;
+        count -= n;
+    }
+}
+
+// Writes the decimal digits of value so they end just before end; returns where they start.
+static char *FormatDigits(uint64_t value, char *end) {
+    while (value >= 100) {
+        const char *pair = &DigitPairs[(value % 100) * 2];
+        value /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+    if (value >= 10) {
+        *--end = DigitPairs[value * 2 + 1];
+        *--end = DigitPairs[value * 2];
+    } else {
+        *--end = (char)('0' + value);
+    }
+    return end;
+}
+
+// Same text as "%.2f". A float times 100 is exact in a double, so rounding the scaled value
+// half to even matches printf; values too large for that, NaN and infinities go to snprintf.
+static char *FormatFloat(float value, char *end) {
+    double scaled = fabs((double)value * 100.0);
+    if (!(scaled < 1e18)) {
+        char text[CELL_CHARS];
+        int len = snprintf(text, sizeof(text), "%.2f", value);
+        if (len < 0 || len >= CELL_CHARS) len = 0;
+        end -= len;
+        memcpy(end, text, (size_t)len);
+        return end;
+    }
+
+    double whole = floor(scaled), rest = scaled - whole;
+    uint64_t cents = (uint64_t)whole;
+    if (rest > 0.5 || (rest == 0.5 && (cents & 1))) cents++;
+
+    *--end = DigitPairs[(cents % 100) * 2 + 1];
+    *--end = DigitPairs[(cents % 100) * 2];
+    *--end = '.';
+    end = FormatDigits(cents / 100, end);
+    if (signbit(value)) *--end = '-';
+    return end;
+}
+
+// Text of a cell and its length; numbers are formatted into cell, CELL_CHARS long.
+static const char *FormatCell(const Table *table, size_t col, size_t row, char *cell, size_t *len) {
+    const Column *column = &table->Columns[col];
+    char *end = cell + CELL_CHARS, *start;
+
+    switch (table->Attributes[col].AttributeType) {
+        case DT_INT: {
+            int value = ((const int *)column->Values)[row];
+            start = FormatDigits(value < 0 ? 0 - (uint64_t)(int64_t)value : (uint64_t)value, end);
+            if (value < 0) *--start = '-';
+            break;
+        }
+        case DT_UINT:
+            start = FormatDigits(((const unsigned int *)column->Values)[row], end);
+            break;
+        case DT_FLOAT:
+            start = FormatFloat(((const float *)column->Values)[row], end);
+            break;
+        default: {
+            const char *text = GetCell(table, col, row);
+            *len = strlen(text);
+            return text;
+        }
+    }
+    *len = (size_t)(end - start);
+    return start;
+}
+
+// Widens each column to fit its name and an even sample of the first rows to be printed.
+static void SizeColumns(const ResultSet *result, const size_t *rows, size_t count, size_t *widths) {
+    const Table *table = result->Table;
+    size_t samples = count < RENDER_SAMPLE_ROWS ? count : RENDER_SAMPLE_ROWS;
+    char cell[CELL_CHARS];
+
+    for (size_t k = 0; k < result->ColumnCount; ++k) {
+        size_t col = result->Columns[k], width = 1;
+        for (size_t s = 0; s < samples; ++s) {
+            size_t len;
+            FormatCell(table, col, rows[s * count / samples], cell, &len);
+            if (len > width) width = len;
+        }
+        if (width > RENDER_MAX_WIDTH) width = RENDER_MAX_WIDTH;
+        size_t name = strlen(table->Attributes[col].AttributeName);
+        widths[k] = name > width ? name : width;
+    }
+}
+
+static void AppendPadded(OutputBuffer *out, const char *text, size_t len, size_t width) {
+    Append(out, "| ", 2);
+    Append(out, text, len);
+    AppendRepeated(out, ' ', (len < width ? width - len : 0) + 1);
+}
+
+static void AppendHeader(OutputBuffer *out, const ResultSet *result, const size_t *widths) {
+    const Table *table = result->Table;
+    for (size_t k = 0; k < result->ColumnCount; ++k) {
+        const char *name = table->Attributes[result->Columns[k]].AttributeName;
+        AppendPadded(out, name, strlen(name), widths[k]);
+    }
+    Append(out, "|\n", 2);
+
+    for (size_t k = 0; k < result->ColumnCount; ++k) {
+        Append(out, "+", 1);
+        AppendRepeated(out, '-', widths[k] + 2);
+    }
+    Append(out, "+\n", 2);
+}
+
+// Prints the result from its start as a table of its columns, a batch of rows at a time.
+// Column widths come from a sample of the first batch; cells are formatted into a buffer that
+// is written out as it fills. Returns the number of rows printed.
+size_t RenderResultSet(ResultSet *result) {
+    const Table *table = result->Table;
+    OutputBuffer out = {malloc(RENDER_BUFFER_BYTES), 0};
+    size_t *rows = malloc(sizeof(size_t) * RESULT_BATCH_ROWS);
+    size_t *widths = malloc(sizeof(size_t) * (result->ColumnCount ? result->ColumnCount : 1));
+    if (!out.Data || !rows || !widths) {
+        printf("Out of memory rendering '%s'.\n", table->TableName);
+        free(out.Data);
+        free(rows);
+        free(widths);
+        return 0;
+    }
+
+    ResultSetRewind(result);
+    size_t n = ResultSetNext(result, rows, RESULT_BATCH_ROWS), total = 0;
+    SizeColumns(result, rows, n, widths);
+    AppendHeader(&out, result, widths);
+
+    char cell[CELL_CHARS];
+    for (; n > 0; n = ResultSetNext(result, rows, RESULT_BATCH_ROWS)) {
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t k = 0; k < result->ColumnCount; ++k) {
+                size_t len;
+                const char *text = FormatCell(table, result->Columns[k], rows[i], cell, &len);
+                AppendPadded(&out, text, len, widths[k]);
+            }
+            Append(&out, "|\n", 2);
+        }
+        total += n;
+    }
+
+    Flush(&out);
+    free(out.Data);
+    free(rows);
+    free(widths);
+    return total;
+}
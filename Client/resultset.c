@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#include "functions.h"
+#include "database.h"
+
+// Wraps count rows of table (taken over; NULL if count is 0) as a result set showing all
+// columns, unlimited.
+ResultSet *CreateResultSet(const Table *table, size_t *rows, size_t count) {
+    ResultSet *result = calloc(1, sizeof(ResultSet));
+    size_t *columns = malloc(sizeof(size_t) * (table->AttributeCount ? table->AttributeCount : 1));
+    if (!result || !columns) {
+        printf("Out of memory building the result of '%s'.\n", table->TableName);
+        free(result);
+        free(columns);
+        free(rows);
+        return NULL;
+    }
+
+    for (size_t j = 0; j < table->AttributeCount; ++j) columns[j] = j;
+    result->Table = table;
+    result->Rows = rows;
+    result->RowCount = count;
+    result->Columns = columns;
+    result->ColumnCount = table->AttributeCount;
+    result->Limit = SIZE_MAX;
+    return result;
+}
+
+// Every live row of table in table order, found as the result is read rather than listed
+// up front.
+ResultSet *TableResultSet(const Table *table) {
+    ResultSet *result = CreateResultSet(table, NULL, 0);
+    if (result) result->AllRows = true;
+    return result;
+}
+
+void FreeResultSet(ResultSet *result) {
+    if (!result) return;
+    free(result->Rows);
+    free(result->Columns);
+    free(result);
+}
+
+// Restricts the result to the columns named in list ("a, b"); NULL or "*" keeps them all.
+bool ProjectResultSet(ResultSet *result, const char *list) {
+    const char *p = list;
+    while (p && isspace((unsigned char)*p)) p++;
+    if (!p || strcmp(p, "*") == 0) return true;
+
+    const Table *table = result->Table;
+    size_t count = 0;
+    for (;;) {
+        while (isspace((unsigned char)*p) || *p == ',') p++;
+        if (*p == '\0') break;
+
+        const char *name = p;
+        while (*p && !isspace((unsigned char)*p) && *p != ',') p++;
+        char column[64];
+        snprintf(column, sizeof(column), "%.*s", (int)(p - name), name);
+
+        int col = FindColumn(table, column);
+        if (col == -1) {
+            printf("Column '%s' not found in table '%s'.\n", column, table->TableName);
+            return false;
+        }
+        if (count == table->AttributeCount) {
+            printf("Too many columns selected from table '%s'.\n", table->TableName);
+            return false;
+        }
+        result->Columns[count++] = (size_t)col;
+    }
+    if (count == 0) {
+        printf("No columns selected.\n");
+        return false;
+    }
+    result->ColumnCount = count;
+    return true;
+}
+
+// Restricts the result to columns resolved up front, in the order given.
+bool ProjectResultSetColumns(ResultSet *result, const ColumnHandle *columns, size_t count) {
+    const Table *table = result->Table;
+    if (count == 0 || count > table->AttributeCount) {
+        printf("Between 1 and %zu columns can be selected from table '%s'.\n", table->AttributeCount, table->TableName);
+        return false;
+    }
+    for (size_t k = 0; k < count; ++k) {
+        if (!ColumnHandleValid(table, columns[k])) return false;
+    }
+    for (size_t k = 0; k < count; ++k) result->Columns[k] = columns[k].Index;
+    result->ColumnCount = count;
+    return true;
+}
+
+// Skips the first offset rows of the result and stops after limit more (SIZE_MAX for no
+// limit), relative to any window already applied. Rewinds the result.
+void ResultSetLimit(ResultSet *result, size_t offset, size_t limit) {
+    size_t available = result->Limit;
+    size_t skip = offset < available ? offset : available;
+    result->Offset += skip;
+    result->Limit = limit < available - skip ? limit : available - skip;
+    ResultSetRewind(result);
+}
+
+void ResultSetRewind(ResultSet *result) {
+    result->Cursor = 0;
+    result->Skipped = 0;
+    result->Returned = 0;
+}
+
+// Rows the result returns from the start, after its window.
+size_t ResultSetCount(const ResultSet *result) {
+    const Table *table = result->Table;
+    size_t rows = result->AllRows ? table->RowCount - table->DeletedCount : result->RowCount;
+    rows = rows > result->Offset ? rows - result->Offset : 0;
+    return rows < result->Limit ? rows : result->Limit;
+}
+
+// Copies the next at most max row ids of the result into rows and returns how many; 0 once
+// it is exhausted. A TableResultSet finds live rows as they are asked for, so a limited one
+// never looks past the rows it returns.
+size_t ResultSetNext(ResultSet *result, size_t *rows, size_t max) {
+    size_t left = result->Limit - result->Returned;
+    if (max > left) max = left;
+
+    size_t n = 0;
+    if (!result->AllRows) {
+        if (result->Cursor < result->Offset) result->Cursor = result->Offset;
+        while (n < max && result->Cursor < result->RowCount) rows[n++] = result->Rows[result->Cursor++];
+    } else {
+        const Table *table = result->Table;
+        while (n < max && result->Cursor < table->RowCount) {
+            size_t row = result->Cursor++;
+            if (IsRowDeleted(table, row)) continue;
+            if (result->Skipped < result->Offset) {
+                result->Skipped++;
+                continue;
+            }
+            rows[n++] = row;
+        }
+    }
+    result->Returned += n;
+    return n;
+}
+
+// Runs a query against table: the rows matching where (NULL for every row), ordered by
+// orderBy (e.g. "price DESC LIMIT 10 OFFSET 20", NULL for table order), showing columns
+// ("a, b", NULL or "*" for all). Returns NULL if any part does not parse.
+ResultSet *ExecuteQuery(Table *table, const char *columns, const char *where, const char *orderBy) {
+    if (!table) return NULL;
+
+    OrderBy order;
+    if (orderBy && !ParseOrderBy(table, orderBy, &order)) return NULL;
+
+    size_t *rows = NULL;
+    size_t count = 0;
+    if (where) {
+        count = FindMatchingRows(table, where, &rows);
+        if (count == (size_t)-1) return NULL;
+    }
+    // No matches leave rows NULL, which SortRows would take for every row.
+    if (orderBy && (!where || count > 0)) {
+        size_t *sorted = SortRows(table, rows, count, &order, &count);
+        free(rows);
+        if (!sorted) return NULL;
+        rows = sorted;
+    }
+
+    ResultSet *result = where || orderBy ? CreateResultSet(table, rows, count) : TableResultSet(table);
+    if (result && !ProjectResultSet(result, columns)) {
+        FreeResultSet(result);
+        return NULL;
+    }
+    return result;
+}
+
+// Copies the result from its start into a new table called name holding its columns, a
+// batch at a time. Interned columns stay interned. Returns NULL if out of memory.
+Table *MaterializeResultSet(ResultSet *result, const char *name) {
+    const Table *source = result->Table;
+    size_t columns = result->ColumnCount;
+
+    Attribute *attributes = calloc(columns ? columns : 1, sizeof(Attribute));
+    if (!attributes) return NULL;
+    for (size_t k = 0; k < columns; ++k) attributes[k] = source->Attributes[result->Columns[k]];
+
+    Table *table = CreateTable(name, attributes, columns);
+    free(attributes);
+    for (size_t k = 0; table && k < columns; ++k) {
+        if (source->Columns[result->Columns[k]].Dict) InternColumn(table, k);
+    }
+
+    void **cells = calloc(columns ? columns : 1, sizeof(void *));
+    size_t *rows = malloc(sizeof(size_t) * RESULT_BATCH_ROWS);
+    bool ok = table && cells && rows && ReserveRows(table, ResultSetCount(result));
+    for (size_t k = 0; ok && k < columns; ++k) {
+        cells[k] = malloc((table->Attributes[k].AttributeType == DT_STRING ? sizeof(char *) : sizeof(uint32_t)) * RESULT_BATCH_ROWS);
+        ok = cells[k] != NULL;
+    }
+
+    size_t n;
+    ResultSetRewind(result);
+    while (ok && (n = ResultSetNext(result, rows, RESULT_BATCH_ROWS)) > 0) {
+        for (size_t k = 0; k < columns; ++k) {
+            size_t col = result->Columns[k];
+            if (source->Attributes[col].AttributeType == DT_STRING) {
+                const char **texts = cells[k];
+                for (size_t i = 0; i < n; ++i) texts[i] = GetCell(source, col, rows[i]);
+            } else {
+                const uint32_t *values = source->Columns[col].Values;
+                uint32_t *out = cells[k];
+                for (size_t i = 0; i < n; ++i) out[i] = values[rows[i]];
+            }
+        }
+        RowBatch batch = {cells, false};
+        ok = InsertRows(table, &batch, n);
+    }
+
+    if (!ok) {
+        printf("Out of memory building the table '%s'.\n", name);
+        FreeTable(table);
+        table = NULL;
+    }
+    for (size_t k = 0; cells && k < columns; ++k) free(cells[k]);
+    free(cells);
+    free(rows);
+    return table;
+}
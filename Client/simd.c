@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "functions.h"
+#include "database.h"
+
+// Vector filter kernels for INT/UINT/FLOAT columns. They are built with per-function target
+// attributes so one binary carries SSE2 and AVX2 code and picks between them at runtime;
+// compilers or CPUs without them fall back to the scalar kernels in predicate.c.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define HAVE_X86_SIMD 1
+    #include <immintrin.h>
+#endif
+
+static SimdLevel ActiveLevel = SIMD_UNSET;
+
+SimdLevel DetectSimdLevel(void) {
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return SIMD_SSE2;
+#endif
+    return SIMD_SCALAR;
+}
+
+SimdLevel GetSimdLevel(void) {
+    if (ActiveLevel == SIMD_UNSET) ActiveLevel = DetectSimdLevel();
+    return ActiveLevel;
+}
+
+// Requests above what the CPU supports are clamped.
+void SetSimdLevel(SimdLevel level) {
+    SimdLevel detected = DetectSimdLevel();
+    ActiveLevel = level > detected ? detected : level;
+}
+
+const char *SimdLevelName(SimdLevel level) {
+    switch (level) {
+        case SIMD_SSE2: return "SSE2";
+        case SIMD_AVX2: return "AVX2";
+        default: return "scalar";
+    }
+}
+
+#ifdef HAVE_X86_SIMD
+
+// Row offsets of the set bits of every 8-lane mask, so a vector's matches are written with
+// a fixed number of stores instead of a branch per bit.
+static uint8_t LaneOffsets[256][8];
+static uint8_t LaneCounts[256];
+
+static void InitLaneOffsets(void) {
+    if (LaneCounts[255]) return;
+    for (unsigned mask = 0; mask < 256; ++mask) {
+        uint8_t n = 0;
+        for (uint8_t lane = 0; lane < 8; ++lane) {
+            if (mask & (1u << lane)) LaneOffsets[mask][n++] = lane;
+        }
+        LaneCounts[mask] = n;
+    }
+}
+
+// Writes all `lanes` slots and advances n by the matches; out needs room for `lanes` ids.
+// Vectors without matches skip the stores, which selective filters hit most of the time.
+#define EMIT_LANES(mask, lanes, base, out, n)                           \
+    do {                                                                \
+        if (!(mask)) break;                                             \
+        const uint8_t *offsets = LaneOffsets[mask];                     \
+        for (int k = 0; k < (lanes); ++k) (out)[(n) + k] = (base) + offsets[k]; \
+        (n) += LaneCounts[mask];                                        \
+    } while (0)
+
+// The vector emitters widen the lane offsets to 64-bit row ids and store them whole: SSE2
+// writes four ids with two stores (unpacking against zero, as it lacks pmovzx), AVX2 writes
+// eight with two.
+#if defined(__x86_64__)
+    #define SSE2_EMIT_LANES(mask, base, out, n)                                                  \
+        do {                                                                                     \
+            if (!(mask)) break;                                                                  \
+            const __m128i zero = _mm_setzero_si128();                                            \
+            int packed;                                                                          \
+            memcpy(&packed, LaneOffsets[mask], sizeof(packed));                                  \
+            __m128i offsets = _mm_cvtsi32_si128(packed);                                         \
+            offsets = _mm_unpacklo_epi16(_mm_unpacklo_epi8(offsets, zero), zero);                \
+            __m128i baseIds = _mm_set1_epi64x((long long)(base));                                \
+            _mm_storeu_si128((__m128i *)((out) + (n)),                                           \
+                             _mm_add_epi64(baseIds, _mm_unpacklo_epi32(offsets, zero)));         \
+            _mm_storeu_si128((__m128i *)((out) + (n) + 2),                                       \
+                             _mm_add_epi64(baseIds, _mm_unpackhi_epi32(offsets, zero)));         \
+            (n) += LaneCounts[mask];                                                             \
+        } while (0)
+
+    #define AVX2_EMIT_LANES(mask, base, out, n)                                                  \
+        do {                                                                                     \
+            if (!(mask)) break;                                                                  \
+            __m128i offsets = _mm_loadl_epi64((const __m128i *)LaneOffsets[mask]);               \
+            __m256i baseIds = _mm256_set1_epi64x((long long)(base));                             \
+            _mm256_storeu_si256((__m256i *)((out) + (n)),                                        \
+                                _mm256_add_epi64(baseIds, _mm256_cvtepu8_epi64(offsets)));       \
+            _mm256_storeu_si256((__m256i *)((out) + (n) + 4),                                    \
+                                _mm256_add_epi64(baseIds, _mm256_cvtepu8_epi64(_mm_srli_si128(offsets, 4)))); \
+            (n) += LaneCounts[mask];                                                             \
+        } while (0)
+#else
+    #define SSE2_EMIT_LANES(mask, base, out, n) EMIT_LANES(mask, 4, base, out, n)
+    #define AVX2_EMIT_LANES(mask, base, out, n) EMIT_LANES(mask, 8, base, out, n)
+#endif
+
+// Tail vectors may have fewer free slots than lanes, so they append bit by bit.
+#define EMIT_MASK(mask, base, out, n)                        \
+    while (mask) {                                           \
+        (out)[(n)++] = (base) + (size_t)__builtin_ctz(mask); \
+        (mask) &= (mask) - 1;                                \
+    }
+
+// Integer lanes: UINT values are biased by 0x80000000 so the signed compares order them
+// correctly. NEQ/GTE/LTE are the complements of EQ/LT/GT.
+#define INT_MASK(cmpeq, cmpgt, movemask, v, lit, op, lanesMask)                   \
+    ((op) == OP_EQ  ? (unsigned)movemask(cmpeq(v, lit)) :                          \
+     (op) == OP_NEQ ? (unsigned)movemask(cmpeq(v, lit)) ^ (lanesMask) :            \
+     (op) == OP_GT  ? (unsigned)movemask(cmpgt(v, lit)) :                          \
+     (op) == OP_LT  ? (unsigned)movemask(cmpgt(lit, v)) :                          \
+     (op) == OP_GTE ? (unsigned)movemask(cmpgt(lit, v)) ^ (lanesMask) :            \
+                      (unsigned)movemask(cmpgt(v, lit)) ^ (lanesMask))
+
+#define SSE2_MOVEMASK(x) _mm_movemask_ps(_mm_castsi128_ps(x))
+#define AVX2_MOVEMASK(x) _mm256_movemask_ps(_mm256_castsi256_ps(x))
+
+static inline __attribute__((always_inline, target("sse2")))
+size_t Sse2IntScan(const int32_t *values, size_t begin, size_t end, int32_t literal, int32_t bias,
+                   CompareOperator op, size_t *out) {
+    const __m128i lit = _mm_set1_epi32(literal ^ bias);
+    const __m128i flip = _mm_set1_epi32(bias);
+    size_t n = 0, i = begin;
+
+    for (; i + 4 <= end; i += 4) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(values + i)), flip);
+        unsigned mask = INT_MASK(_mm_cmpeq_epi32, _mm_cmpgt_epi32, SSE2_MOVEMASK, v, lit, op, 0xFu);
+        SSE2_EMIT_LANES(mask, i, out, n);
+    }
+
+    if (i < end) {
+        int32_t tail[4] = {0, 0, 0, 0};
+        memcpy(tail, values + i, (end - i) * sizeof(int32_t));
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)tail), flip);
+        unsigned mask = INT_MASK(_mm_cmpeq_epi32, _mm_cmpgt_epi32, SSE2_MOVEMASK, v, lit, op, 0xFu);
+        mask &= (1u << (end - i)) - 1;
+        EMIT_MASK(mask, i, out, n);
+    }
+    return n;
+}
+
+static inline __attribute__((always_inline, target("avx2")))
+size_t Avx2IntScan(const int32_t *values, size_t begin, size_t end, int32_t literal, int32_t bias,
+                   CompareOperator op, size_t *out) {
+    const __m256i lit = _mm256_set1_epi32(literal ^ bias);
+    const __m256i flip = _mm256_set1_epi32(bias);
+    size_t n = 0, i = begin;
+
+    for (; i + 8 <= end; i += 8) {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(values + i)), flip);
+        unsigned mask = INT_MASK(_mm256_cmpeq_epi32, _mm256_cmpgt_epi32, AVX2_MOVEMASK, v, lit, op, 0xFFu);
+        AVX2_EMIT_LANES(mask, i, out, n);
+    }
+
+    if (i < end) {
+        int32_t tail[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        memcpy(tail, values + i, (end - i) * sizeof(int32_t));
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)tail), flip);
+        unsigned mask = INT_MASK(_mm256_cmpeq_epi32, _mm256_cmpgt_epi32, AVX2_MOVEMASK, v, lit, op, 0xFFu);
+        mask &= (1u << (end - i)) - 1;
+        EMIT_MASK(mask, i, out, n);
+    }
+    return n;
+}
+
+// Float lanes use ordered compares, except NEQ which is unordered, matching C for NaN.
+static inline __attribute__((always_inline, target("sse2")))
+unsigned Sse2FloatMask(__m128 v, __m128 lit, CompareOperator op) {
+    switch (op) {
+        case OP_EQ: return (unsigned)_mm_movemask_ps(_mm_cmpeq_ps(v, lit));
+        case OP_NEQ: return (unsigned)_mm_movemask_ps(_mm_cmpneq_ps(v, lit));
+        case OP_GT: return (unsigned)_mm_movemask_ps(_mm_cmpgt_ps(v, lit));
+        case OP_LT: return (unsigned)_mm_movemask_ps(_mm_cmplt_ps(v, lit));
+        case OP_GTE: return (unsigned)_mm_movemask_ps(_mm_cmpge_ps(v, lit));
+        default: return (unsigned)_mm_movemask_ps(_mm_cmple_ps(v, lit));
+    }
+}
+
+static inline __attribute__((always_inline, target("avx2")))
+unsigned Avx2FloatMask(__m256 v, __m256 lit, CompareOperator op) {
+    switch (op) {
+        case OP_EQ: return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(v, lit, _CMP_EQ_OQ));
+        case OP_NEQ: return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(v, lit, _CMP_NEQ_UQ));
+        case OP_GT: return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(v, lit, _CMP_GT_OQ));
+        case OP_LT: return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(v, lit, _CMP_LT_OQ));
+        case OP_GTE: return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(v, lit, _CMP_GE_OQ));
+        default: return (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(v, lit, _CMP_LE_OQ));
+    }
+}
+
+static inline __attribute__((always_inline, target("sse2")))
+size_t Sse2FloatScan(const float *values, size_t begin, size_t end, float literal, CompareOperator op, size_t *out) {
+    const __m128 lit = _mm_set1_ps(literal);
+    size_t n = 0, i = begin;
+
+    for (; i + 4 <= end; i += 4) {
+        unsigned mask = Sse2FloatMask(_mm_loadu_ps(values + i), lit, op);
+        SSE2_EMIT_LANES(mask, i, out, n);
+    }
+
+    if (i < end) {
+        float tail[4] = {0, 0, 0, 0};
+        memcpy(tail, values + i, (end - i) * sizeof(float));
+        unsigned mask = Sse2FloatMask(_mm_loadu_ps(tail), lit, op) & ((1u << (end - i)) - 1);
+        EMIT_MASK(mask, i, out, n);
+    }
+    return n;
+}
+
+static inline __attribute__((always_inline, target("avx2")))
+size_t Avx2FloatScan(const float *values, size_t begin, size_t end, float literal, CompareOperator op, size_t *out) {
+    const __m256 lit = _mm256_set1_ps(literal);
+    size_t n = 0, i = begin;
+
+    for (; i + 8 <= end; i += 8) {
+        unsigned mask = Avx2FloatMask(_mm256_loadu_ps(values + i), lit, op);
+        AVX2_EMIT_LANES(mask, i, out, n);
+    }
+
+    if (i < end) {
+        float tail[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        memcpy(tail, values + i, (end - i) * sizeof(float));
+        unsigned mask = Avx2FloatMask(_mm256_loadu_ps(tail), lit, op) & ((1u << (end - i)) - 1);
+        EMIT_MASK(mask, i, out, n);
+    }
+    return n;
+}
+
+// The operator is a compile-time constant in every generated kernel, so the inlined scans
+// collapse to a single compare per vector.
+#define DEFINE_SIMD_INT_KERNEL(name, isa, scan, field, bias, op)                                  \
+    static __attribute__((target(isa))) size_t name(const Predicate *pred, const Table *table,   \
+                                                    size_t begin, size_t end, size_t *out) {     \
+        return scan(table->Columns[pred->Column].Values, begin, end,                             \
+                    (int32_t)pred->Literal.field, (int32_t)(bias), op, out);                     \
+    }
+
+#define DEFINE_SIMD_FLOAT_KERNEL(name, isa, scan, op)                                             \
+    static __attribute__((target(isa))) size_t name(const Predicate *pred, const Table *table,   \
+                                                    size_t begin, size_t end, size_t *out) {     \
+        return scan(table->Columns[pred->Column].Values, begin, end, pred->Literal.Float, op, out); \
+    }
+
+#define DEFINE_SIMD_KERNELS(prefix, isa, intScan, floatScan)                                  \
+    DEFINE_SIMD_INT_KERNEL(prefix##IntEq, isa, intScan, Int, 0, OP_EQ)                        \
+    DEFINE_SIMD_INT_KERNEL(prefix##IntNeq, isa, intScan, Int, 0, OP_NEQ)                      \
+    DEFINE_SIMD_INT_KERNEL(prefix##IntGt, isa, intScan, Int, 0, OP_GT)                        \
+    DEFINE_SIMD_INT_KERNEL(prefix##IntLt, isa, intScan, Int, 0, OP_LT)                        \
+    DEFINE_SIMD_INT_KERNEL(prefix##IntGte, isa, intScan, Int, 0, OP_GTE)                      \
+    DEFINE_SIMD_INT_KERNEL(prefix##IntLte, isa, intScan, Int, 0, OP_LTE)                      \
+    DEFINE_SIMD_INT_KERNEL(prefix##UintEq, isa, intScan, Uint, 0x80000000u, OP_EQ)            \
+    DEFINE_SIMD_INT_KERNEL(prefix##UintNeq, isa, intScan, Uint, 0x80000000u, OP_NEQ)          \
+    DEFINE_SIMD_INT_KERNEL(prefix##UintGt, isa, intScan, Uint, 0x80000000u, OP_GT)            \
+    DEFINE_SIMD_INT_KERNEL(prefix##UintLt, isa, intScan, Uint, 0x80000000u, OP_LT)            \
+    DEFINE_SIMD_INT_KERNEL(prefix##UintGte, isa, intScan, Uint, 0x80000000u, OP_GTE)          \
+    DEFINE_SIMD_INT_KERNEL(prefix##UintLte, isa, intScan, Uint, 0x80000000u, OP_LTE)          \
+    DEFINE_SIMD_FLOAT_KERNEL(prefix##FloatEq, isa, floatScan, OP_EQ)                          \
+    DEFINE_SIMD_FLOAT_KERNEL(prefix##FloatNeq, isa, floatScan, OP_NEQ)                        \
+    DEFINE_SIMD_FLOAT_KERNEL(prefix##FloatGt, isa, floatScan, OP_GT)                          \
+    DEFINE_SIMD_FLOAT_KERNEL(prefix##FloatLt, isa, floatScan, OP_LT)                          \
+    DEFINE_SIMD_FLOAT_KERNEL(prefix##FloatGte, isa, floatScan, OP_GTE)                        \
+    DEFINE_SIMD_FLOAT_KERNEL(prefix##FloatLte, isa, floatScan, OP_LTE)                        \
+    static const PredicateKernel prefix##Kernels[3][6] = {                                    \
+        {prefix##IntEq, prefix##IntNeq, prefix##IntGt, prefix##IntLt, prefix##IntGte, prefix##IntLte}, \
+        {prefix##UintEq, prefix##UintNeq, prefix##UintGt, prefix##UintLt, prefix##UintGte, prefix##UintLte}, \
+        {prefix##FloatEq, prefix##FloatNeq, prefix##FloatGt, prefix##FloatLt, prefix##FloatGte, prefix##FloatLte}, \
+    };
+
+DEFINE_SIMD_KERNELS(Sse2, "sse2", Sse2IntScan, Sse2FloatScan)
+DEFINE_SIMD_KERNELS(Avx2, "avx2", Avx2IntScan, Avx2FloatScan)
+
+#endif
+
+#ifdef HAVE_X86_SIMD
+
+static __attribute__((target("sse2")))
+size_t Sse2FindFieldEnd(const char *text, size_t len, char delimiter) {
+    const __m128i delim = _mm_set1_epi8(delimiter), lf = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(text + i));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, delim), _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+    for (; i < len; ++i) {
+        if (text[i] == delimiter || text[i] == '\n' || text[i] == '\r') return i;
+    }
+    return len;
+}
+
+static __attribute__((target("avx2")))
+size_t Avx2FindFieldEnd(const char *text, size_t len, char delimiter) {
+    const __m256i delim = _mm256_set1_epi8(delimiter), lf = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(text + i));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(v, delim),
+                                       _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hits);
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+    return i + Sse2FindFieldEnd(text + i, len - i, delimiter);
+}
+
+#endif
+
+// Offset of the first delimiter, '\n' or '\r' in text[0, len), or len. IMPORT uses it to
+// step over unquoted field contents a vector at a time.
+size_t FindFieldEnd(const char *text, size_t len, char delimiter) {
+#ifdef HAVE_X86_SIMD
+    switch (GetSimdLevel()) {
+        case SIMD_AVX2: return Avx2FindFieldEnd(text, len, delimiter);
+        case SIMD_SSE2: return Sse2FindFieldEnd(text, len, delimiter);
+        default: break;
+    }
+#endif
+    for (size_t i = 0; i < len; ++i) {
+        if (text[i] == delimiter || text[i] == '\n' || text[i] == '\r') return i;
+    }
+    return len;
+}
+
+// Returns the vector kernel for a numeric column at the active SIMD level, or NULL when the
+// scalar kernel should be used.
+PredicateKernel SelectSimdKernel(DataTypes type, CompareOperator op) {
+    if (type == DT_STRING || op == OP_UNKNOWN) return NULL;
+
+#ifdef HAVE_X86_SIMD
+    InitLaneOffsets();
+    switch (GetSimdLevel()) {
+        case SIMD_AVX2: return Avx2Kernels[type][op];
+        case SIMD_SSE2: return Sse2Kernels[type][op];
+        default: break;
+    }
+#endif
+    return NULL;
+}
@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#include "functions.h"
+#include "database.h"
+
+// ORDER BY. Rows are never moved: sorting works on (key, row id) pairs and returns the row
+// ids in order. Every cell is first turned into an unsigned key whose order is the column's
+// order: numbers by flipping sign bits, interned strings by the rank of their code, other
+// strings by their first 8 bytes. Full sorts are LSD radix sorts over those keys; strings
+// whose prefixes tie are then put in order by their text. A small LIMIT keeps the best rows
+// in a bounded heap instead.
+
+// LIMITs up to this share of the input go through the heap.
+#define TOP_N_MAX_SHARE 16
+// Runs of strings with equal prefixes shorter than this are compared whole, longer ones are
+// radix sorted again on their next 8 bytes.
+#define TEXT_RUN_QSORT_ROWS 64
+
+typedef struct {
+    uint64_t Key;
+    size_t Row;
+} SortPair;
+
+typedef struct {
+    const Table *Table;
+    size_t Column;
+    bool Descending;
+    bool Text;          // plain STRING column: equal keys may still differ further on
+    uint32_t *Ranks;    // interned column: sort position of each code
+    unsigned KeyBytes;
+} SortKeys;
+
+static int CompareCodes(const SortKeys *keys, uint32_t a, uint32_t b) {
+    return strcmp(DictionaryString(keys->Table, keys->Column, a), DictionaryString(keys->Table, keys->Column, b));
+}
+
+// Interned columns sort on code ranks, found by sorting the (few) distinct strings once.
+static bool RankCodes(SortKeys *keys) {
+    const ColumnDictionary *dict = keys->Table->Columns[keys->Column].Dict;
+    size_t count = dict->Count;
+    uint32_t *order = malloc(sizeof(uint32_t) * (count ? count : 1));
+    keys->Ranks = malloc(sizeof(uint32_t) * (count ? count : 1));
+    if (!order || !keys->Ranks) {
+        free(order);
+        return false;
+    }
+
+    // Insertion into a sorted run; dictionaries are small enough that this is not the cost.
+    for (size_t i = 0; i < count; ++i) {
+        size_t j = i;
+        uint32_t code = (uint32_t)i;
+        while (j > 0 && CompareCodes(keys, order[j - 1], code) > 0) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = code;
+    }
+    for (size_t i = 0; i < count; ++i) keys->Ranks[order[i]] = (uint32_t)i;
+    free(order);
+    return true;
+}
+
+static const char *RowText(const SortKeys *keys, size_t row) {
+    return GetCell(keys->Table, keys->Column, row);
+}
+
+// 8 bytes of a string from offset depth, which must not be past its end.
+static uint64_t TextKey(const SortKeys *keys, size_t row, size_t depth) {
+    uint64_t key = EncodeIndexKey(DT_STRING, RowText(keys, row) + depth);
+    return keys->Descending ? ~key : key;
+}
+
+static uint64_t SortKey(const SortKeys *keys, size_t row) {
+    const Column *column = &keys->Table->Columns[keys->Column];
+    uint64_t key;
+    switch (keys->Table->Attributes[keys->Column].AttributeType) {
+        case DT_INT:
+            key = ((const uint32_t *)column->Values)[row] ^ 0x80000000u;
+            break;
+        case DT_UINT:
+            key = ((const uint32_t *)column->Values)[row];
+            break;
+        case DT_FLOAT:
+            key = EncodeIndexKey(DT_FLOAT, &((const float *)column->Values)[row]);
+            break;
+        default:
+            if (!keys->Ranks) return TextKey(keys, row, 0);
+            key = keys->Ranks[((const uint32_t *)column->Values)[row]];
+            break;
+    }
+    return keys->Descending ? ~key & 0xffffffffu : key;
+}
+
+// Full order of two pairs: key, then text for plain strings, then row id.
+static int ComparePairs(const SortKeys *keys, const SortPair *a, const SortPair *b) {
+    if (a->Key != b->Key) return a->Key < b->Key ? -1 : 1;
+    if (keys->Text) {
+        int cmp = strcmp(RowText(keys, a->Row), RowText(keys, b->Row));
+        if (cmp != 0) return keys->Descending ? -cmp : cmp;
+    }
+    return a->Row < b->Row ? -1 : a->Row > b->Row;
+}
+
+// Stable LSD radix sort on the low keyBytes bytes of the keys, a byte per pass. All byte
+// histograms are taken in one read of the input, and passes where every key shares the
+// byte are skipped.
+static bool RadixSortPairs(SortPair *pairs, size_t count, unsigned keyBytes) {
+    size_t (*histograms)[256] = calloc(keyBytes, sizeof(*histograms));
+    SortPair *scratch = malloc(sizeof(SortPair) * (count ? count : 1));
+    if (!histograms || !scratch) {
+        free(histograms);
+        free(scratch);
+        return false;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t key = pairs[i].Key;
+        for (unsigned b = 0; b < keyBytes; ++b) histograms[b][(key >> (8 * b)) & 0xff]++;
+    }
+
+    SortPair *from = pairs, *to = scratch;
+    for (unsigned b = 0; b < keyBytes; ++b) {
+        size_t *histogram = histograms[b];
+        if (histogram[(from[0].Key >> (8 * b)) & 0xff] == count) continue;
+
+        size_t offset = 0;
+        for (size_t v = 0; v < 256; ++v) {
+            size_t n = histogram[v];
+            histogram[v] = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; ++i) to[histogram[(from[i].Key >> (8 * b)) & 0xff]++] = from[i];
+
+        SortPair *swap = from;
+        from = to;
+        to = swap;
+    }
+
+    if (from != pairs) memcpy(pairs, from, sizeof(SortPair) * count);
+    free(histograms);
+    free(scratch);
+    return true;
+}
+
+typedef struct {
+    const char *Text;
+    size_t Row;
+} TextPair;
+
+static int CompareTextAscending(const void *a, const void *b) {
+    const TextPair *x = a, *y = b;
+    int cmp = strcmp(x->Text, y->Text);
+    if (cmp != 0) return cmp;
+    return x->Row < y->Row ? -1 : x->Row > y->Row;
+}
+
+static int CompareTextDescending(const void *a, const void *b) {
+    const TextPair *x = a, *y = b;
+    int cmp = strcmp(y->Text, x->Text);
+    if (cmp != 0) return cmp;
+    return x->Row < y->Row ? -1 : x->Row > y->Row;
+}
+
+static bool SortShortRun(const SortKeys *keys, SortPair *pairs, size_t count) {
+    TextPair run[TEXT_RUN_QSORT_ROWS];
+    for (size_t i = 0; i < count; ++i) {
+        run[i].Text = RowText(keys, pairs[i].Row);
+        run[i].Row = pairs[i].Row;
+    }
+    qsort(run, count, sizeof(TextPair), keys->Descending ? CompareTextDescending : CompareTextAscending);
+    for (size_t i = 0; i < count; ++i) pairs[i].Row = run[i].Row;
+    return true;
+}
+
+// Once pairs are in order by the 8 bytes at depth, puts each run of equal bytes in order by
+// the rest of the text. Bytes ending in NUL hold the whole rest of the string, so such runs
+// are already in order.
+static bool SortTextRuns(const SortKeys *keys, SortPair *pairs, size_t count, size_t depth) {
+    for (size_t begin = 0; begin < count;) {
+        size_t end = begin + 1;
+        while (end < count && pairs[end].Key == pairs[begin].Key) end++;
+
+        uint64_t bytes = keys->Descending ? ~pairs[begin].Key : pairs[begin].Key;
+        size_t run = end - begin;
+        if (run > 1 && (bytes & 0xff) != 0) {
+            bool ok;
+            if (run <= TEXT_RUN_QSORT_ROWS) {
+                ok = SortShortRun(keys, pairs + begin, run);
+            } else {
+                for (size_t i = begin; i < end; ++i) pairs[i].Key = TextKey(keys, pairs[i].Row, depth + 8);
+                ok = RadixSortPairs(pairs + begin, run, 8) && SortTextRuns(keys, pairs + begin, run, depth + 8);
+            }
+            if (!ok) return false;
+        }
+        begin = end;
+    }
+    return true;
+}
+
+// Bounded max-heap holding the limit best pairs seen so far, the worst of them on top.
+static void SiftDown(const SortKeys *keys, SortPair *heap, size_t count, size_t i) {
+    for (;;) {
+        size_t worst = i, left = 2 * i + 1, right = left + 1;
+        if (left < count && ComparePairs(keys, &heap[left], &heap[worst]) > 0) worst = left;
+        if (right < count && ComparePairs(keys, &heap[right], &heap[worst]) > 0) worst = right;
+        if (worst == i) return;
+        SortPair swap = heap[i];
+        heap[i] = heap[worst];
+        heap[worst] = swap;
+        i = worst;
+    }
+}
+
+static void SiftUp(const SortKeys *keys, SortPair *heap, size_t i) {
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (ComparePairs(keys, &heap[i], &heap[parent]) <= 0) return;
+        SortPair swap = heap[i];
+        heap[i] = heap[parent];
+        heap[parent] = swap;
+        i = parent;
+    }
+}
+
+static size_t TopRows(const SortKeys *keys, const size_t *rows, size_t count, size_t limit, SortPair *heap) {
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i) {
+        SortPair pair = {SortKey(keys, rows[i]), rows[i]};
+        if (size < limit) {
+            heap[size] = pair;
+            SiftUp(keys, heap, size++);
+        } else if (ComparePairs(keys, &pair, &heap[0]) < 0) {
+            heap[0] = pair;
+            SiftDown(keys, heap, size, 0);
+        }
+    }
+
+    // Heap sort in place: the worst goes last each round
+    for (size_t n = size; n > 1; --n) {
+        SortPair swap = heap[0];
+        heap[0] = heap[n - 1];
+        heap[n - 1] = swap;
+        SiftDown(keys, heap, n - 1, 0);
+    }
+    return size;
+}
+
+static bool ReadWord(const char **text, char *word, size_t size) {
+    const char *p = *text;
+    while (isspace((unsigned char)*p)) p++;
+    size_t len = 0;
+    while (*p && !isspace((unsigned char)*p)) {
+        if (len + 1 < size) word[len++] = *p;
+        p++;
+    }
+    word[len] = '\0';
+    *text = p;
+    return len > 0;
+}
+
+static bool IsWord(const char *word, const char *keyword) {
+    for (; *word && *keyword; ++word, ++keyword) {
+        if (toupper((unsigned char)*word) != *keyword) return false;
+    }
+    return *word == '\0' && *keyword == '\0';
+}
+
+static bool ReadCount(const char **text, const char *keyword, size_t *count) {
+    char word[32];
+    char *end;
+    if (!ReadWord(text, word, sizeof(word)) || word[0] == '-' || (*count = (size_t)strtoull(word, &end, 10), *end != '\0')) {
+        printf("Invalid ORDER BY: expected a row count after %s.\n", keyword);
+        return false;
+    }
+    return true;
+}
+
+// order := column [ASC | DESC] [LIMIT n [OFFSET m]]
+bool ParseOrderBy(const Table *table, const char *text, OrderBy *order) {
+    char column[64], word[16];
+    order->Descending = false;
+    order->Limit = SIZE_MAX;
+    order->Offset = 0;
+
+    if (!ReadWord(&text, column, sizeof(column))) {
+        printf("Invalid ORDER BY: expected a column name.\n");
+        return false;
+    }
+    int col = FindColumn(table, column);
+    if (col == -1) {
+        printf("Column '%s' not found in table '%s'.\n", column, table->TableName);
+        return false;
+    }
+    order->Column = (size_t)col;
+
+    bool more = ReadWord(&text, word, sizeof(word));
+    if (more && (IsWord(word, "ASC") || IsWord(word, "DESC"))) {
+        order->Descending = IsWord(word, "DESC");
+        more = ReadWord(&text, word, sizeof(word));
+    }
+    if (more && IsWord(word, "LIMIT")) {
+        if (!ReadCount(&text, "LIMIT", &order->Limit)) return false;
+        more = ReadWord(&text, word, sizeof(word));
+        if (more && IsWord(word, "OFFSET")) {
+            if (!ReadCount(&text, "OFFSET", &order->Offset)) return false;
+            more = ReadWord(&text, word, sizeof(word));
+        }
+    }
+    if (more) {
+        printf("Invalid ORDER BY: unexpected '%s'.\n", word);
+        return false;
+    }
+    return true;
+}
+
+// Orders count rows (NULL for every live row) by order and returns the order->Limit rows
+// after the first order->Offset as a new array of row ids, its length in *sortedCount; NULL
+// if out of memory.
+size_t *SortRows(const Table *table, const size_t *rows, size_t count, const OrderBy *order, size_t *sortedCount) {
+    *sortedCount = 0;
+
+    size_t *all = NULL;
+    if (!rows) {
+        all = malloc(sizeof(size_t) * (table->RowCount ? table->RowCount : 1));
+        if (!all) return NULL;
+        count = 0;
+        for (size_t i = 0; i < table->RowCount; ++i) {
+            if (!IsRowDeleted(table, i)) all[count++] = i;
+        }
+        rows = all;
+    }
+
+    SortKeys keys = {table, order->Column, order->Descending, false, NULL, 4};
+    if (table->Attributes[order->Column].AttributeType == DT_STRING) {
+        if (table->Columns[order->Column].Dict) {
+            if (!RankCodes(&keys)) {
+                free(all);
+                return NULL;
+            }
+        } else {
+            keys.Text = true;
+            keys.KeyBytes = 8;
+        }
+    }
+
+    // Everything up to the end of the page is ordered, then the offset is dropped
+    size_t skip = order->Offset < count ? order->Offset : count;
+    size_t limit = order->Limit < count - skip ? skip + order->Limit : count;
+    size_t *sorted = malloc(sizeof(size_t) * (limit ? limit : 1));
+    SortPair *pairs = NULL;
+    bool ok = sorted != NULL;
+
+    if (ok && limit > 0 && limit <= count / TOP_N_MAX_SHARE) {
+        pairs = malloc(sizeof(SortPair) * limit);
+        ok = pairs && TopRows(&keys, rows, count, limit, pairs) == limit;
+    } else if (ok && limit > 0) {
+        pairs = malloc(sizeof(SortPair) * count);
+        ok = pairs != NULL;
+        for (size_t i = 0; ok && i < count; ++i) {
+            pairs[i].Key = SortKey(&keys, rows[i]);
+            pairs[i].Row = rows[i];
+        }
+        ok = ok && RadixSortPairs(pairs, count, keys.KeyBytes) && (!keys.Text || SortTextRuns(&keys, pairs, count, 0));
+    }
+
+    if (ok) {
+        for (size_t i = skip; i < limit; ++i) sorted[i - skip] = pairs[i].Row;
+        *sortedCount = limit - skip;
+    } else {
+        printf("Out of memory sorting '%s'.\n", table->TableName);
+        free(sorted);
+        sorted = NULL;
+    }
+    free(pairs);
+    free(keys.Ranks);
+    free(all);
+    return sorted;
+}
@@ -0,0 +1,942 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#include "functions.h"
+#include "database.h"
+
+#define MAX_SQL_TOKEN 256
+
+typedef enum {
+    SQL_SELECT, SQL_INSERT, SQL_UPDATE, SQL_DELETE, SQL_CREATE, SQL_ALTER_ADD, SQL_ALTER_DROP
+} StatementKind;
+
+// A value in a statement: a bare word written in it, or the number of the placeholder that
+// supplies it. Text is NULL and Parameter SIZE_MAX for a value left out.
+typedef struct {
+    char *Text;
+    size_t Parameter;
+} SqlValue;
+
+// A statement resolved against its table: columns are indexes and the WHERE clause is a
+// planned condition, so running it again only binds values.
+struct Statement {
+    StatementKind Kind;
+    char *Text;               // normalized text, the cache key
+    uint64_t Hash;
+    uint64_t LastUsed;
+    size_t ParameterCount;
+    Table *Table;
+    size_t *Columns;          // SELECT: columns shown; INSERT: column of each value of a row
+    size_t ColumnCount;
+    Condition *Where;
+    char *WhereText;          // the WHERE clause with its placeholders, for the log
+    bool Ordered;
+    OrderBy Order;
+    SqlValue Limit;
+    SqlValue Offset;
+    SqlValue *Values;         // INSERT: RowCount rows of ColumnCount values; UPDATE: one
+    size_t RowCount;
+    char *Name;               // CREATE: the table; ALTER: the column
+    char *TypeName;           // ALTER ADD: the column type
+    Attribute *Attributes;    // CREATE: AttributeCount columns
+    bool *Interned;
+    size_t AttributeCount;
+};
+
+// A statement with whitespace collapsed, its trailing semicolon dropped and every value
+// written as a quoted string or number replaced by a ? placeholder, plus the values of all
+// placeholders in order. Statements differing only in their values normalize alike.
+typedef struct {
+    char *Text;
+    char *Literals;           // the values taken out of the text, NUL-terminated
+    const char **Values;
+    size_t ValueCount;
+} NormalizedSql;
+
+typedef enum {
+    SQL_END, SQL_WORD, SQL_SYMBOL
+} SqlTokenType;
+
+typedef struct {
+    SqlSession *Session;
+    const char *Cursor;
+    const char *Start;        // where the current token begins
+    SqlTokenType Type;
+    char Token[MAX_SQL_TOKEN];
+    size_t Parameters;        // placeholders met so far
+    bool Failed;
+} SqlParser;
+
+static bool IsPunctuation(char c) {
+    return c != '\0' && strchr("(),;=!<>*", c) != NULL;
+}
+
+static bool IsDelimiter(char c) {
+    return c == '\0' || isspace((unsigned char)c) || IsPunctuation(c);
+}
+
+static bool IsNumberStart(const char *p) {
+    if (isdigit((unsigned char)p[0])) return true;
+    if (p[0] == '-' || p[0] == '+') p++;
+    if (p[0] == '.') p++;
+    return isdigit((unsigned char)p[0]) != 0;
+}
+
+static void FreeNormalized(NormalizedSql *norm) {
+    free(norm->Text);
+    free(norm->Literals);
+    free((void *)norm->Values);
+}
+
+static bool Normalize(const char *sql, const char *const *parameters, size_t parameterCount, NormalizedSql *norm) {
+    size_t len = strlen(sql);
+    norm->Text = malloc(len + 1);
+    norm->Literals = malloc(2 * len + 1);
+    norm->Values = malloc(sizeof(char *) * (len + 1));
+    norm->ValueCount = 0;
+    if (!norm->Text || !norm->Literals || !norm->Values) {
+        printf("Out of memory reading a statement.\n");
+        FreeNormalized(norm);
+        return false;
+    }
+
+    char *text = norm->Text, *literal = norm->Literals;
+    size_t n = 0, given = 0;
+    const char *p = sql;
+    while (*p) {
+        // Spaces only separate words; next to punctuation they are dropped.
+        if (isspace((unsigned char)*p)) {
+            while (isspace((unsigned char)*p)) p++;
+            if (n > 0 && !IsPunctuation(text[n - 1]) && !IsPunctuation(*p)) text[n++] = ' ';
+            continue;
+        }
+
+        bool tokenStart = n == 0 || IsDelimiter(text[n - 1]);
+        if (*p == '\'' || *p == '"') {
+            char quote = *p++;
+            norm->Values[norm->ValueCount++] = literal;
+            while (*p && *p != quote) *literal++ = *p++;
+            *literal++ = '\0';
+            if (*p == quote) p++;
+            text[n++] = '?';
+        } else if (tokenStart && *p == '?' && IsDelimiter(p[1])) {
+            if (given == parameterCount) {
+                printf("The statement has more ? placeholders than the %zu values given.\n", parameterCount);
+                FreeNormalized(norm);
+                return false;
+            }
+            norm->Values[norm->ValueCount++] = parameters[given++];
+            text[n++] = *p++;
+        } else if (tokenStart && IsNumberStart(p)) {
+            norm->Values[norm->ValueCount++] = literal;
+            while (!IsDelimiter(*p)) *literal++ = *p++;
+            *literal++ = '\0';
+            text[n++] = '?';
+        } else {
+            text[n++] = *p++;
+        }
+    }
+    while (n > 0 && (text[n - 1] == ' ' || text[n - 1] == ';')) n--;
+    text[n] = '\0';
+
+    if (given != parameterCount) {
+        printf("The statement has %zu ? placeholders but %zu values were given.\n", given, parameterCount);
+        FreeNormalized(norm);
+        return false;
+    }
+    return true;
+}
+
+static uint64_t HashStatement(const char *text) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char *)text; *p; ++p) {
+        h ^= *p;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void NextToken(SqlParser *parser) {
+    const char *p = parser->Cursor;
+    while (*p == ' ') p++;
+    parser->Start = p;
+
+    size_t len = 0;
+    if (*p == '\0') {
+        parser->Type = SQL_END;
+    } else if (strchr("(),;*", *p)) {
+        parser->Type = SQL_SYMBOL;
+        parser->Token[len++] = *p++;
+    } else if (strchr("=!<>", *p)) {
+        parser->Type = SQL_SYMBOL;
+        while (*p && strchr("=!<>", *p) && len < 2) parser->Token[len++] = *p++;
+    } else {
+        parser->Type = SQL_WORD;
+        while (!IsDelimiter(*p)) {
+            if (len + 1 < MAX_SQL_TOKEN) parser->Token[len++] = *p;
+            p++;
+        }
+    }
+    parser->Token[len] = '\0';
+    parser->Cursor = p;
+}
+
+static bool IsKeyword(const SqlParser *parser, const char *keyword) {
+    if (parser->Type != SQL_WORD) return false;
+    const char *a = parser->Token;
+    for (; *a && *keyword; ++a, ++keyword) {
+        if (toupper((unsigned char)*a) != *keyword) return false;
+    }
+    return *a == '\0' && *keyword == '\0';
+}
+
+static bool IsSymbol(const SqlParser *parser, const char *symbol) {
+    return parser->Type == SQL_SYMBOL && strcmp(parser->Token, symbol) == 0;
+}
+
+static bool SyntaxError(SqlParser *parser, const char *expected) {
+    if (parser->Failed) return false;
+    parser->Failed = true;
+    if (parser->Type == SQL_END) {
+        printf("Invalid statement: expected %s at end of statement.\n", expected);
+    } else {
+        printf("Invalid statement: expected %s near '%s'.\n", expected, parser->Token);
+    }
+    return false;
+}
+
+static bool ExpectKeyword(SqlParser *parser, const char *keyword) {
+    if (!IsKeyword(parser, keyword)) return SyntaxError(parser, keyword);
+    NextToken(parser);
+    return true;
+}
+
+static bool ExpectSymbol(SqlParser *parser, const char *symbol) {
+    if (!IsSymbol(parser, symbol)) {
+        char expected[8];
+        snprintf(expected, sizeof(expected), "'%s'", symbol);
+        return SyntaxError(parser, expected);
+    }
+    NextToken(parser);
+    return true;
+}
+
+// A table or column name: any word but a placeholder.
+static bool ReadName(SqlParser *parser, char *name, const char *what) {
+    if (parser->Type != SQL_WORD || strcmp(parser->Token, "?") == 0) return SyntaxError(parser, what);
+    strcpy(name, parser->Token);
+    NextToken(parser);
+    return true;
+}
+
+static bool ReadValue(SqlParser *parser, SqlValue *value) {
+    if (parser->Type != SQL_WORD) return SyntaxError(parser, "a value");
+    if (strcmp(parser->Token, "?") == 0) {
+        value->Text = NULL;
+        value->Parameter = parser->Parameters++;
+    } else {
+        value->Text = strdup(parser->Token);
+        value->Parameter = SIZE_MAX;
+        if (!value->Text) return false;
+    }
+    NextToken(parser);
+    return true;
+}
+
+static const char *ValueText(const SqlValue *value, const char *const *values) {
+    return value->Text ? value->Text : values[value->Parameter];
+}
+
+static Table *FindSessionTable(const SqlSession *session, const char *name) {
+    for (size_t i = 0; i < *session->TableCount; ++i) {
+        if (strcmp(session->Tables[i]->TableName, name) == 0) return session->Tables[i];
+    }
+    return NULL;
+}
+
+static bool ReadTable(SqlParser *parser, Statement *stmt) {
+    char name[MAX_SQL_TOKEN];
+    if (!ReadName(parser, name, "a table name")) return false;
+    stmt->Table = FindSessionTable(parser->Session, name);
+    if (!stmt->Table) {
+        printf("Table '%s' not found.\n", name);
+        parser->Failed = true;
+        return false;
+    }
+    return true;
+}
+
+static bool ReadColumn(SqlParser *parser, const Table *table, size_t *col) {
+    char name[MAX_SQL_TOKEN];
+    if (!ReadName(parser, name, "a column name")) return false;
+    int found = FindColumn(table, name);
+    if (found == -1) {
+        printf("Column '%s' not found in table '%s'.\n", name, table->TableName);
+        parser->Failed = true;
+        return false;
+    }
+    *col = (size_t)found;
+    return true;
+}
+
+// WHERE condition, up to the first of the stop keywords or the end of the statement.
+static bool ReadWhere(SqlParser *parser, Statement *stmt, const char *const *stops) {
+    if (!IsKeyword(parser, "WHERE")) return true;
+    NextToken(parser);
+
+    const char *start = parser->Start;
+    for (;;) {
+        bool stop = parser->Type == SQL_END;
+        for (size_t k = 0; !stop && stops[k]; ++k) stop = IsKeyword(parser, stops[k]);
+        if (stop) break;
+        NextToken(parser);
+    }
+    size_t len = (size_t)(parser->Start - start);
+    while (len > 0 && start[len - 1] == ' ') len--;
+
+    stmt->WhereText = malloc(len + 1);
+    if (!stmt->WhereText) return false;
+    memcpy(stmt->WhereText, start, len);
+    stmt->WhereText[len] = '\0';
+
+    stmt->Where = PrepareCondition(stmt->Table, stmt->WhereText, &parser->Parameters);
+    if (!stmt->Where) parser->Failed = true;
+    return stmt->Where != NULL;
+}
+
+static bool AllocColumns(Statement *stmt, size_t count) {
+    stmt->Columns = malloc(sizeof(size_t) * (count ? count : 1));
+    return stmt->Columns != NULL;
+}
+
+// * | column, ... up to FROM, resolved once the table is known.
+static bool ParseSelectList(SqlParser *parser, Statement *stmt) {
+    const Table *table = stmt->Table;
+    if (!AllocColumns(stmt, table->AttributeCount)) return false;
+    if (IsSymbol(parser, "*")) {
+        NextToken(parser);
+        for (size_t j = 0; j < table->AttributeCount; ++j) stmt->Columns[j] = j;
+        stmt->ColumnCount = table->AttributeCount;
+    } else {
+        for (;;) {
+            if (stmt->ColumnCount == table->AttributeCount) return SyntaxError(parser, "FROM");
+            if (!ReadColumn(parser, table, &stmt->Columns[stmt->ColumnCount++])) return false;
+            if (!IsSymbol(parser, ",")) break;
+            NextToken(parser);
+        }
+    }
+    return IsKeyword(parser, "FROM") || SyntaxError(parser, "',' or FROM");
+}
+
+// SELECT * | column, ... FROM table [WHERE condition] [ORDER BY column [ASC | DESC]]
+// [LIMIT n] [OFFSET m]
+static bool ParseSelect(SqlParser *parser, Statement *stmt) {
+    SqlParser columns = *parser;
+    while (parser->Type != SQL_END && !IsKeyword(parser, "FROM")) NextToken(parser);
+    if (!ExpectKeyword(parser, "FROM") || !ReadTable(parser, stmt)) return false;
+    if (!ParseSelectList(&columns, stmt)) {
+        parser->Failed = columns.Failed;
+        return false;
+    }
+
+    const Table *table = stmt->Table;
+
+    static const char *const stops[] = {"ORDER", "LIMIT", "OFFSET", NULL};
+    if (!ReadWhere(parser, stmt, stops)) return false;
+
+    if (IsKeyword(parser, "ORDER")) {
+        NextToken(parser);
+        if (!ExpectKeyword(parser, "BY") || !ReadColumn(parser, table, &stmt->Order.Column)) return false;
+        stmt->Ordered = true;
+        if (IsKeyword(parser, "ASC") || IsKeyword(parser, "DESC")) {
+            stmt->Order.Descending = IsKeyword(parser, "DESC");
+            NextToken(parser);
+        }
+    }
+    if (IsKeyword(parser, "LIMIT")) {
+        NextToken(parser);
+        if (!ReadValue(parser, &stmt->Limit)) return false;
+    }
+    if (IsKeyword(parser, "OFFSET")) {
+        NextToken(parser);
+        if (!ReadValue(parser, &stmt->Offset)) return false;
+    }
+    return true;
+}
+
+// INSERT INTO table [(column, ...)] VALUES (value, ...) [, (value, ...)]...
+static bool ParseInsert(SqlParser *parser, Statement *stmt) {
+    if (!ExpectKeyword(parser, "INTO") || !ReadTable(parser, stmt)) return false;
+
+    const Table *table = stmt->Table;
+    if (!AllocColumns(stmt, table->AttributeCount)) return false;
+    if (IsSymbol(parser, "(")) {
+        NextToken(parser);
+        for (;;) {
+            size_t col;
+            if (!ReadColumn(parser, table, &col)) return false;
+            for (size_t k = 0; k < stmt->ColumnCount; ++k) {
+                if (stmt->Columns[k] == col) {
+                    printf("Column '%s' is listed twice.\n", table->Attributes[col].AttributeName);
+                    parser->Failed = true;
+                    return false;
+                }
+            }
+            stmt->Columns[stmt->ColumnCount++] = col;
+            if (!IsSymbol(parser, ",")) break;
+            NextToken(parser);
+        }
+        if (!ExpectSymbol(parser, ")")) return false;
+        if (stmt->ColumnCount != table->AttributeCount) {
+            printf("INSERT must give a value for every column of '%s'.\n", table->TableName);
+            parser->Failed = true;
+            return false;
+        }
+    } else {
+        for (size_t j = 0; j < table->AttributeCount; ++j) stmt->Columns[j] = j;
+        stmt->ColumnCount = table->AttributeCount;
+    }
+
+    if (!ExpectKeyword(parser, "VALUES")) return false;
+    size_t capacity = 0;
+    do {
+        if (stmt->RowCount > 0) NextToken(parser);
+        if (!ExpectSymbol(parser, "(")) return false;
+        if (stmt->RowCount == capacity) {
+            capacity = capacity ? capacity * 2 : 4;
+            SqlValue *values = realloc(stmt->Values, sizeof(SqlValue) * capacity * stmt->ColumnCount);
+            if (!values) return false;
+            stmt->Values = values;
+        }
+        SqlValue *row = &stmt->Values[stmt->RowCount * stmt->ColumnCount];
+        for (size_t k = 0; k < stmt->ColumnCount; ++k) {
+            row[k].Text = NULL;
+            row[k].Parameter = SIZE_MAX;
+        }
+        stmt->RowCount++;
+        for (size_t k = 0; k < stmt->ColumnCount; ++k) {
+            if (k > 0 && !ExpectSymbol(parser, ",")) return false;
+            if (!ReadValue(parser, &row[k])) return false;
+        }
+        if (!ExpectSymbol(parser, ")")) return false;
+    } while (IsSymbol(parser, ","));
+    return true;
+}
+
+// UPDATE table SET column = value WHERE condition
+static bool ParseUpdate(SqlParser *parser, Statement *stmt) {
+    if (!ReadTable(parser, stmt) || !ExpectKeyword(parser, "SET") || !AllocColumns(stmt, 1) ||
+        !ReadColumn(parser, stmt->Table, &stmt->Columns[0]) || !ExpectSymbol(parser, "=")) {
+        return false;
+    }
+    stmt->ColumnCount = 1;
+    stmt->Values = calloc(1, sizeof(SqlValue));
+    if (!stmt->Values || !ReadValue(parser, &stmt->Values[0])) return false;
+    stmt->RowCount = 1;
+
+    static const char *const stops[] = {NULL};
+    if (!IsKeyword(parser, "WHERE")) return SyntaxError(parser, "WHERE");
+    return ReadWhere(parser, stmt, stops);
+}
+
+// DELETE FROM table WHERE condition
+static bool ParseDelete(SqlParser *parser, Statement *stmt) {
+    if (!ExpectKeyword(parser, "FROM") || !ReadTable(parser, stmt)) return false;
+    static const char *const stops[] = {NULL};
+    if (!IsKeyword(parser, "WHERE")) return SyntaxError(parser, "WHERE");
+    return ReadWhere(parser, stmt, stops);
+}
+
+static bool ReadType(SqlParser *parser, char **typeName) {
+    static const char *const types[] = {"INT", "UINT", "FLOAT", "STRING", "DICT"};
+    for (size_t k = 0; k < sizeof(types) / sizeof(*types); ++k) {
+        if (IsKeyword(parser, types[k])) {
+            *typeName = strdup(types[k]);
+            NextToken(parser);
+            return *typeName != NULL;
+        }
+    }
+    return SyntaxError(parser, "a type (INT, UINT, FLOAT, STRING, DICT)");
+}
+
+// CREATE TABLE name (column type, ...)
+static bool ParseCreate(SqlParser *parser, Statement *stmt) {
+    char name[MAX_SQL_TOKEN];
+    if (!ExpectKeyword(parser, "TABLE") || !ReadName(parser, name, "a table name") || !ExpectSymbol(parser, "(")) {
+        return false;
+    }
+    stmt->Name = strdup(name);
+    if (!stmt->Name) return false;
+
+    size_t capacity = 0;
+    for (;;) {
+        if (stmt->AttributeCount == capacity) {
+            capacity = capacity ? capacity * 2 : 8;
+            Attribute *attributes = realloc(stmt->Attributes, sizeof(Attribute) * capacity);
+            bool *interned = attributes ? realloc(stmt->Interned, sizeof(bool) * capacity) : NULL;
+            if (attributes) stmt->Attributes = attributes;
+            if (!interned) return false;
+            stmt->Interned = interned;
+        }
+
+        char *typeName = NULL;
+        if (!ReadName(parser, name, "a column name") || !ReadType(parser, &typeName)) return false;
+        Attribute *attribute = &stmt->Attributes[stmt->AttributeCount];
+        attribute->AttributeName = strdup(name);
+        attribute->AttributeType = strcmp(typeName, "INT") == 0 ? DT_INT : strcmp(typeName, "UINT") == 0 ? DT_UINT :
+                                   strcmp(typeName, "FLOAT") == 0 ? DT_FLOAT : DT_STRING;
+        stmt->Interned[stmt->AttributeCount] = strcmp(typeName, "DICT") == 0;
+        free(typeName);
+        if (!attribute->AttributeName) return false;
+        stmt->AttributeCount++;
+
+        if (!IsSymbol(parser, ",")) break;
+        NextToken(parser);
+    }
+    return ExpectSymbol(parser, ")");
+}
+
+// ALTER TABLE name ADD [COLUMN] column type | ALTER TABLE name DROP [COLUMN] column
+static bool ParseAlter(SqlParser *parser, Statement *stmt) {
+    if (!ExpectKeyword(parser, "TABLE") || !ReadTable(parser, stmt)) return false;
+
+    if (IsKeyword(parser, "ADD") || IsKeyword(parser, "DROP")) {
+        stmt->Kind = IsKeyword(parser, "ADD") ? SQL_ALTER_ADD : SQL_ALTER_DROP;
+        NextToken(parser);
+    } else {
+        return SyntaxError(parser, "ADD or DROP");
+    }
+    if (IsKeyword(parser, "COLUMN")) NextToken(parser);
+
+    char name[MAX_SQL_TOKEN];
+    if (!ReadName(parser, name, "a column name")) return false;
+    stmt->Name = strdup(name);
+    if (!stmt->Name) return false;
+    return stmt->Kind == SQL_ALTER_DROP || ReadType(parser, &stmt->TypeName);
+}
+
+static void FreeStatement(Statement *stmt) {
+    if (!stmt) return;
+    free(stmt->Text);
+    free(stmt->Columns);
+    FreeCondition(stmt->Where);
+    free(stmt->WhereText);
+    free(stmt->Limit.Text);
+    free(stmt->Offset.Text);
+    for (size_t i = 0; stmt->Values && i < stmt->RowCount * stmt->ColumnCount; ++i) free(stmt->Values[i].Text);
+    free(stmt->Values);
+    free(stmt->Name);
+    free(stmt->TypeName);
+    for (size_t j = 0; j < stmt->AttributeCount; ++j) free(stmt->Attributes[j].AttributeName);
+    free(stmt->Attributes);
+    free(stmt->Interned);
+    free(stmt);
+}
+
+static Statement *ParseStatement(SqlSession *session, const char *text) {
+    Statement *stmt = calloc(1, sizeof(Statement));
+    if (!stmt || !(stmt->Text = strdup(text))) {
+        printf("Out of memory parsing a statement.\n");
+        free(stmt);
+        return NULL;
+    }
+    stmt->Limit.Parameter = stmt->Offset.Parameter = SIZE_MAX;
+    stmt->Order.Limit = SIZE_MAX;
+
+    SqlParser parser = {0};
+    parser.Session = session;
+    parser.Cursor = stmt->Text;
+    NextToken(&parser);
+
+    bool ok;
+    if (IsKeyword(&parser, "SELECT")) {
+        stmt->Kind = SQL_SELECT;
+        NextToken(&parser);
+        ok = ParseSelect(&parser, stmt);
+    } else if (IsKeyword(&parser, "INSERT")) {
+        stmt->Kind = SQL_INSERT;
+        NextToken(&parser);
+        ok = ParseInsert(&parser, stmt);
+    } else if (IsKeyword(&parser, "UPDATE")) {
+        stmt->Kind = SQL_UPDATE;
+        NextToken(&parser);
+        ok = ParseUpdate(&parser, stmt);
+    } else if (IsKeyword(&parser, "DELETE")) {
+        stmt->Kind = SQL_DELETE;
+        NextToken(&parser);
+        ok = ParseDelete(&parser, stmt);
+    } else if (IsKeyword(&parser, "CREATE")) {
+        stmt->Kind = SQL_CREATE;
+        NextToken(&parser);
+        ok = ParseCreate(&parser, stmt);
+    } else if (IsKeyword(&parser, "ALTER")) {
+        NextToken(&parser);
+        ok = ParseAlter(&parser, stmt);
+    } else {
+        ok = SyntaxError(&parser, "SELECT, INSERT, UPDATE, DELETE, CREATE or ALTER");
+    }
+
+    if (ok && parser.Type != SQL_END) ok = SyntaxError(&parser, "end of statement");
+    if (!ok) {
+        if (!parser.Failed) printf("Out of memory parsing a statement.\n");
+        FreeStatement(stmt);
+        return NULL;
+    }
+    stmt->ParameterCount = parser.Parameters;
+    return stmt;
+}
+
+// A LIMIT or OFFSET: a whole number, or def when the clause is absent.
+static bool ReadCount(const SqlValue *value, const char *const *values, const char *clause, size_t def, size_t *count) {
+    if (!value->Text && value->Parameter == SIZE_MAX) {
+        *count = def;
+        return true;
+    }
+    const char *text = ValueText(value, values);
+    char *end;
+    if (!isdigit((unsigned char)*text) || (*count = (size_t)strtoull(text, &end, 10), *end != '\0')) {
+        printf("Invalid %s '%s': expected a row count.\n", clause, text);
+        return false;
+    }
+    return true;
+}
+
+static bool RunSelect(Statement *stmt, const char *const *values) {
+    Table *table = stmt->Table;
+    size_t limit, offset;
+    if (!ReadCount(&stmt->Limit, values, "LIMIT", SIZE_MAX, &limit) ||
+        !ReadCount(&stmt->Offset, values, "OFFSET", 0, &offset)) {
+        return false;
+    }
+
+    size_t *rows = NULL, count = 0;
+    if (stmt->Where) {
+        if (!BindCondition(table, stmt->Where, values)) return false;
+        count = EvaluateCondition(table, stmt->Where, &rows);
+        if (count == (size_t)-1) return false;
+    }
+    // No matches leave rows NULL, which SortRows would take for every row.
+    if (stmt->Ordered && (!stmt->Where || count > 0)) {
+        OrderBy order = stmt->Order;
+        order.Limit = limit;
+        order.Offset = offset;
+        size_t *sorted = SortRows(table, rows, count, &order, &count);
+        free(rows);
+        if (!sorted) return false;
+        rows = sorted;
+        limit = SIZE_MAX;
+        offset = 0;
+    }
+
+    ResultSet *result = stmt->Where || stmt->Ordered ? CreateResultSet(table, rows, count) : TableResultSet(table);
+    if (!result) return false;
+    memcpy(result->Columns, stmt->Columns, sizeof(size_t) * stmt->ColumnCount);
+    result->ColumnCount = stmt->ColumnCount;
+    ResultSetLimit(result, offset, limit);
+
+    size_t shown = RenderResultSet(result);
+    printf("%zu rows.\n", shown);
+    FreeResultSet(result);
+    return true;
+}
+
+// Checks that text converts to the column's type, converting numbers into cell.
+static bool ConvertValue(const Table *table, size_t col, const char *text, uint32_t *cell) {
+    bool ok;
+    switch (table->Attributes[col].AttributeType) {
+        case DT_INT: ok = ParseIntField(text, (int *)cell); break;
+        case DT_UINT: ok = ParseUintField(text, (unsigned int *)cell); break;
+        case DT_FLOAT: ok = ParseFloatField(text, (float *)cell); break;
+        default: return true;
+    }
+    if (!ok) {
+        printf("Invalid value '%s' for column '%s'.\n", text, table->Attributes[col].AttributeName);
+    }
+    return ok;
+}
+
+static bool RunInsert(Statement *stmt, const char *const *values) {
+    Table *table = stmt->Table;
+    size_t columns = stmt->ColumnCount;
+    uint32_t *cells = malloc(sizeof(uint32_t) * (columns ? columns : 1));
+    void **row = malloc(sizeof(void *) * (columns ? columns : 1));
+    bool ok = cells && row;
+
+    // Every row is checked before any is inserted, so a bad value inserts nothing.
+    for (size_t r = 0; ok && r < stmt->RowCount; ++r) {
+        for (size_t k = 0; ok && k < columns; ++k) {
+            ok = ConvertValue(table, stmt->Columns[k], ValueText(&stmt->Values[r * columns + k], values), &cells[0]);
+        }
+    }
+    bool checked = ok;
+
+    size_t inserted = 0;
+    for (size_t r = 0; ok && r < stmt->RowCount; ++r) {
+        for (size_t k = 0; k < columns; ++k) {
+            size_t col = stmt->Columns[k];
+            const char *text = ValueText(&stmt->Values[r * columns + k], values);
+            if (table->Attributes[col].AttributeType == DT_STRING) {
+                row[col] = (void *)text;
+            } else {
+                ConvertValue(table, col, text, &cells[col]);
+                row[col] = &cells[col];
+            }
+        }
+        ok = InsertRow(table, row);
+        inserted += ok;
+    }
+    if (checked) printf("%zu rows inserted.\n", inserted);
+
+    free(cells);
+    free(row);
+    return ok;
+}
+
+// The WHERE clause with its placeholders replaced by their values, quoted, as the log
+// records it for replay.
+static char *BindWhereText(const char *where, const char *const *values) {
+    size_t len = strlen(where) + 1, parameter = 0;
+    for (const char *p = where; *p; ++p) {
+        if (*p == '?' && (p == where || IsDelimiter(p[-1])) && IsDelimiter(p[1])) len += strlen(values[parameter++]) + 2;
+    }
+
+    char *text = malloc(len);
+    if (!text) return NULL;
+    char *out = text;
+    parameter = 0;
+    for (const char *p = where; *p; ++p) {
+        if (*p == '?' && (p == where || IsDelimiter(p[-1])) && IsDelimiter(p[1])) {
+            const char *value = values[parameter++];
+            char quote = strchr(value, '\'') ? '"' : '\'';
+            if (strchr(value, quote)) {
+                printf("Values cannot hold both kinds of quotes.\n");
+                free(text);
+                return NULL;
+            }
+            *out++ = quote;
+            out += sprintf(out, "%s", value);
+            *out++ = quote;
+        } else {
+            *out++ = *p;
+        }
+    }
+    *out = '\0';
+    return text;
+}
+
+// UPDATE and DELETE: binds the WHERE clause, finds its rows and changes them.
+static bool RunChange(Statement *stmt, const char *const *values) {
+    Table *table = stmt->Table;
+    const char *value = stmt->Kind == SQL_UPDATE ? ValueText(&stmt->Values[0], values) : NULL;
+    uint32_t cell;
+    if (value && !ConvertValue(table, stmt->Columns[0], value, &cell)) return false;
+
+    // WHERE placeholders are numbered after the SET value's.
+    char *where = BindWhereText(stmt->WhereText, values + (stmt->Kind == SQL_UPDATE && !stmt->Values[0].Text));
+    if (!where) return false;
+    if (!BindCondition(table, stmt->Where, values)) {
+        free(where);
+        return false;
+    }
+
+    size_t *rows;
+    size_t count = EvaluateCondition(table, stmt->Where, &rows);
+    if (count == (size_t)-1) {
+        free(where);
+        return false;
+    }
+    if (stmt->Kind == SQL_UPDATE) {
+        printf("%zu rows updated.\n", UpdateMatchedRows(table, stmt->Columns[0], value, rows, count, where));
+    } else {
+        printf("%zu rows deleted.\n", DeleteMatchedRows(table, rows, count, where));
+    }
+    free(where);
+    return true;
+}
+
+static bool RunCreate(SqlSession *session, Statement *stmt) {
+    if (FindSessionTable(session, stmt->Name)) {
+        printf("Table '%s' already exists.\n", stmt->Name);
+        return false;
+    }
+    if (*session->TableCount >= session->MaxTables) {
+        printf("Max table limit reached.\n");
+        return false;
+    }
+
+    Table *table = CreateTable(stmt->Name, stmt->Attributes, stmt->AttributeCount);
+    if (!table) {
+        printf("Table creation failed.\n");
+        return false;
+    }
+    for (size_t j = 0; j < stmt->AttributeCount; ++j) {
+        if (stmt->Interned[j] && !InternColumn(table, j)) {
+            FreeTable(table);
+            printf("Table creation failed.\n");
+            return false;
+        }
+    }
+    session->Tables[(*session->TableCount)++] = table;
+    printf("Table created successfully.\n");
+    return true;
+}
+
+static bool RunStatement(SqlSession *session, Statement *stmt, const char *const *values) {
+    switch (stmt->Kind) {
+        case SQL_SELECT: return RunSelect(stmt, values);
+        case SQL_INSERT: return RunInsert(stmt, values);
+        case SQL_UPDATE:
+        case SQL_DELETE: return RunChange(stmt, values);
+        case SQL_CREATE: return RunCreate(session, stmt);
+        case SQL_ALTER_ADD:
+            if (!AlterAddColumn(stmt->Table, stmt->Name, stmt->TypeName)) {
+                printf("Failed to add column.\n");
+                return false;
+            }
+            printf("Column added successfully.\n");
+            return true;
+        case SQL_ALTER_DROP:
+            if (!AlterDropColumn(stmt->Table, stmt->Name)) {
+                printf("Failed to drop column.\n");
+                return false;
+            }
+            printf("Column dropped successfully.\n");
+            return true;
+    }
+    return false;
+}
+
+void InitSqlSession(SqlSession *session, Table **tables, size_t *tableCount, size_t maxTables) {
+    memset(session, 0, sizeof(SqlSession));
+    session->Tables = tables;
+    session->TableCount = tableCount;
+    session->MaxTables = maxTables;
+}
+
+// Cached statements point at tables and columns, so the cache has to be cleared whenever a
+// table is added, dropped, reloaded or altered outside of SQL.
+void ClearStatementCache(SqlSession *session) {
+    for (size_t i = 0; i < session->CacheCount; ++i) FreeStatement(session->Cache[i]);
+    session->CacheCount = 0;
+}
+
+static Statement *FindStatement(SqlSession *session, const char *text, uint64_t hash) {
+    for (size_t i = 0; i < session->CacheCount; ++i) {
+        Statement *stmt = session->Cache[i];
+        if (stmt->Hash == hash && strcmp(stmt->Text, text) == 0) return stmt;
+    }
+    return NULL;
+}
+
+// Keeps stmt, evicting the least recently used statement once the cache is full.
+static void CacheStatement(SqlSession *session, Statement *stmt) {
+    if (session->CacheCount == STATEMENT_CACHE_SIZE) {
+        size_t oldest = 0;
+        for (size_t i = 1; i < session->CacheCount; ++i) {
+            if (session->Cache[i]->LastUsed < session->Cache[oldest]->LastUsed) oldest = i;
+        }
+        FreeStatement(session->Cache[oldest]);
+        session->Cache[oldest] = session->Cache[--session->CacheCount];
+    }
+    session->Cache[session->CacheCount++] = stmt;
+}
+
+// Runs one statement, its ? placeholders filled in order from parameters. Statements are
+// looked up by their normalized text, so one that differs from an earlier one only in its
+// values is neither parsed nor resolved again.
+bool ExecuteSql(SqlSession *session, const char *sql, const char *const *parameters, size_t parameterCount) {
+    NormalizedSql norm;
+    if (!Normalize(sql, parameters, parameterCount, &norm)) return false;
+    if (norm.Text[0] == '\0') {
+        FreeNormalized(&norm);
+        return true;
+    }
+
+    uint64_t hash = HashStatement(norm.Text);
+    Statement *stmt = FindStatement(session, norm.Text, hash);
+    bool cached = stmt != NULL;
+    if (cached) {
+        session->Hits++;
+    } else {
+        session->Misses++;
+        stmt = ParseStatement(session, norm.Text);
+    }
+
+    bool ok = false;
+    if (stmt) {
+        stmt->Hash = hash;
+        stmt->LastUsed = ++session->Clock;
+        ok = RunStatement(session, stmt, norm.Values);
+
+        bool schema = stmt->Kind == SQL_CREATE || stmt->Kind == SQL_ALTER_ADD || stmt->Kind == SQL_ALTER_DROP;
+        if (schema) {
+            FreeStatement(stmt);
+            ClearStatementCache(session);
+        } else if (!cached) {
+            CacheStatement(session, stmt);
+        }
+    }
+    FreeNormalized(&norm);
+    return ok;
+}
+
+// Runs the statements of text, separated by semicolons; -- starts a comment that runs to
+// the end of the line. Returns how many statements failed.
+size_t RunSqlText(SqlSession *session, const char *text) {
+    size_t len = strlen(text), failed = 0;
+    char *statement = malloc(len + 1);
+    if (!statement) {
+        printf("Out of memory reading statements.\n");
+        return 1;
+    }
+
+    size_t n = 0;
+    char quote = 0;
+    for (const char *p = text;; ++p) {
+        if (!quote && p[0] == '-' && p[1] == '-') {
+            while (*p && *p != '\n') p++;
+        }
+        if (*p == '\0' || (!quote && *p == ';')) {
+            statement[n] = '\0';
+            if (!ExecuteSql(session, statement, NULL, 0)) failed++;
+            n = 0;
+            if (*p == '\0') break;
+            continue;
+        }
+        if (quote ? *p == quote : (*p == '\'' || *p == '"')) quote = quote ? 0 : *p;
+        statement[n++] = *p;
+    }
+    free(statement);
+    return failed;
+}
+
+// Runs a script of statements read from file (or a pipe) to its end.
+size_t RunSqlScript(SqlSession *session, FILE *file) {
+    size_t size = 0, capacity = 64 * 1024;
+    char *text = malloc(capacity);
+    while (text) {
+        size += fread(text + size, 1, capacity - size - 1, file);
+        if (size < capacity - 1) break;
+        char *grown = realloc(text, capacity * 2);
+        if (!grown) {
+            free(text);
+            text = NULL;
+            break;
+        }
+        text = grown;
+        capacity *= 2;
+    }
+    if (!text) {
+        printf("Out of memory reading the script.\n");
+        return 1;
+    }
+
+    text[size] = '\0';
+    size_t failed = RunSqlText(session, text);
+    free(text);
+    return failed;
+}
@@ -0,0 +1,861 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <io.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#include "functions.h"
+#include "database.h"
+
+// .tbl version 2 layout:
+//
+//   header   magic "SDBTBL2\0", uint32 version, uint32 byte order marker
+//   schema   uint64 name length + name, uint64 column count, then per column
+//            uint64 name length + name and uint32 type
+//   columns  one contiguous section per column, starting on an 8-byte boundary. Plain INT/UINT/
+//            FLOAT sections are RowCount 4-byte values, plain STRING sections RowCount + 1 uint64
+//            offsets followed by every string with its NUL terminator. RLE, DELTA and BITPACK
+//            sections hold one encoded group per row group (see codec.c); DICT sections hold
+//            the entry count, entry offsets and entries like a plain string section, then one
+//            bit-packed group of entry codes per row group
+//   zones    the zone map block (see WriteZoneMaps)
+//   footer   uint64 row count, rows per group, group count, column count, schema offset and
+//            zone offset, then per column uint32 type, uint32 encoding, uint64 section offset
+//            and length and one uint64 offset per row group, relative to the section
+//   tail     uint64 footer offset, magic
+//
+// Values are written in the writer's byte order, which the marker records; readers on the
+// other order swap them. Same-order files are mapped read-only: numeric sections become the
+// column arrays and string sections arena chunks, so nothing is copied until it is written.
+// Otherwise every section is read with one call.
+static const char TableMagic[8] = {'S', 'D', 'B', 'T', 'B', 'L', '2', '\0'};
+
+#define TABLE_FILE_VERSION  2
+#define BYTE_ORDER_MARK     0x01020304u
+
+typedef struct {
+    uint32_t Type;
+    uint32_t Encoding;
+    uint64_t Offset;
+    uint64_t Length;
+    uint64_t *GroupOffsets;
+} SectionInfo;
+
+static uint32_t Swap32(uint32_t v) {
+    return (v >> 24) | ((v >> 8) & 0xFF00u) | ((v << 8) & 0xFF0000u) | (v << 24);
+}
+
+static uint64_t Swap64(uint64_t v) {
+    return ((uint64_t)Swap32((uint32_t)v) << 32) | Swap32((uint32_t)(v >> 32));
+}
+
+// Everything is staged in WRITE_BLOCK_BYTES blocks and handed to an unbuffered FILE, so each
+// full block is one write call at a block-aligned offset; payloads of whole blocks skip the copy.
+#define WRITE_BLOCK_BYTES (1 << 20)
+
+typedef struct {
+    FILE *File;
+    unsigned char *Block;
+    size_t Used;
+    uint64_t Written;
+    bool Failed;
+} BlockWriter;
+
+static void FlushBlock(BlockWriter *writer) {
+    if (writer->Used && !writer->Failed && fwrite(writer->Block, 1, writer->Used, writer->File) != writer->Used) {
+        writer->Failed = true;
+    }
+    writer->Written += writer->Used;
+    writer->Used = 0;
+}
+
+static void Put(BlockWriter *writer, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    while (size > 0) {
+        if (writer->Used == 0 && size >= WRITE_BLOCK_BYTES) {
+            size_t direct = size - size % WRITE_BLOCK_BYTES;
+            if (!writer->Failed && fwrite(bytes, 1, direct, writer->File) != direct) writer->Failed = true;
+            writer->Written += direct;
+            bytes += direct;
+            size -= direct;
+            continue;
+        }
+
+        size_t n = WRITE_BLOCK_BYTES - writer->Used < size ? WRITE_BLOCK_BYTES - writer->Used : size;
+        memcpy(writer->Block + writer->Used, bytes, n);
+        writer->Used += n;
+        bytes += n;
+        size -= n;
+        if (writer->Used == WRITE_BLOCK_BYTES) FlushBlock(writer);
+    }
+}
+
+static uint64_t Position(const BlockWriter *writer) {
+    return writer->Written + writer->Used;
+}
+
+static void WriteU32(BlockWriter *writer, uint32_t value) {
+    Put(writer, &value, sizeof(value));
+}
+
+static void WriteU64(BlockWriter *writer, uint64_t value) {
+    Put(writer, &value, sizeof(value));
+}
+
+static void WriteName(BlockWriter *writer, const char *name) {
+    size_t len = strlen(name);
+    WriteU64(writer, len);
+    Put(writer, name, len);
+}
+
+static size_t GroupCount(size_t rows) {
+    return (rows + ZONE_ROWS - 1) / ZONE_ROWS;
+}
+
+// Sections start 8-byte aligned so mapped columns can be used in place.
+static void PadSection(BlockWriter *writer) {
+    static const char zeros[8] = {0};
+    uint64_t pos = Position(writer);
+    if (pos % 8) Put(writer, zeros, (size_t)(8 - pos % 8));
+}
+
+static size_t GroupRows(size_t rows, size_t group) {
+    size_t begin = group * ZONE_ROWS;
+    return rows - begin < ZONE_ROWS ? rows - begin : ZONE_ROWS;
+}
+
+// Writes each row group of values in the given encoding, recording where the groups start.
+static bool WriteEncodedGroups(BlockWriter *writer, ColumnEncoding encoding, DataTypes type,
+                               const uint32_t *values, size_t rows, uint64_t sectionOffset, uint64_t *groupOffsets) {
+    unsigned char *buffer = malloc(CODEC_GROUP_BOUND(ZONE_ROWS));
+    if (!buffer) return false;
+
+    for (size_t g = 0; g < GroupCount(rows); ++g) {
+        groupOffsets[g] = Position(writer) - sectionOffset;
+        Put(writer, buffer, EncodeNumericGroup(encoding, type, values + g * ZONE_ROWS, GroupRows(rows, g), buffer));
+    }
+    free(buffer);
+    return true;
+}
+
+static bool WriteStringSection(const Table *table, size_t col, BlockWriter *writer, SectionInfo *info) {
+    size_t rows = table->RowCount;
+    uint64_t *offsets = malloc(sizeof(uint64_t) * (rows + 1));
+    if (!offsets) return false;
+
+    offsets[0] = 0;
+    for (size_t i = 0; i < rows; ++i) offsets[i + 1] = offsets[i] + strlen(GetCell(table, col, i)) + 1;
+    Put(writer, offsets, sizeof(uint64_t) * (rows + 1));
+
+    // Group boundaries point into the blob, after the offsets array.
+    uint64_t blobStart = sizeof(uint64_t) * (rows + 1);
+    for (size_t g = 0; g < GroupCount(rows); ++g) info->GroupOffsets[g] = blobStart + offsets[g * ZONE_ROWS];
+
+    for (size_t i = 0; i < rows; ++i) {
+        Put(writer, GetCell(table, col, i), (size_t)(offsets[i + 1] - offsets[i]));
+    }
+    free(offsets);
+    return true;
+}
+
+static bool WriteDictionarySection(const StringDictionary *dict, size_t rows, BlockWriter *writer, SectionInfo *info) {
+    uint64_t *offsets = malloc(sizeof(uint64_t) * (dict->Count + 1));
+    if (!offsets) return false;
+
+    offsets[0] = 0;
+    for (size_t e = 0; e < dict->Count; ++e) offsets[e + 1] = offsets[e] + strlen(dict->Entries[e]) + 1;
+    WriteU64(writer, dict->Count);
+    Put(writer, offsets, sizeof(uint64_t) * (dict->Count + 1));
+    for (size_t e = 0; e < dict->Count; ++e) Put(writer, dict->Entries[e], (size_t)(offsets[e + 1] - offsets[e]));
+    free(offsets);
+
+    PadSection(writer);
+    return WriteEncodedGroups(writer, ENCODING_BITPACK, DT_UINT, dict->Codes, rows, info->Offset, info->GroupOffsets);
+}
+
+// Interned columns are always written with their own dictionary, so they load interned again.
+static bool WriteInternedSection(const Table *table, size_t col, BlockWriter *writer, SectionInfo *info) {
+    const ColumnDictionary *columnDict = table->Columns[col].Dict;
+    StringDictionary dict = {NULL, columnDict->Count, table->Columns[col].Values};
+    dict.Entries = malloc(sizeof(const char *) * (dict.Count ? dict.Count : 1));
+    if (!dict.Entries) return false;
+
+    for (size_t e = 0; e < dict.Count; ++e) dict.Entries[e] = DictionaryString(table, col, (uint32_t)e);
+    bool ok = WriteDictionarySection(&dict, table->RowCount, writer, info);
+    free(dict.Entries);
+    return ok;
+}
+
+// Writes one column section in the encoding that suits it best and fills in where it and each
+// of its row groups start.
+static bool WriteColumnSection(const Table *table, size_t col, BlockWriter *writer, SectionInfo *info) {
+    size_t rows = table->RowCount, groups = GroupCount(rows);
+    DataTypes type = table->Attributes[col].AttributeType;
+
+    PadSection(writer);
+    info->Type = type;
+    info->Encoding = ENCODING_PLAIN;
+    info->Offset = Position(writer);
+    info->GroupOffsets = malloc(sizeof(uint64_t) * (groups ? groups : 1));
+    if (!info->GroupOffsets) return false;
+
+    bool ok;
+    if (type != DT_STRING) {
+        const uint32_t *values = table->Columns[col].Values;
+        info->Encoding = ChooseNumericEncoding(type, values, rows);
+        if (info->Encoding == ENCODING_PLAIN) {
+            Put(writer, values, sizeof(uint32_t) * rows);
+            for (size_t g = 0; g < groups; ++g) info->GroupOffsets[g] = (uint64_t)g * ZONE_ROWS * sizeof(uint32_t);
+            ok = true;
+        } else {
+            ok = WriteEncodedGroups(writer, info->Encoding, type, values, rows, info->Offset, info->GroupOffsets);
+        }
+    } else if (table->Columns[col].Dict) {
+        info->Encoding = ENCODING_DICT;
+        ok = WriteInternedSection(table, col, writer, info);
+    } else {
+        StringDictionary dict;
+        if (BuildStringDictionary(table, col, &dict)) {
+            if (DictionaryPaysOff(&dict, table, col)) info->Encoding = ENCODING_DICT;
+            ok = info->Encoding == ENCODING_DICT ? WriteDictionarySection(&dict, rows, writer, info)
+                                                 : WriteStringSection(table, col, writer, info);
+            FreeStringDictionary(&dict);
+        } else {
+            ok = WriteStringSection(table, col, writer, info);
+        }
+    }
+
+    info->Length = Position(writer) - info->Offset;
+    return ok;
+}
+
+static bool WriteTableFile(const Table *table, BlockWriter *writer) {
+    size_t groups = GroupCount(table->RowCount);
+    SectionInfo *sections = calloc(table->AttributeCount ? table->AttributeCount : 1, sizeof(SectionInfo));
+    if (!sections) return false;
+
+    Put(writer, TableMagic, sizeof(TableMagic));
+    WriteU32(writer, TABLE_FILE_VERSION);
+    WriteU32(writer, BYTE_ORDER_MARK);
+
+    uint64_t schemaOffset = Position(writer);
+    WriteName(writer, table->TableName);
+    WriteU64(writer, table->AttributeCount);
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        WriteName(writer, table->Attributes[j].AttributeName);
+        WriteU32(writer, (uint32_t)table->Attributes[j].AttributeType);
+    }
+
+    bool ok = true;
+    for (size_t j = 0; j < table->AttributeCount && ok; ++j) {
+        ok = WriteColumnSection(table, j, writer, &sections[j]);
+    }
+
+    if (ok) {
+        // Zone maps are written by zonemap.c straight to the file.
+        FlushBlock(writer);
+        uint64_t zoneOffset = Position(writer);
+        WriteZoneMaps(table, writer->File);
+        writer->Written = (uint64_t)FILE_TELL(writer->File);
+
+        uint64_t footerOffset = Position(writer);
+        WriteU64(writer, table->RowCount);
+        WriteU64(writer, ZONE_ROWS);
+        WriteU64(writer, groups);
+        WriteU64(writer, table->AttributeCount);
+        WriteU64(writer, schemaOffset);
+        WriteU64(writer, zoneOffset);
+        for (size_t j = 0; j < table->AttributeCount; ++j) {
+            WriteU32(writer, sections[j].Type);
+            WriteU32(writer, sections[j].Encoding);
+            WriteU64(writer, sections[j].Offset);
+            WriteU64(writer, sections[j].Length);
+            Put(writer, sections[j].GroupOffsets, sizeof(uint64_t) * groups);
+        }
+
+        WriteU64(writer, footerOffset);
+        Put(writer, TableMagic, sizeof(TableMagic));
+        FlushBlock(writer);
+        ok = !writer->Failed && !ferror(writer->File);
+    }
+
+    for (size_t j = 0; j < table->AttributeCount; ++j) free(sections[j].GroupOffsets);
+    free(sections);
+    return ok;
+}
+
+static bool AtomicSaves = true;
+
+// Whether saves go through a synced temp file and a rename; on by default.
+void SetAtomicSaves(bool enabled) {
+    AtomicSaves = enabled;
+}
+
+static bool SyncFile(FILE *file) {
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+static bool ReplaceFile(const char *from, const char *to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+// Writes the table to path. Atomic saves write path.tmp, flush it to disk and rename it over
+// path, so a crash mid-save leaves the previous file intact. fileBytes gets the file size.
+// The file being replaced may be the one the table is mapped from, which Windows refuses to
+// replace and POSIX turns into SIGBUS if truncated, so the mapping is released only once the
+// rows are safely in the temp file (or before an in-place save opens path).
+bool SaveTableFile(Table *table, const char *path, uint64_t *fileBytes) {
+    char tempPath[272];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    const char *target = AtomicSaves ? tempPath : path;
+
+    if (!AtomicSaves && !ReleaseTableMapping(table)) return false;
+
+    BlockWriter writer = {NULL, malloc(WRITE_BLOCK_BYTES), 0, 0, false};
+    if (!writer.Block) return false;
+
+    writer.File = fopen(target, "wb");
+    if (!writer.File) {
+        perror("Failed to open file for writing");
+        free(writer.Block);
+        return false;
+    }
+    setvbuf(writer.File, NULL, _IONBF, 0);
+
+    bool ok = WriteTableFile(table, &writer);
+    *fileBytes = Position(&writer);
+    if (ok && AtomicSaves) ok = SyncFile(writer.File);
+    if (fclose(writer.File) != 0) ok = false;
+    free(writer.Block);
+
+    if (ok && AtomicSaves) ok = ReleaseTableMapping(table) && ReplaceFile(tempPath, path);
+    if (!ok && AtomicSaves) remove(tempPath);
+    return ok;
+}
+
+bool IsTableFileV2(FILE *file) {
+    char magic[sizeof(TableMagic)];
+    int64_t start = FILE_TELL(file);
+    bool match = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, TableMagic, sizeof(magic)) == 0;
+    FILE_SEEK(file, start, SEEK_SET);
+    return match;
+}
+
+static bool EncodingFits(uint32_t encoding, uint32_t type) {
+    switch (encoding) {
+        case ENCODING_PLAIN: return true;
+        case ENCODING_RLE: return type != DT_STRING;
+        case ENCODING_DELTA:
+        case ENCODING_BITPACK: return type == DT_INT || type == DT_UINT;
+        case ENCODING_DICT: return type == DT_STRING;
+        default: return false;
+    }
+}
+
+// Bounds-checked reads from an in-memory copy of the footer or schema.
+typedef struct {
+    const unsigned char *Data;
+    size_t Size;
+    size_t Pos;
+    bool Swap;
+    bool Failed;
+} Reader;
+
+static bool ReadBytes(Reader *reader, void *out, size_t size) {
+    if (reader->Failed || reader->Size - reader->Pos < size) {
+        reader->Failed = true;
+        memset(out, 0, size);
+        return false;
+    }
+    memcpy(out, reader->Data + reader->Pos, size);
+    reader->Pos += size;
+    return true;
+}
+
+static uint32_t ReadU32(Reader *reader) {
+    uint32_t value;
+    ReadBytes(reader, &value, sizeof(value));
+    return reader->Swap ? Swap32(value) : value;
+}
+
+static uint64_t ReadU64(Reader *reader) {
+    uint64_t value;
+    ReadBytes(reader, &value, sizeof(value));
+    return reader->Swap ? Swap64(value) : value;
+}
+
+static char *ReadName(Reader *reader) {
+    uint64_t len = ReadU64(reader);
+    if (reader->Failed || len > reader->Size - reader->Pos) {
+        reader->Failed = true;
+        return NULL;
+    }
+    char *name = malloc(len + 1);
+    if (!name) return NULL;
+    ReadBytes(reader, name, len);
+    name[len] = '\0';
+    return name;
+}
+
+static unsigned char *ReadRange(FILE *file, uint64_t offset, uint64_t size) {
+    unsigned char *data = malloc(size ? size : 1);
+    if (!data) return NULL;
+    if (FILE_SEEK(file, offset, SEEK_SET) != 0 || fread(data, 1, size, file) != size) {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+typedef struct {
+    const SectionInfo *Info;
+    const unsigned char *Section;
+    ColumnEncoding Encoding;
+    DataTypes Type;
+    uint32_t *Values;
+    size_t Rows;
+    atomic_bool Failed;
+} DecodeJob;
+
+// Bytes of the section holding group g, given the groups start in order.
+static bool GroupBounds(const SectionInfo *info, size_t groups, size_t g, uint64_t *begin, uint64_t *size) {
+    uint64_t end = g + 1 < groups ? info->GroupOffsets[g + 1] : info->Length;
+    *begin = info->GroupOffsets[g];
+    *size = end - *begin;
+    return *begin <= end && end <= info->Length;
+}
+
+static void DecodeGroupTask(void *context, size_t worker, size_t g) {
+    (void)worker;
+    DecodeJob *job = context;
+    uint64_t begin, size;
+    if (!GroupBounds(job->Info, GroupCount(job->Rows), g, &begin, &size) ||
+        !DecodeNumericGroup(job->Encoding, job->Type, job->Section + begin, (size_t)size,
+                            job->Values + g * ZONE_ROWS, GroupRows(job->Rows, g))) {
+        atomic_store(&job->Failed, true);
+    }
+}
+
+// Decodes every group of an encoded section into values; large columns are spread over the
+// scan threads since groups are independent.
+static bool DecodeGroups(const SectionInfo *info, const unsigned char *section, ColumnEncoding encoding,
+                         DataTypes type, uint32_t *values, size_t rows) {
+    DecodeJob job = {info, section, encoding, type, values, rows, false};
+    size_t groups = GroupCount(rows);
+    if (rows >= PARALLEL_MIN_ROWS) {
+        ParallelFor(groups, DecodeGroupTask, &job);
+    } else {
+        for (size_t g = 0; g < groups; ++g) DecodeGroupTask(&job, 0, g);
+    }
+    return !atomic_load(&job.Failed);
+}
+
+// Loads a DICT section into an interned column. Entries are checked once and then borrowed
+// from the mapping, or copied when the section was read; rows keep the stored codes.
+static bool DecodeDictionary(Table *table, size_t col, const SectionInfo *info, const unsigned char *section,
+                             bool swap, bool mapped) {
+    size_t rows = table->RowCount;
+    uint64_t count;
+    if (info->Length < sizeof(uint64_t)) return false;
+    memcpy(&count, section, sizeof(count));
+    if (swap) count = Swap64(count);
+    if (count > info->Length / sizeof(uint64_t)) return false;
+
+    uint64_t blobStart = sizeof(uint64_t) * (count + 2);
+    const uint64_t *stored = (const uint64_t *)(section + sizeof(uint64_t));
+    uint64_t *offsets = malloc(sizeof(uint64_t) * (count + 1));
+    bool ok = offsets && blobStart <= info->Length;
+
+    for (uint64_t e = 0; ok && e <= count; ++e) {
+        offsets[e] = swap ? Swap64(stored[e]) : stored[e];
+        ok = blobStart + offsets[e] <= info->Length && (e == 0 || offsets[e] > offsets[e - 1]);
+        if (ok && e > 0) ok = section[blobStart + offsets[e] - 1] == '\0';
+    }
+
+    size_t chunk = 0;
+    if (ok && mapped && count > 0) {
+        ok = ArenaBorrowChunk(&table->Strings, (char *)section + blobStart, (size_t)offsets[count], &chunk);
+    }
+    for (uint64_t e = 0; ok && e < count; ++e) {
+        StringRef ref = ((StringRef)chunk << ARENA_OFFSET_BITS) | offsets[e];
+        uint32_t code;
+        if (!mapped) {
+            ok = ArenaStoreString(&table->Strings, (const char *)section + blobStart + offsets[e],
+                                  (size_t)(offsets[e + 1] - offsets[e] - 1), &ref);
+        }
+        ok = ok && AddDictionaryEntry(table, col, ref, &code);
+    }
+
+    uint32_t *codes = table->Columns[col].Values;
+    ok = ok && DecodeGroups(info, section, ENCODING_BITPACK, DT_UINT, codes, rows);
+    for (size_t i = 0; ok && i < rows; ++i) ok = codes[i] < count;
+
+    free(offsets);
+    return ok;
+}
+
+// Fills a column from an encoded section held in memory, mapped or read.
+static bool DecodeSection(Table *table, size_t col, const SectionInfo *info, const unsigned char *section, bool swap,
+                          bool mapped) {
+    if (info->Encoding == ENCODING_DICT) return DecodeDictionary(table, col, info, section, swap, mapped);
+    return DecodeGroups(info, section, (ColumnEncoding)info->Encoding, (DataTypes)info->Type, table->Columns[col].Values, table->RowCount);
+}
+
+static bool ReadColumnSection(Table *table, size_t col, FILE *file, const SectionInfo *info, bool swap) {
+    size_t rows = table->RowCount;
+
+    if (info->Encoding != ENCODING_PLAIN) {
+        unsigned char *section = ReadRange(file, info->Offset, info->Length);
+        bool ok = section && DecodeSection(table, col, info, section, swap, false);
+        free(section);
+        return ok;
+    }
+
+    if (info->Type != DT_STRING) {
+        if (info->Length != (uint64_t)rows * sizeof(uint32_t)) return false;
+        if (FILE_SEEK(file, info->Offset, SEEK_SET) != 0) return false;
+        uint32_t *values = table->Columns[col].Values;
+        if (fread(values, sizeof(uint32_t), rows, file) != rows) return false;
+        if (swap) {
+            for (size_t i = 0; i < rows; ++i) values[i] = Swap32(values[i]);
+        }
+        return true;
+    }
+
+    uint64_t offsetsSize = sizeof(uint64_t) * ((uint64_t)rows + 1);
+    if (info->Length < offsetsSize) return false;
+    unsigned char *section = ReadRange(file, info->Offset, info->Length);
+    if (!section) return false;
+
+    uint64_t *offsets = (uint64_t *)section;
+    const char *blob = (const char *)section + offsetsSize;
+    uint64_t blobSize = info->Length - offsetsSize;
+    StringRef *refs = table->Columns[col].Values;
+
+    bool ok = true;
+    for (size_t i = 0; i < rows && ok; ++i) {
+        uint64_t begin = swap ? Swap64(offsets[i]) : offsets[i];
+        uint64_t end = swap ? Swap64(offsets[i + 1]) : offsets[i + 1];
+        if (begin >= end || end > blobSize) {
+            ok = false;
+            break;
+        }
+        char *dest = ArenaAllocString(&table->Strings, (size_t)(end - begin - 1), &refs[i]);
+        if (dest) {
+            memcpy(dest, blob + begin, (size_t)(end - begin - 1));
+        } else {
+            ok = false;
+        }
+    }
+    free(section);
+    return ok;
+}
+
+static bool MappedLoads = true;
+
+// Whether same-order v2 files are mapped rather than read on load; on by default.
+void SetMappedLoads(bool enabled) {
+    MappedLoads = enabled;
+}
+
+struct TableMapping {
+    unsigned char *Data;
+    size_t Size;
+#ifdef _WIN32
+    HANDLE Map;
+#endif
+};
+
+// Maps the whole file read-only and shared, so tables opened by several clients share the
+// page cache. The mapping outlives the FILE.
+static TableMapping *MapTableFile(FILE *file, size_t size) {
+    TableMapping *mapping = malloc(sizeof(TableMapping));
+    if (!mapping) return NULL;
+    mapping->Size = size;
+
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    mapping->Map = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    mapping->Data = mapping->Map ? MapViewOfFile(mapping->Map, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!mapping->Data) {
+        if (mapping->Map) CloseHandle(mapping->Map);
+        free(mapping);
+        return NULL;
+    }
+#else
+    void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fileno(file), 0);
+    if (data == MAP_FAILED) {
+        free(mapping);
+        return NULL;
+    }
+    mapping->Data = data;
+#endif
+    return mapping;
+}
+
+void UnmapTableFile(TableMapping *mapping) {
+    if (!mapping) return;
+#ifdef _WIN32
+    UnmapViewOfFile(mapping->Data);
+    CloseHandle(mapping->Map);
+#else
+    munmap(mapping->Data, mapping->Size);
+#endif
+    free(mapping);
+}
+
+// Points the columns of an empty table at their sections in the mapping. String sections must
+// end in a NUL so no string can run past its blob, and their offsets are checked while the refs
+// are built; the strings themselves are not touched.
+static bool MapColumnSections(Table *table, size_t rows, const SectionInfo *sections, TableMapping *mapping) {
+    void **values = calloc(table->AttributeCount ? table->AttributeCount : 1, sizeof(void *));
+    if (!values) {
+        UnmapTableFile(mapping);
+        return false;
+    }
+
+    bool ok = true;
+    uint64_t offsetsSize = sizeof(uint64_t) * ((uint64_t)rows + 1);
+    for (size_t j = 0; j < table->AttributeCount && ok; ++j) {
+        const SectionInfo *info = &sections[j];
+        const unsigned char *section = mapping->Data + info->Offset;
+        if (info->Offset % 8 != 0) {
+            ok = false;
+        } else if (info->Encoding != ENCODING_PLAIN) {
+            values[j] = NULL;  // decoded into memory of its own
+        } else if (info->Type != DT_STRING) {
+            ok = info->Length == (uint64_t)rows * sizeof(uint32_t);
+            values[j] = (void *)section;
+        } else {
+            ok = info->Length > offsetsSize && section[info->Length - 1] == '\0';
+        }
+    }
+
+    table->Mapping = mapping;
+    ok = ok && AttachMappedColumns(table, rows, values);
+    free(values);
+    if (!ok) return false;
+    table->RowCount = rows;
+
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        const SectionInfo *info = &sections[j];
+        if (info->Encoding != ENCODING_PLAIN) {
+            if (!DecodeSection(table, j, info, mapping->Data + info->Offset, false, true)) return false;
+            continue;
+        }
+        if (info->Type != DT_STRING) continue;
+
+        const uint64_t *offsets = (const uint64_t *)(mapping->Data + info->Offset);
+        uint64_t blobSize = info->Length - offsetsSize;
+        size_t chunk;
+        if (!ArenaBorrowChunk(&table->Strings, (char *)mapping->Data + info->Offset + offsetsSize, blobSize, &chunk)) return false;
+
+        StringRef *refs = table->Columns[j].Values;
+        for (size_t i = 0; i < rows; ++i) {
+            if (offsets[i] >= offsets[i + 1] || offsets[i + 1] > blobSize) return false;
+            refs[i] = ((StringRef)chunk << ARENA_OFFSET_BITS) | offsets[i];
+        }
+    }
+    return true;
+}
+
+// Points a table just saved to path at the new file, so its columns are read from a mapping
+// again rather than from the copies made to replace the old one. Best effort: if the file
+// cannot be mapped or does not match, the table keeps its own memory.
+void RemapTableFile(Table *table, const char *path) {
+    if (!MappedLoads || table->Mapping || table->RowCount == 0 || table->DeletedCount > 0) return;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return;
+    uint64_t fileBytes;
+    Table *saved = IsTableFileV2(file) ? ReadTableFile(file, &fileBytes) : NULL;
+    fclose(file);
+    if (!saved) return;
+
+    bool fits = saved->Mapping && saved->RowCount == table->RowCount && saved->AttributeCount == table->AttributeCount;
+    for (size_t j = 0; fits && j < table->AttributeCount; ++j) {
+        fits = saved->Attributes[j].AttributeType == table->Attributes[j].AttributeType;
+    }
+
+    // Values, dictionaries, zone maps and the arena they refer to move over together; the
+    // indexes key on row ids, which the save kept.
+    if (fits) {
+        for (size_t j = 0; j < table->AttributeCount; ++j) {
+            Column *live = &table->Columns[j], *mapped = &saved->Columns[j];
+            Column kept = *live;
+            live->Values = mapped->Values;
+            live->Mapped = mapped->Mapped;
+            live->Dict = mapped->Dict;
+            live->Zones = mapped->Zones;
+            mapped->Values = kept.Values;
+            mapped->Mapped = kept.Mapped;
+            mapped->Dict = kept.Dict;
+            mapped->Zones = kept.Zones;
+        }
+        Arena strings = table->Strings;
+        table->Strings = saved->Strings;
+        saved->Strings = strings;
+
+        size_t capacity = table->RowCapacity;
+        table->RowCapacity = saved->RowCapacity;
+        saved->RowCapacity = capacity;
+        table->Mapping = saved->Mapping;
+        saved->Mapping = NULL;
+    }
+    FreeTable(saved);
+}
+
+// Reads a v2 table. The schema and footer are parsed from memory, then the column sections
+// are mapped, or pulled in with a single read each. Returns NULL with a message on a damaged file.
+Table *ReadTableFile(FILE *file, uint64_t *fileBytes) {
+    unsigned char header[16];
+    if (FILE_SEEK(file, 0, SEEK_END) != 0) return NULL;
+    int64_t size = FILE_TELL(file);
+    if (size < (int64_t)(sizeof(header) + 16) || FILE_SEEK(file, 0, SEEK_SET) != 0 ||
+        fread(header, sizeof(header), 1, file) != 1) {
+        printf("Table file is truncated.\n");
+        return NULL;
+    }
+
+    Reader headerReader = {header, sizeof(header), sizeof(TableMagic), false, false};
+    uint32_t version = ReadU32(&headerReader);
+    uint32_t marker = ReadU32(&headerReader);
+    bool swap = marker == Swap32(BYTE_ORDER_MARK);
+    if (swap) version = Swap32(version);
+    if (version != TABLE_FILE_VERSION || (marker != BYTE_ORDER_MARK && !swap)) {
+        printf("Unsupported table file version %u.\n", version);
+        return NULL;
+    }
+
+    unsigned char tail[16];
+    if (FILE_SEEK(file, size - (int64_t)sizeof(tail), SEEK_SET) != 0 || fread(tail, sizeof(tail), 1, file) != 1 ||
+        memcmp(tail + 8, TableMagic, sizeof(TableMagic)) != 0) {
+        printf("Table file is missing its footer.\n");
+        return NULL;
+    }
+    Reader tailReader = {tail, sizeof(tail), 0, swap, false};
+    uint64_t footerOffset = ReadU64(&tailReader);
+    if (footerOffset >= (uint64_t)size - sizeof(tail)) {
+        printf("Table file footer is damaged.\n");
+        return NULL;
+    }
+
+    uint64_t footerSize = (uint64_t)size - sizeof(tail) - footerOffset;
+    unsigned char *footerData = ReadRange(file, footerOffset, footerSize);
+    if (!footerData) return NULL;
+
+    Reader footer = {footerData, footerSize, 0, swap, false};
+    uint64_t rowCount = ReadU64(&footer);
+    uint64_t groupRows = ReadU64(&footer);
+    uint64_t groups = ReadU64(&footer);
+    uint64_t columnCount = ReadU64(&footer);
+    uint64_t schemaOffset = ReadU64(&footer);
+    uint64_t zoneOffset = ReadU64(&footer);
+
+    if (footer.Failed || groupRows == 0 || groups != (rowCount + groupRows - 1) / groupRows ||
+        schemaOffset >= footerOffset || columnCount > footerSize || groups > footerSize / sizeof(uint64_t)) {
+        printf("Table file footer is damaged.\n");
+        free(footerData);
+        return NULL;
+    }
+
+    // Schema: read the whole region between header and first section in one go.
+    unsigned char *schemaData = ReadRange(file, schemaOffset, footerOffset - schemaOffset);
+    Reader schema = {schemaData, schemaData ? footerOffset - schemaOffset : 0, 0, swap, !schemaData};
+    char *tableName = ReadName(&schema);
+    uint64_t schemaColumns = ReadU64(&schema);
+
+    Attribute *attributes = calloc(columnCount ? columnCount : 1, sizeof(Attribute));
+    SectionInfo *sections = calloc(columnCount ? columnCount : 1, sizeof(SectionInfo));
+    bool ok = tableName && attributes && sections && schemaColumns == columnCount;
+
+    for (size_t j = 0; ok && j < columnCount; ++j) {
+        attributes[j].AttributeName = ReadName(&schema);
+        attributes[j].AttributeType = (DataTypes)ReadU32(&schema);
+
+        sections[j].Type = ReadU32(&footer);
+        sections[j].Encoding = ReadU32(&footer);
+        sections[j].Offset = ReadU64(&footer);
+        sections[j].Length = ReadU64(&footer);
+        sections[j].GroupOffsets = malloc(sizeof(uint64_t) * (groups ? groups : 1));
+        for (size_t g = 0; sections[j].GroupOffsets && g < groups; ++g) {
+            sections[j].GroupOffsets[g] = ReadU64(&footer);
+        }
+
+        ok = !schema.Failed && !footer.Failed && attributes[j].AttributeName &&
+             sections[j].Type == (uint32_t)attributes[j].AttributeType && sections[j].Type <= DT_STRING &&
+             EncodingFits(sections[j].Encoding, sections[j].Type) && sections[j].GroupOffsets &&
+             sections[j].Offset <= footerOffset &&
+             sections[j].Length <= footerOffset - sections[j].Offset;
+    }
+
+    Table *table = NULL;
+    if (ok) table = CreateTable(tableName, attributes, columnCount);
+
+    // Dictionary sections load as interned columns, which size their rows differently.
+    for (size_t j = 0; table && j < columnCount; ++j) {
+        if (sections[j].Encoding == ENCODING_DICT && !InternColumn(table, j)) {
+            FreeTable(table);
+            table = NULL;
+        }
+    }
+
+    // Mapping is best effort; files that cannot be mapped are read instead.
+    TableMapping *mapping = table && rowCount > 0 && !swap && MappedLoads ? MapTableFile(file, (size_t)size) : NULL;
+    if (mapping) {
+        if (!MapColumnSections(table, rowCount, sections, mapping)) {
+            FreeTable(table);
+            table = NULL;
+        }
+    } else if (table && !ReserveRows(table, rowCount)) {
+        FreeTable(table);
+        table = NULL;
+    } else if (table) {
+        table->RowCount = rowCount;
+        for (size_t j = 0; j < columnCount && table; ++j) {
+            if (!ReadColumnSection(table, j, file, &sections[j], swap)) {
+                FreeTable(table);
+                table = NULL;
+            }
+        }
+    }
+
+    // Zone maps are only taken as written when the byte order matches.
+    if (table) {
+        if (groupRows == ZONE_ROWS && !swap && FILE_SEEK(file, zoneOffset, SEEK_SET) == 0) {
+            ReadZoneMaps(table, file);
+        } else {
+            RebuildZoneMaps(table);
+        }
+    }
+
+    if (!table) printf("Table file is damaged.\n");
+
+    for (size_t j = 0; attributes && j < columnCount; ++j) free(attributes[j].AttributeName);
+    for (size_t j = 0; sections && j < columnCount; ++j) free(sections[j].GroupOffsets);
+    free(attributes);
+    free(sections);
+    free(tableName);
+    free(schemaData);
+    free(footerData);
+
+    *fileBytes = (uint64_t)size;
+    return table;
+}
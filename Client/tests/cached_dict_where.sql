@@ -0,0 +1,17 @@
+-- Regression: a cached statement has to see values added to a DICT column after it was
+-- first run. Run with: client.exe tests/cached_dict_where.sql
+-- Each SELECT is run twice; the second run reuses the cached plan and must list the new rows.
+CREATE TABLE c (id INT, city DICT);
+INSERT INTO c VALUES (1, Paris);
+INSERT INTO c VALUES (2, Rome);
+
+SELECT * FROM c WHERE city > Paris;   -- Rome
+SELECT * FROM c WHERE city = Oslo;    -- no rows
+
+INSERT INTO c VALUES (3, Oslo);
+INSERT INTO c VALUES (4, Vienna);
+INSERT INTO c VALUES (5, Zurich);
+
+SELECT * FROM c WHERE city > Paris;   -- Rome, Vienna, Zurich
+SELECT * FROM c WHERE city = Oslo;    -- Oslo
+SELECT * FROM c WHERE id > 0 AND city = Oslo;   -- Oslo, uncached
@@ -0,0 +1,456 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+#include "functions.h"
+#include "database.h"
+
+// Write-ahead log kept next to a table file as data/<table>.wal. Changes made after the table
+// was loaded or saved are appended as logical records, so saving them costs I/O proportional
+// to the change; loading replays them on top of the .tbl and a checkpoint (a full save) folds
+// them in and starts an empty log.
+//
+//   header   magic "SDBWAL1\0", uint64 size of the base .tbl, uint64 hash of its last bytes
+//   records  uint32 payload length, uint32 FNV-1a checksum of the payload, payload
+//
+// A payload is one kind byte followed by its fields; strings are a uint32 length, the bytes
+// and a NUL. A torn record at the end (a crash mid-append) ends replay and is cut off.
+static const char LogMagic[8] = {'S', 'D', 'B', 'W', 'A', 'L', '1', '\0'};
+
+#define LOG_HEADER_BYTES    24
+#define LOG_TAIL_HASH_BYTES 4096
+// Batches of at least this many rows are treated as bulk changes rather than logged.
+#define LOG_BATCH_ROWS      256
+
+typedef enum {
+    LOG_INSERT = 1,
+    LOG_UPDATE,
+    LOG_DELETE,
+    LOG_ADD_COLUMN,
+    LOG_DROP_COLUMN,
+} LogRecordKind;
+
+struct TableLog {
+    char BasePath[256];
+    char Path[256];
+    FILE *File;             // opened on the first append
+    uint64_t BaseBytes;
+    uint64_t Bytes;         // size of the log file, header included
+    bool Replaying;
+    bool Broken;            // a change could not be logged, so only a full save keeps it
+};
+
+typedef struct {
+    unsigned char *Data;
+    size_t Size;
+    size_t Capacity;
+    bool Failed;
+} Record;
+
+static void PutBytes(Record *record, const void *data, size_t size) {
+    if (record->Failed) return;
+    if (record->Capacity - record->Size < size) {
+        size_t capacity = record->Capacity ? record->Capacity : 256;
+        while (capacity - record->Size < size) capacity *= 2;
+        unsigned char *grown = realloc(record->Data, capacity);
+        if (!grown) {
+            record->Failed = true;
+            return;
+        }
+        record->Data = grown;
+        record->Capacity = capacity;
+    }
+    memcpy(record->Data + record->Size, data, size);
+    record->Size += size;
+}
+
+static void PutU32(Record *record, uint32_t value) {
+    PutBytes(record, &value, sizeof(value));
+}
+
+static void PutString(Record *record, const char *str) {
+    uint32_t len = (uint32_t)strlen(str);
+    PutU32(record, len);
+    PutBytes(record, str, (size_t)len + 1);
+}
+
+static uint32_t Checksum(const unsigned char *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+// Identifies the base file the log applies to: its size and a hash of its footer end.
+static bool BaseFingerprint(const char *path, uint64_t *size, uint64_t *hash) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    unsigned char tail[LOG_TAIL_HASH_BYTES];
+    FILE_SEEK(file, 0, SEEK_END);
+    int64_t end = FILE_TELL(file);
+    int64_t start = end > LOG_TAIL_HASH_BYTES ? end - LOG_TAIL_HASH_BYTES : 0;
+    FILE_SEEK(file, start, SEEK_SET);
+    size_t got = fread(tail, 1, (size_t)(end - start), file);
+    fclose(file);
+
+    *size = (uint64_t)end;
+    *hash = 14695981039346656037ull;
+    for (size_t i = 0; i < got; ++i) *hash = (*hash ^ tail[i]) * 1099511628211ull;
+    return got == (size_t)(end - start);
+}
+
+static void LogPathFor(const char *basePath, char *path, size_t size) {
+    size_t len = strlen(basePath);
+    if (len > 4 && strcmp(basePath + len - 4, ".tbl") == 0) {
+        snprintf(path, size, "%.*s.wal", (int)(len - 4), basePath);
+    } else {
+        snprintf(path, size, "%s.wal", basePath);
+    }
+}
+
+static TableLog *NewTableLog(const char *basePath, uint64_t baseBytes) {
+    TableLog *log = calloc(1, sizeof(TableLog));
+    if (!log) return NULL;
+    log->BaseBytes = baseBytes;
+    snprintf(log->BasePath, sizeof(log->BasePath), "%s", basePath);
+    LogPathFor(basePath, log->Path, sizeof(log->Path));
+    return log;
+}
+
+static bool OpenLogFile(TableLog *log) {
+    if (log->File) return true;
+
+    uint64_t baseBytes, baseHash;
+    if (!BaseFingerprint(log->BasePath, &baseBytes, &baseHash)) return false;
+
+    log->File = fopen(log->Path, "ab");
+    if (!log->File) return false;
+
+    FILE_SEEK(log->File, 0, SEEK_END);
+    log->Bytes = (uint64_t)FILE_TELL(log->File);
+    if (log->Bytes == 0) {
+        fwrite(LogMagic, sizeof(LogMagic), 1, log->File);
+        fwrite(&baseBytes, sizeof(uint64_t), 1, log->File);
+        fwrite(&baseHash, sizeof(uint64_t), 1, log->File);
+        log->Bytes = LOG_HEADER_BYTES;
+    }
+    return true;
+}
+
+// Appends one record and hands it to the OS; SyncTableLog makes it durable.
+static void AppendRecord(Table *table, Record *payload) {
+    TableLog *log = table->Log;
+    if (payload->Failed || !OpenLogFile(log)) {
+        printf("Failed to log change to '%s'; SAVE will write the whole table.\n", table->TableName);
+        log->Broken = true;
+        free(payload->Data);
+        return;
+    }
+
+    uint32_t header[2] = {(uint32_t)payload->Size, Checksum(payload->Data, payload->Size)};
+    bool ok = fwrite(header, sizeof(header), 1, log->File) == 1 &&
+              fwrite(payload->Data, 1, payload->Size, log->File) == payload->Size && fflush(log->File) == 0;
+    if (!ok) log->Broken = true;
+    log->Bytes += sizeof(header) + payload->Size;
+    free(payload->Data);
+}
+
+static bool Logging(const Table *table) {
+    return table->Log && !table->Log->Replaying && !table->Log->Broken;
+}
+
+// Bulk changes such as imports are not logged row by row; the next SAVE writes the whole
+// table instead, which costs less than logging every row would. Changes that stopped part
+// way are handled the same way, since replaying their record would apply them in full.
+void LogBulkChange(Table *table) {
+    if (Logging(table)) table->Log->Broken = true;
+}
+
+void LogInsertRow(Table *table, void **values) {
+    if (!Logging(table)) return;
+
+    Record record = {0};
+    unsigned char kind = LOG_INSERT;
+    PutBytes(&record, &kind, 1);
+    PutU32(&record, (uint32_t)table->AttributeCount);
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        if (table->Attributes[j].AttributeType == DT_STRING) {
+            PutString(&record, values[j]);
+        } else {
+            PutBytes(&record, values[j], sizeof(uint32_t));
+        }
+    }
+    AppendRecord(table, &record);
+}
+
+// Logs the rows [begin, end) appended by InsertRows from the cells they now hold.
+void LogInsertRows(Table *table, size_t begin, size_t end) {
+    if (!Logging(table)) return;
+    if (end - begin >= LOG_BATCH_ROWS) {
+        LogBulkChange(table);
+        return;
+    }
+
+    void **values = malloc(sizeof(void *) * (table->AttributeCount ? table->AttributeCount : 1));
+    if (!values) {
+        LogBulkChange(table);
+        return;
+    }
+    for (size_t i = begin; i < end && Logging(table); ++i) {
+        for (size_t j = 0; j < table->AttributeCount; ++j) values[j] = GetCell(table, j, i);
+        LogInsertRow(table, values);
+    }
+    free(values);
+}
+
+void LogUpdateRows(Table *table, const char *column, const char *value, const char *where) {
+    if (!Logging(table)) return;
+
+    Record record = {0};
+    unsigned char kind = LOG_UPDATE;
+    PutBytes(&record, &kind, 1);
+    PutString(&record, column);
+    PutString(&record, value);
+    PutString(&record, where);
+    AppendRecord(table, &record);
+}
+
+void LogDeleteRows(Table *table, const char *where) {
+    if (!Logging(table)) return;
+
+    Record record = {0};
+    unsigned char kind = LOG_DELETE;
+    PutBytes(&record, &kind, 1);
+    PutString(&record, where);
+    AppendRecord(table, &record);
+}
+
+void LogAddColumn(Table *table, const char *column, const char *type) {
+    if (!Logging(table)) return;
+
+    Record record = {0};
+    unsigned char kind = LOG_ADD_COLUMN;
+    PutBytes(&record, &kind, 1);
+    PutString(&record, column);
+    PutString(&record, type);
+    AppendRecord(table, &record);
+}
+
+void LogDropColumn(Table *table, const char *column) {
+    if (!Logging(table)) return;
+
+    Record record = {0};
+    unsigned char kind = LOG_DROP_COLUMN;
+    PutBytes(&record, &kind, 1);
+    PutString(&record, column);
+    AppendRecord(table, &record);
+}
+
+// Bounds-checked cursor over one record payload.
+typedef struct {
+    const unsigned char *Data;
+    size_t Size;
+    size_t Pos;
+    bool Failed;
+} Cursor;
+
+static const void *Take(Cursor *cursor, size_t size) {
+    if (cursor->Failed || cursor->Size - cursor->Pos < size) {
+        cursor->Failed = true;
+        return NULL;
+    }
+    const void *at = cursor->Data + cursor->Pos;
+    cursor->Pos += size;
+    return at;
+}
+
+static uint32_t TakeU32(Cursor *cursor) {
+    uint32_t value = 0;
+    const void *at = Take(cursor, sizeof(value));
+    if (at) memcpy(&value, at, sizeof(value));
+    return value;
+}
+
+static const char *TakeString(Cursor *cursor) {
+    uint32_t len = TakeU32(cursor);
+    const char *str = Take(cursor, (size_t)len + 1);
+    return str && str[len] == '\0' ? str : NULL;
+}
+
+static bool ReplayInsert(Table *table, Cursor *cursor) {
+    if (TakeU32(cursor) != table->AttributeCount) return false;
+
+    void **values = malloc(sizeof(void *) * (table->AttributeCount ? table->AttributeCount : 1));
+    uint32_t *numbers = malloc(sizeof(uint32_t) * (table->AttributeCount ? table->AttributeCount : 1));
+    bool ok = values && numbers;
+
+    for (size_t j = 0; ok && j < table->AttributeCount; ++j) {
+        if (table->Attributes[j].AttributeType == DT_STRING) {
+            values[j] = (void *)TakeString(cursor);
+            ok = values[j] != NULL;
+        } else {
+            numbers[j] = TakeU32(cursor);
+            values[j] = &numbers[j];
+            ok = !cursor->Failed;
+        }
+    }
+
+    ok = ok && InsertRow(table, values);
+    free(values);
+    free(numbers);
+    return ok;
+}
+
+static bool ReplayRecord(Table *table, const unsigned char *data, size_t size) {
+    Cursor cursor = {data + 1, size - 1, 0, false};
+    const char *column, *value, *where;
+
+    switch (data[0]) {
+        case LOG_INSERT:
+            return ReplayInsert(table, &cursor);
+        case LOG_UPDATE:
+            column = TakeString(&cursor);
+            value = TakeString(&cursor);
+            where = TakeString(&cursor);
+            if (!column || !value || !where) return false;
+            UpdateRows(table, column, value, where);
+            return true;
+        case LOG_DELETE:
+            where = TakeString(&cursor);
+            if (!where) return false;
+            DeleteRows(table, where);
+            return true;
+        case LOG_ADD_COLUMN:
+            column = TakeString(&cursor);
+            value = TakeString(&cursor);
+            return column && value && AlterAddColumn(table, column, value);
+        case LOG_DROP_COLUMN:
+            column = TakeString(&cursor);
+            return column && AlterDropColumn(table, column);
+        default:
+            return false;
+    }
+}
+
+// Starts logging changes to a table just loaded from basePath and replays the log left by
+// earlier sessions. A log written against another version of the base file is set aside.
+void OpenTableLog(Table *table, const char *basePath, uint64_t baseBytes) {
+    TableLog *log = NewTableLog(basePath, baseBytes);
+    if (!log) return;
+    table->Log = log;
+
+    FILE *file = fopen(log->Path, "rb");
+    if (!file) return;
+
+    FILE_SEEK(file, 0, SEEK_END);
+    int64_t size = FILE_TELL(file);
+    FILE_SEEK(file, 0, SEEK_SET);
+    unsigned char *data = malloc(size > 0 ? (size_t)size : 1);
+    bool read = data && fread(data, 1, (size_t)size, file) == (size_t)size;
+    fclose(file);
+
+    uint64_t fileBytes = 0, baseHash = 0, loggedBytes = 0, loggedHash = 0;
+    bool matches = read && size >= LOG_HEADER_BYTES && memcmp(data, LogMagic, sizeof(LogMagic)) == 0 &&
+                   BaseFingerprint(basePath, &fileBytes, &baseHash);
+    if (matches) {
+        memcpy(&loggedBytes, data + 8, sizeof(uint64_t));
+        memcpy(&loggedHash, data + 16, sizeof(uint64_t));
+        matches = loggedBytes == fileBytes && loggedHash == baseHash;
+    }
+    if (!matches) {
+        if (read) {
+            printf("Ignoring '%s': it was written for a different version of the table.\n", log->Path);
+            remove(log->Path);
+        }
+        free(data);
+        return;
+    }
+
+    size_t pos = LOG_HEADER_BYTES, replayed = 0;
+    log->Replaying = true;
+    while ((size_t)size - pos >= 2 * sizeof(uint32_t)) {
+        uint32_t header[2];
+        memcpy(header, data + pos, sizeof(header));
+        size_t payload = header[0];
+        if (payload == 0 || (size_t)size - pos - sizeof(header) < payload ||
+            Checksum(data + pos + sizeof(header), payload) != header[1]) {
+            break;
+        }
+        if (!ReplayRecord(table, data + pos + sizeof(header), payload)) {
+            printf("Stopped replaying '%s' at a record that no longer applies.\n", log->Path);
+            break;
+        }
+        pos += sizeof(header) + payload;
+        replayed++;
+    }
+    log->Replaying = false;
+
+    // Drop whatever follows the last good record so new records are appended after it.
+    if (pos < (size_t)size) {
+        FILE *rewrite = fopen(log->Path, "wb");
+        if (rewrite) {
+            fwrite(data, 1, pos, rewrite);
+            fclose(rewrite);
+        }
+    }
+    free(data);
+
+    log->Bytes = pos;
+    if (replayed > 0) printf("Replayed %zu logged changes to '%s'.\n", replayed, table->TableName);
+}
+
+// Makes every logged change durable. Returns false if the log cannot stand in for a full
+// save, in which case the caller writes the table instead.
+bool SyncTableLog(Table *table) {
+    TableLog *log = table->Log;
+    if (!log || log->Broken) return false;
+    if (!log->File) return true;
+
+    if (fflush(log->File) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(log->File)) == 0;
+#else
+    return fsync(fileno(log->File)) == 0;
+#endif
+}
+
+// Bytes of changes waiting in the log and the size of the table file they apply to.
+void GetTableLogSize(const Table *table, uint64_t *logBytes, uint64_t *baseBytes) {
+    TableLog *log = table->Log;
+    *logBytes = log && log->Bytes > LOG_HEADER_BYTES ? log->Bytes - LOG_HEADER_BYTES : 0;
+    *baseBytes = log ? log->BaseBytes : 0;
+}
+
+void CloseTableLog(Table *table) {
+    if (!table->Log) return;
+    if (table->Log->File) fclose(table->Log->File);
+    free(table->Log);
+    table->Log = NULL;
+}
+
+// Called once the whole table has been written to basePath: the old log is folded in, so it
+// is removed and an empty one started for the new file.
+void ResetTableLog(Table *table, const char *basePath, uint64_t baseBytes) {
+    if (table->Log) {
+        if (table->Log->File) fclose(table->Log->File);
+        remove(table->Log->Path);
+        free(table->Log);
+    }
+
+    table->Log = NewTableLog(basePath, baseBytes);
+    if (table->Log) remove(table->Log->Path);
+}
+
+void RemoveTableLog(const char *tableName) {
+    char path[256];
+    snprintf(path, sizeof(path), "data/%s.wal", tableName);
+    remove(path);
+}
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "functions.h"
+#include "database.h"
+
+// Trailer appended to .tbl files after the rows. Readers that stop after the rows never see
+// it, and files without it get their zone maps rebuilt on load.
+static const char ZoneMagic[8] = {'S', 'D', 'B', 'Z', 'O', 'N', 'E', '1'};
+
+static size_t GroupCount(size_t rows) {
+    return (rows + ZONE_ROWS - 1) / ZONE_ROWS;
+}
+
+static uint64_t CellKey(const Table *table, size_t col, size_t row) {
+    return EncodeIndexKey(table->Attributes[col].AttributeType, GetCell(table, col, row));
+}
+
+static void AppendCell(Table *table, size_t col, size_t row) {
+    ZoneMap *zone = &table->Columns[col].Zones[row / ZONE_ROWS];
+    uint64_t key = CellKey(table, col, row);
+
+    if (row % ZONE_ROWS == 0) {
+        zone->Min = zone->Max = key;
+        return;
+    }
+    if (key < zone->Min) zone->Min = key;
+    if (key > zone->Max) zone->Max = key;
+}
+
+// Covers a newly appended row; the first row of a group starts it afresh, so appends keep
+// the maps tight.
+void ZoneMapAppendRow(Table *table, size_t row) {
+    for (size_t j = 0; j < table->AttributeCount; ++j) AppendCell(table, j, row);
+}
+
+// Covers the appended rows [begin, end) a column at a time.
+void ZoneMapAppendRows(Table *table, size_t begin, size_t end) {
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        for (size_t i = begin; i < end; ++i) AppendCell(table, j, i);
+    }
+}
+
+// Widens the cell's group to its new value. Groups never shrink on update, so they stay
+// correct but may loosen until the next rebuild.
+void ZoneMapUpdateCell(Table *table, size_t col, size_t row) {
+    ZoneMap *zone = &table->Columns[col].Zones[row / ZONE_ROWS];
+    uint64_t key = CellKey(table, col, row);
+    if (key < zone->Min) zone->Min = key;
+    if (key > zone->Max) zone->Max = key;
+}
+
+void RebuildColumnZoneMap(Table *table, size_t col) {
+    for (size_t i = 0; i < table->RowCount; ++i) AppendCell(table, col, i);
+}
+
+// Tightens every group; tombstoned rows still count until the table is compacted.
+void RebuildZoneMaps(Table *table) {
+    for (size_t j = 0; j < table->AttributeCount; ++j) RebuildColumnZoneMap(table, j);
+}
+
+// Whether any row of the group could satisfy the predicate. INT, UINT and FLOAT keys are
+// exact; string keys are 8-byte prefixes, so strings sharing the literal's prefix always
+// have to be looked at.
+static bool GroupMayMatch(const Predicate *pred, const ZoneMap *zone) {
+    uint64_t key = pred->Key;
+    bool exact = pred->Type != DT_STRING;
+
+    switch (pred->Op) {
+        case OP_EQ: return key >= zone->Min && key <= zone->Max;
+        case OP_NEQ: return !exact || zone->Min != key || zone->Max != key;
+        case OP_GT: return exact ? zone->Max > key : zone->Max >= key;
+        case OP_GTE: return zone->Max >= key;
+        case OP_LT: return exact ? zone->Min < key : zone->Min <= key;
+        case OP_LTE: return zone->Min <= key;
+        default: return true;
+    }
+}
+
+// Whether rows in [begin, end) could satisfy the predicate, judged by their groups.
+bool ZonesMayMatch(const Predicate *pred, const Table *table, size_t begin, size_t end) {
+    if (!pred->Zoned || begin >= end) return true;
+
+    const ZoneMap *zones = table->Columns[pred->Column].Zones;
+    for (size_t group = begin / ZONE_ROWS; group <= (end - 1) / ZONE_ROWS; ++group) {
+        if (GroupMayMatch(pred, &zones[group])) return true;
+    }
+    return false;
+}
+
+// Prepares a compiled predicate for zone checks. NaN compares unequal to everything, which
+// min/max cannot express, so NaN literals are never used to skip.
+void ZoneMapPreparePredicate(Predicate *pred) {
+    const void *literal = pred->Type == DT_STRING ? (const void *)pred->Literal.String : (const void *)&pred->Literal;
+    pred->Zoned = !(pred->Type == DT_FLOAT && isnan(pred->Literal.Float));
+    pred->Key = pred->Zoned ? EncodeIndexKey(pred->Type, literal) : 0;
+}
+
+void WriteZoneMaps(const Table *table, FILE *file) {
+    uint64_t zoneRows = ZONE_ROWS, groups = GroupCount(table->RowCount);
+
+    fwrite(ZoneMagic, sizeof(ZoneMagic), 1, file);
+    fwrite(&zoneRows, sizeof(uint64_t), 1, file);
+    fwrite(&groups, sizeof(uint64_t), 1, file);
+    for (size_t j = 0; j < table->AttributeCount; ++j) {
+        fwrite(table->Columns[j].Zones, sizeof(ZoneMap), groups, file);
+    }
+}
+
+// Reads the trailer written by WriteZoneMaps if the file has one that fits the table;
+// otherwise the maps are rebuilt from the rows. The file is left after the trailer, or
+// where it was if there is none.
+void ReadZoneMaps(Table *table, FILE *file) {
+    int64_t start = FILE_TELL(file);
+    char magic[sizeof(ZoneMagic)];
+    uint64_t zoneRows = 0, groups = 0;
+
+    bool ok = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, ZoneMagic, sizeof(magic)) == 0 &&
+              fread(&zoneRows, sizeof(uint64_t), 1, file) == 1 && fread(&groups, sizeof(uint64_t), 1, file) == 1 &&
+              zoneRows == ZONE_ROWS && groups == GroupCount(table->RowCount);
+
+    for (size_t j = 0; ok && j < table->AttributeCount; ++j) {
+        ok = fread(table->Columns[j].Zones, sizeof(ZoneMap), groups, file) == groups;
+    }
+
+    if (!ok) {
+        FILE_SEEK(file, start, SEEK_SET);
+        RebuildZoneMaps(table);
+    }
+}